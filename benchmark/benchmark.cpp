@@ -0,0 +1,442 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <json.hpp>
+#include <numeric>
+#include <omp.h>
+#include <optional>
+#include <random>
+
+#include "../utils/utils.h"
+#include "../sequential/maze/maze_generation.h"
+#include "../sequential/maze/maze_solving.h"
+#include "../parallel/maze/maze_generation.h"
+#include "../parallel/maze/maze_solving.h"
+
+
+// ENUMS AND STRUCTS
+
+/// Settings shared by all the measurements.
+struct BenchmarkSettings {
+    int warmups;
+    int repetitions;
+    int particle_steps;
+    int max_exit_steps;
+    int generation_tiles;
+    long generation_seed;
+    long solution_seed;
+};
+
+
+/// A maze carved once for each size, on which the particles' stages are measured.
+struct BenchmarkMaze {
+    int size;
+    std::vector<int> exit_coords;
+    Maze maze;
+    MoveTable move_table;
+    Coordinates start;
+};
+
+
+/// State of the particles at the moment in which the first one exits, used in order to measure the backtracking.
+template<typename ParticlesLayout>
+struct ExitSnapshot {
+    ParticlesLayout particles;
+    int exited_particle_index;
+    std::vector<Coordinates> exited_particle_path;
+    std::vector<MOVES> exited_particle_moves;
+    Maze solved_maze;
+};
+
+
+// PROTOTYPES
+BenchmarkMaze carve_benchmark_maze(int size, const BenchmarkSettings &settings);
+void benchmark_generation(nlohmann::json &results, const BenchmarkMaze &bench_maze, const std::vector<int> &thread_counts, const BenchmarkSettings &settings);
+void benchmark_sequential_solution(nlohmann::json &results, BenchmarkMaze &bench_maze, int n_particles, const BenchmarkSettings &settings);
+void benchmark_parallel_solution(nlohmann::json &results, BenchmarkMaze &bench_maze, int n_particles, const std::vector<int> &thread_counts, const BenchmarkSettings &settings);
+void benchmark_rendering(nlohmann::json &results, BenchmarkMaze &bench_maze, const std::vector<int> &thread_counts, const BenchmarkSettings &settings);
+nlohmann::json measure(const std::string &stage, const std::string &version, int size, int n_particles, int n_threads, const BenchmarkSettings &settings, const std::function<void()> &setup, const std::function<void()> &run);
+template<typename ParticlesLayout> void mark_solution(ExitSnapshot<ParticlesLayout> &snapshot, const BenchmarkMaze &bench_maze);
+
+
+// FUNCTIONS
+
+/**
+ * Measures each stage of the generation and of the solution in isolation, for both the versions.
+ *
+ * The sizes, the particles and the threads listed in "config/benchmark.json" are swept, and each stage is run a few
+ * times without being measured before its repetitions. The timings are printed and written as json into the
+ * "results/benchmarks" folder, so that they can be compared between two builds.
+ */
+int main() {
+    std::cout << std::endl << "[ Random Maze Solver - Benchmarks ]" << std::endl << std::endl;
+
+    // Retrieving the project's folder
+    std::filesystem::path project_folder = find_project_path();
+    if(project_folder.empty()) {
+        std::cout << "Unable to locate the project's folder!";
+        exit(1);
+    }
+
+    nlohmann::json config = parse_configuration(project_folder, "benchmark.json");
+    std::vector<int> sizes = config["sizes"];
+    std::vector<int> particle_counts = config["particle_counts"];
+    std::vector<int> thread_counts = config["thread_counts"];
+    BenchmarkSettings settings {};
+    settings.warmups = config["warmups"];
+    settings.repetitions = std::max(config["repetitions"].get<int>(), 1);
+    settings.particle_steps = config["particle_steps"];
+    settings.max_exit_steps = config["max_exit_steps"];
+    settings.generation_tiles = config["generation_tiles"];
+    settings.generation_seed = config["generation_seed"];
+    settings.solution_seed = config["solution_seed"];
+
+    nlohmann::json results = nlohmann::json::array();
+    for(int size : sizes) {
+        // Only valid sizes can be carved
+        if(size % 2 == 0 || size < 5) {
+            std::cout << "Skipping the invalid size " << size << std::endl;
+            continue;
+        }
+
+        BenchmarkMaze bench_maze = carve_benchmark_maze(size, settings);
+        benchmark_generation(results, bench_maze, thread_counts, settings);
+        benchmark_rendering(results, bench_maze, thread_counts, settings);
+        for(int n_particles : particle_counts) {
+            benchmark_sequential_solution(results, bench_maze, n_particles, settings);
+            benchmark_parallel_solution(results, bench_maze, n_particles, thread_counts, settings);
+        }
+    }
+
+    // The renderer is parallelized only above its threshold, which the sizes above might not reach. These sizes are
+    // only rendered, since their solutions would take too long
+    std::vector<int> render_sizes;
+    if(config.contains("render_sizes")) {
+        render_sizes = config["render_sizes"].get<std::vector<int>>();
+    }
+    for(int size : render_sizes) {
+        if(size % 2 == 0 || size < 5) {
+            std::cout << "Skipping the invalid size " << size << std::endl;
+            continue;
+        }
+
+        BenchmarkMaze bench_maze = carve_benchmark_maze(size, settings);
+        benchmark_rendering(results, bench_maze, thread_counts, settings);
+    }
+
+    // Saving the report
+    std::filesystem::path benchmarks_path = project_folder / "results" / "benchmarks";
+    std::filesystem::create_directories(benchmarks_path);
+    std::time_t now = std::time(nullptr);
+    char buf[256] = { 0 };
+    std::strftime(buf, sizeof(buf), "%y-%m-%dT%H:%M:%S", std::localtime(&now));
+    std::filesystem::path report_path = benchmarks_path / ("benchmark_" + std::string(buf) + ".json");
+
+    nlohmann::json report;
+    report["configuration"] = config;
+    report["max_threads"] = omp_get_num_procs();
+    report["results"] = results;
+    std::ofstream report_file(report_path);
+    report_file << report.dump(2) << std::endl;
+    report_file.close();
+
+    std::cout << std::endl << "Benchmarks saved into " << report_path << std::endl;
+    return 0;
+}
+
+
+/**
+ * Carves the maze used by the solution's stages of a given size, with the sequential generation.
+ *
+ * @param size This value represents each maze's side size.
+ * @param settings These are the benchmarks' settings.
+ * @return the maze, its move table and the particles' spawn position.
+ */
+BenchmarkMaze carve_benchmark_maze(int size, const BenchmarkSettings &settings) {
+    BenchmarkMaze bench_maze;
+    bench_maze.size = size;
+
+    std::mt19937 generation_rng(settings.generation_seed);
+    bench_maze.exit_coords = get_exit_coords(bench_maze.size, generation_rng);
+    initialize_maze(bench_maze.maze, bench_maze.size, bench_maze.exit_coords);
+    generate_paths(bench_maze.maze, bench_maze.size, bench_maze.exit_coords, generation_rng, false);
+    bench_maze.move_table.build(bench_maze.maze);
+
+    // The spawn position is chosen as the solvers do
+    std::mt19937 solution_rng(settings.solution_seed);
+    std::uniform_int_distribution<int> uniform_dist(size / 6, 5 * size / 6);
+    bench_maze.start = Coordinates(uniform_dist(solution_rng), uniform_dist(solution_rng));
+    while(bench_maze.maze(bench_maze.start.row, bench_maze.start.col) != MAZE_PATH::EMPTY)
+        bench_maze.start = Coordinates(uniform_dist(solution_rng), uniform_dist(solution_rng));
+
+    return bench_maze;
+}
+
+
+/**
+ * Measures the initialization of the maze, the depth first carving and the query of the unvisited cells nearby.
+ *
+ * The parallel initialization and the tiled carving are measured with each number of threads, while the stages that
+ * run on a single thread are measured once.
+ * @param results This is the array that receives the measurements.
+ * @param bench_maze This is the carved maze of the current size.
+ * @param thread_counts These are the numbers of threads to measure the parallel stages with.
+ * @param settings These are the benchmarks' settings.
+ */
+void benchmark_generation(nlohmann::json &results, const BenchmarkMaze &bench_maze, const std::vector<int> &thread_counts, const BenchmarkSettings &settings) {
+    int size = bench_maze.size;
+    std::vector<int> exit_coords = bench_maze.exit_coords;
+    Maze maze;
+    std::mt19937 generation_rng;
+    // Kept between the repetitions, as the executions do
+    GeneratorContext generator_context;
+
+    results.push_back(measure("initialize_maze", "sequential", size, 0, 1, settings, [] {}, [&] {
+        initialize_maze(maze, size, exit_coords);
+    }));
+    for(int n_threads : thread_counts) {
+        results.push_back(measure("initialize_maze", "parallel", size, 0, n_threads, settings, [] {}, [&] {
+            p_initialize_maze(maze, size, exit_coords, n_threads);
+        }));
+    }
+
+    auto prepare_carving = [&] {
+        initialize_maze(maze, size, exit_coords);
+        generation_rng.seed(settings.generation_seed);
+    };
+    results.push_back(measure("carve_paths", "sequential", size, 0, 1, settings, prepare_carving, [&] {
+        generate_paths(maze, size, exit_coords, generation_rng, false);
+    }));
+    results.push_back(measure("carve_paths", "parallel", size, 0, 1, settings, prepare_carving, [&] {
+        p_generate_paths(maze, size, exit_coords, generation_rng, generator_context);
+    }));
+    int n_tiles_side = std::clamp(settings.generation_tiles, 1, size / 2);
+    for(int n_threads : thread_counts) {
+        results.push_back(measure("carve_tiled_paths", "parallel", size, 0, n_threads, settings, prepare_carving, [&] {
+            p_generate_tiled_paths(maze, size, n_tiles_side, generation_rng, n_threads, generator_context);
+        }));
+    }
+
+    // Every node is queried once, none of them has been visited
+    Maze carved_maze = bench_maze.maze;
+    std::vector<bool> visited_cells(static_cast<size_t>(carved_maze.stride()) * carved_maze.stride(), false);
+    volatile int n_near_cells = 0;
+    auto query_all_nodes = [&](auto query) {
+        int near_cells[4];
+        int total = 0;
+        for(int row = 1; row < size; row += 2)
+            for(int col = 1; col < size; col += 2)
+                total += query(carved_maze, carved_maze.index(row, col), visited_cells, near_cells, false);
+        n_near_cells = total;
+    };
+    results.push_back(measure("unvisited_near_cells", "sequential", size, 0, 1, settings, [] {}, [&] {
+        query_all_nodes(get_unvisited_near_cells);
+    }));
+    results.push_back(measure("unvisited_near_cells", "parallel", size, 0, 1, settings, [] {}, [&] {
+        query_all_nodes(p_get_unvisited_near_cells);
+    }));
+}
+
+
+/**
+ * Measures the rendering of the maze's ascii image.
+ *
+ * Both the versions share the same renderer, which is parallelized only for big mazes. Below its threshold the
+ * renderer never forks, so it is measured once as the sequential version, whatever the threads.
+ * @param results This is the array that receives the measurements.
+ * @param bench_maze This is the carved maze of the current size.
+ * @param thread_counts These are the numbers of threads to measure the renderer with.
+ * @param settings These are the benchmarks' settings.
+ */
+void benchmark_rendering(nlohmann::json &results, BenchmarkMaze &bench_maze, const std::vector<int> &thread_counts, const BenchmarkSettings &settings) {
+    volatile size_t image_length = 0;
+    auto render = [&] {
+        image_length = generate_ascii_maze(bench_maze.maze, bench_maze.size).size();
+    };
+    if(!render_in_parallel(bench_maze.size)) {
+        results.push_back(measure("generate_ascii_maze", "sequential", bench_maze.size, 0, 1, settings, [] {}, render));
+        return;
+    }
+    for(int n_threads : thread_counts)
+        results.push_back(measure("generate_ascii_maze", n_threads == 1 ? "sequential" : "parallel", bench_maze.size, 0, n_threads, settings, [] {}, render));
+}
+
+
+/**
+ * Measures the particles' steps and the backtracking of the sequential version.
+ *
+ * The backtracking starts from the moment in which the first particle exits. That state is reached once, and each
+ * repetition backtracks a copy of it.
+ * @param results This is the array that receives the measurements.
+ * @param bench_maze This is the carved maze of the current size.
+ * @param n_particles This is the number of particles to spawn.
+ * @param settings These are the benchmarks' settings.
+ */
+void benchmark_sequential_solution(nlohmann::json &results, BenchmarkMaze &bench_maze, int n_particles, const BenchmarkSettings &settings) {
+    Philox4x32 movement_rng(settings.solution_seed);
+    Maze maze_copy;
+    std::vector<Particle> particles;
+    auto spawn_particles = [&] { particles.assign(n_particles, Particle(bench_maze.start)); };
+
+    nlohmann::json step_result = measure("particle_steps", "sequential", bench_maze.size, n_particles, 1, settings, spawn_particles, [&] {
+        for(int step = 0; step < settings.particle_steps; step++)
+            move_particles(bench_maze.maze, bench_maze.move_table, bench_maze.start, particles, movement_rng, step, maze_copy, false);
+    });
+    step_result["steps"] = settings.particle_steps;
+    results.push_back(step_result);
+
+    // Moves the particles until the first one exits
+    ExitSnapshot<std::vector<Particle>> snapshot {std::vector<Particle>(n_particles, Particle(bench_maze.start)), -1, {}, {}, {}};
+    for(int step = 0; step < settings.max_exit_steps && snapshot.exited_particle_index < 0; step++)
+        snapshot.exited_particle_index = move_particles(bench_maze.maze, bench_maze.move_table, bench_maze.start, snapshot.particles, movement_rng, step, maze_copy, false);
+    if(snapshot.exited_particle_index < 0) {
+        std::cout << "No particle has exited the maze of size " << bench_maze.size << " within " << settings.max_exit_steps << " steps, the sequential backtracking is skipped" << std::endl;
+        return;
+    }
+    snapshot.exited_particle_path = snapshot.particles[snapshot.exited_particle_index].path;
+    mark_solution(snapshot, bench_maze);
+
+    // The stages are measured on their own, so their phases' timings are discarded
+    PhaseTimings timings;
+    auto restore_particles = [&] { particles = snapshot.particles; };
+    results.push_back(measure("backtrack_exited_particle", "sequential", bench_maze.size, n_particles, 1, settings, restore_particles, [&] {
+        backtrack_exited_particle(snapshot.solved_maze, maze_copy, bench_maze.start, bench_maze.size, particles, snapshot.exited_particle_path, snapshot.exited_particle_index, false, timings);
+    }));
+    results.push_back(measure("fast_forward_exited_particle", "sequential", bench_maze.size, n_particles, 1, settings, restore_particles, [&] {
+        fast_forward_exited_particle(snapshot.solved_maze, particles, snapshot.exited_particle_path, snapshot.exited_particle_index);
+    }));
+}
+
+
+/**
+ * Measures the particles' steps and the backtracking of the parallel version, with each number of threads.
+ *
+ * The backtracking only pops the paths' stacks, so the moves stored into the arena are left untouched and each
+ * repetition can start from a copy of the particles at the moment in which the first one exits.
+ * @param results This is the array that receives the measurements.
+ * @param bench_maze This is the carved maze of the current size.
+ * @param n_particles This is the number of particles to spawn.
+ * @param thread_counts These are the numbers of threads to measure the stages with.
+ * @param settings These are the benchmarks' settings.
+ */
+void benchmark_parallel_solution(nlohmann::json &results, BenchmarkMaze &bench_maze, int n_particles, const std::vector<int> &thread_counts, const BenchmarkSettings &settings) {
+    Philox4x32 movement_rng(settings.solution_seed);
+    MoveStackArena paths_arena;
+    WalkBuffers walk_buffers;
+    std::optional<Particles> particles;
+    auto spawn_particles = [&] {
+        paths_arena.reset();
+        particles.emplace(n_particles, paths_arena);
+        particles->reset(n_particles, bench_maze.start);
+    };
+
+    // The walk stops earlier if a particle exits within the given steps
+    for(int n_threads : thread_counts) {
+        nlohmann::json step_result = measure("particle_steps", "parallel", bench_maze.size, n_particles, n_threads, settings, spawn_particles, [&] {
+            p_walk_particles(bench_maze.move_table, *particles, movement_rng, settings.particle_steps, n_threads, walk_buffers, nullptr);
+        });
+        step_result["steps"] = settings.particle_steps;
+        results.push_back(step_result);
+    }
+
+    // Moves the particles until the first one exits
+    spawn_particles();
+    int exited_particle_index = p_walk_particles(bench_maze.move_table, *particles, movement_rng, settings.max_exit_steps, omp_get_max_threads(), walk_buffers, nullptr);
+    if(exited_particle_index == INT_MAX) {
+        std::cout << "No particle has exited the maze of size " << bench_maze.size << " within " << settings.max_exit_steps << " steps, the parallel backtracking is skipped" << std::endl;
+        return;
+    }
+    ExitSnapshot<Particles> snapshot {*particles, exited_particle_index, {}, {}, {}};
+    snapshot.exited_particle_path = snapshot.particles.path_coordinates(exited_particle_index);
+    snapshot.exited_particle_moves = paths_arena.moves(snapshot.particles.paths[exited_particle_index]);
+    mark_solution(snapshot, bench_maze);
+
+    PhaseTimings timings;
+    BacktrackBuffers buffers;
+    auto restore_particles = [&] { particles.emplace(snapshot.particles); };
+    for(int n_threads : thread_counts) {
+        results.push_back(measure("backtrack_exited_particle", "parallel", bench_maze.size, n_particles, n_threads, settings, restore_particles, [&] {
+            p_backtrack_exited_particle(snapshot.solved_maze, *particles, snapshot.exited_particle_path, snapshot.exited_particle_moves, snapshot.exited_particle_index, false, n_threads, buffers, timings);
+        }));
+        results.push_back(measure("fast_forward_exited_particle", "parallel", bench_maze.size, n_particles, n_threads, settings, restore_particles, [&] {
+            p_fast_forward_exited_particle(*particles, snapshot.exited_particle_path, snapshot.exited_particle_moves, snapshot.exited_particle_index, n_threads, buffers);
+        }));
+    }
+}
+
+
+/**
+ * Marks the exited particle's path onto a copy of the maze, as the solvers do before backtracking.
+ *
+ * @param snapshot This is the state of the particles when the first one exits.
+ * @param bench_maze This is the carved maze of the current size.
+ */
+template<typename ParticlesLayout>
+void mark_solution(ExitSnapshot<ParticlesLayout> &snapshot, const BenchmarkMaze &bench_maze) {
+    snapshot.solved_maze = bench_maze.maze;
+    for(Coordinates coord : snapshot.exited_particle_path)
+        snapshot.solved_maze(coord.row, coord.col) = MAZE_PATH::SOLUTION;
+    snapshot.solved_maze(bench_maze.start.row, bench_maze.start.col) = MAZE_PATH::START;
+}
+
+
+/**
+ * Runs a stage many times and collects its timings.
+ *
+ * The setup is run before each repetition and it is not measured. The first repetitions are warmups, whose timings
+ * are discarded.
+ * @param stage This is the name of the stage.
+ * @param version This is the version the stage belongs to.
+ * @param size This value represents each maze's side size.
+ * @param n_particles This is the number of particles, 0 if the stage doesn't move any.
+ * @param n_threads This is the number of threads available to the stage.
+ * @param settings These are the benchmarks' settings.
+ * @param setup This prepares the stage's input.
+ * @param run This is the stage to measure.
+ * @return the measurement, with the minimum, median, mean and maximum milliseconds and all the samples.
+ */
+nlohmann::json measure(const std::string &stage, const std::string &version, int size, int n_particles, int n_threads, const BenchmarkSettings &settings, const std::function<void()> &setup, const std::function<void()> &run) {
+    omp_set_num_threads(n_threads);
+
+    std::vector<double> samples;
+    samples.reserve(settings.repetitions);
+    for(int repetition = 0; repetition < settings.warmups + settings.repetitions; repetition++) {
+        setup();
+        std::chrono::steady_clock::time_point start_ts = std::chrono::steady_clock::now();
+        run();
+        std::chrono::steady_clock::time_point end_ts = std::chrono::steady_clock::now();
+        if(repetition >= settings.warmups)
+            samples.push_back(std::chrono::duration<double, std::milli>(end_ts - start_ts).count());
+    }
+
+    std::vector<double> sorted_samples = samples;
+    std::sort(sorted_samples.begin(), sorted_samples.end());
+    size_t middle = sorted_samples.size() / 2;
+    double median = sorted_samples.size() % 2 ? sorted_samples[middle] : (sorted_samples[middle - 1] + sorted_samples[middle]) / 2;
+    double mean = std::accumulate(sorted_samples.begin(), sorted_samples.end(), 0.0) / static_cast<double>(sorted_samples.size());
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << stage << " [" << version << "] size: " << size << ", particles: " << n_particles << ", threads: " << n_threads
+              << " -> median " << median << " ms" << std::endl;
+
+    nlohmann::json result;
+    result["stage"] = stage;
+    result["version"] = version;
+    result["size"] = size;
+    result["n_particles"] = n_particles;
+    result["n_threads"] = n_threads;
+    result["warmups"] = settings.warmups;
+    result["repetitions"] = settings.repetitions;
+    result["min_ms"] = sorted_samples.front();
+    result["median_ms"] = median;
+    result["mean_ms"] = mean;
+    result["max_ms"] = sorted_samples.back();
+    result["samples_ms"] = samples;
+    return result;
+}
@@ -4,23 +4,30 @@
 #include <json.hpp>
 #include <random>
 #include <chrono>
+#include <climits>
 #include <fstream>
+#include <sstream>
+#include <omp.h>
 
 #include "utils/utils.h"
 #include "sequential/sequential_version.h"
 #include "parallel/parallel_version.h"
 #include "sequential/maze/maze_generation.h"
+#include "utils/maze/maze_file.h"
+#include "utils/results_writer.h"
+#include "utils/perf_counters.h"
+#include "utils/profiler.h"
+#include "parallel/thresholds.h"
 
 
 // PROTOTYPES
 std::mt19937 evaluate_seed(long seed, long &processed_seed, const std::string& operation);
 void process_size(int &size, std::mt19937 &rng);
-void save_results(std::filesystem::path &project_folder, bool is_sequential, long &generation_seed, long &solution_seed, float &elapsed_milliseconds, int n_particles, std::vector<std::vector<MAZE_PATH>> &maze, int &size);
-std::filesystem::path save_maze_image(std::filesystem::path &image_path, std::string &version, std::vector<std::vector<MAZE_PATH>> &maze, int &size, long solution_seed);
+ExecutionRecord save_results(bool is_sequential, long &generation_seed, long &solution_seed, float &elapsed_milliseconds, PhaseTimings &timings, PhaseCounters &counters, long n_particles, Maze &maze, const Coordinates &exit_coords, const SolutionOutcome &outcome, int &size, GENERATION_ALGORITHM algorithm);
 
 // GLOBAL VARIABLES
-int SIDE_MAX = 301;
-int SIDE_MIN = 51;
+// Upper bound for the randomly picked sizes, used when the configured one is not valid
+int SIDE_RANDOM_MAX = 301;
 
 
 // FUNCTIONS
@@ -43,7 +50,8 @@ int main() {
     int n_executions = config["n_executions"];
 
     // Retrieves the specified number of particles to generate
-    int n_particles = config["n_particles"];
+    // Only the aggregate simulation can spawn more of them than an int can hold
+    long n_particles = config["n_particles"];
 
     // Reads the specified size and try to use it to generate a corresponding maze
     int size = 0;
@@ -57,6 +65,155 @@ int main() {
         show_steps = config["show_steps"];
     }
 
+    // Checks if the outcome of the backtracking can be computed directly, instead of moving the particles step by step
+    // Used only when the steps are not shown
+    bool fast_forward = true;
+    if(config.contains("fast_forward")) {
+        fast_forward = config["fast_forward"];
+    }
+
+    // Checks if the parallel version must use the packed maze's representation, that requires a lot less memory
+    bool packed_maze = false;
+    if(config.contains("packed_maze")) {
+        packed_maze = config["packed_maze"];
+    }
+
+    // Checks if the parallel version must move the number of particles onto each cell, instead of each particle
+    // Its memory depends only on the maze's size, but the particles have no path to show nor to backtrack
+    bool aggregate_particles = false;
+    if(config.contains("aggregate_particles")) {
+        aggregate_particles = config["aggregate_particles"];
+    }
+    if(aggregate_particles && packed_maze) {
+        std::cout << "The aggregate simulation moves the particles onto the grid, the packed maze is not used" << std::endl;
+        packed_maze = false;
+    }
+    if(!aggregate_particles && n_particles > INT_MAX) {
+        std::cout << "Only the aggregate simulation can spawn more than " << INT_MAX << " particles!" << std::endl;
+        exit(1);
+    }
+
+    // Retrieves the number of tiles on each side of the maze, carved in parallel by the parallel version's generation
+    // A single tile generates the same maze of the sequential version
+    int generation_tiles = 1;
+    if(config.contains("generation_tiles")) {
+        generation_tiles = config["generation_tiles"];
+    }
+
+    // Checks if the parallel version must generate the maze one row at a time
+    bool streamed_generation = false;
+    if(config.contains("streamed_generation")) {
+        streamed_generation = config["streamed_generation"];
+    }
+
+    // Checks if the parallel version must generate the same mazes of the sequential one, so that it also finds the
+    // same solutions. The solutions don't depend on the number of threads, but the tiled and streamed generations do
+    // carve different mazes
+    bool deterministic_mode = false;
+    if(config.contains("deterministic_mode")) {
+        deterministic_mode = config["deterministic_mode"];
+    }
+    if(deterministic_mode && (generation_tiles > 1 || streamed_generation)) {
+        std::cout << "The deterministic mode generates the parallel version's mazes by a single visit" << std::endl;
+        generation_tiles = 1;
+        streamed_generation = false;
+    }
+
+    // Folder that receives the files of the streamed mazes. Each maze is written to its own file while it is generated
+    // and then solved from the file's mapping, by using the packed maze, so it never needs to fit into memory
+    std::filesystem::path streamed_maze_folder;
+    if(streamed_generation && config.contains("streamed_maze_folder") && !config["streamed_maze_folder"].get<std::string>().empty()) {
+        streamed_maze_folder = config["streamed_maze_folder"].get<std::string>();
+        if(streamed_maze_folder.is_relative())
+            streamed_maze_folder = project_folder / streamed_maze_folder;
+        std::error_code error;
+        std::filesystem::create_directories(streamed_maze_folder, error);
+        if(error) {
+            std::cout << "Unable to create the streamed mazes' folder " << streamed_maze_folder << ": " << error.message() << std::endl;
+            exit(1);
+        }
+        if(!packed_maze && !aggregate_particles) {
+            std::cout << "The streamed mazes are solved from their files by using the packed maze" << std::endl;
+            packed_maze = true;
+        }
+    }
+
+    // Checks if the mazes solved by the two versions in the same execution must be compared
+    bool verify_solutions = false;
+    if(config.contains("verify_solutions")) {
+        verify_solutions = config["verify_solutions"];
+    }
+
+    // Checks if the executions must run concurrently, in order to solve as many mazes as possible each second
+    // The steps can't be shown, since the executions would share the terminal
+    bool throughput_mode = false;
+    if(config.contains("throughput_mode")) {
+        throughput_mode = config["throughput_mode"];
+    }
+    if(throughput_mode && show_steps) {
+        std::cout << "The steps can't be shown in throughput mode" << std::endl;
+        show_steps = false;
+    }
+
+    // Checks if the parallel version's phases must be measured by the hardware and software counters too
+    // The counters follow the OpenMP's threads, which the concurrent executions share, so they would be counted along
+    // with the measured one
+    bool perf_counters = false;
+    if(config.contains("perf_counters")) {
+        perf_counters = config["perf_counters"];
+    }
+    if(perf_counters && throughput_mode) {
+        std::cout << "The performance counters can't be used in throughput mode" << std::endl;
+        perf_counters = false;
+    }
+    if(perf_counters && !perf_counters_supported()) {
+        std::cout << "The performance counters are not available on this host" << std::endl;
+        perf_counters = false;
+    }
+
+    // Reads the gperftools' profiling settings. The profiles are taken around the whole executions, or around the
+    // selected phases only ("generation", "random_walk" and "backtrack"), and they can be limited to some executions
+    ProfilingSettings profiling;
+    profiling.profiles_path = project_folder / "results" / "profiles";
+    if(config.contains("cpu_profiling")) {
+        profiling.cpu = config["cpu_profiling"];
+    }
+    if(config.contains("heap_profiling")) {
+        profiling.heap = config["heap_profiling"];
+    }
+    if(config.contains("profiled_phases")) {
+        profiling.phases = config["profiled_phases"].get<std::vector<std::string>>();
+    }
+    if(config.contains("profiled_executions")) {
+        profiling.executions = config["profiled_executions"].get<std::vector<int>>();
+    }
+    // When enabled, the profiling waits for SIGUSR1 and each signal pauses or resumes it
+    if(config.contains("profiling_signal")) {
+        profiling.signal_toggle = config["profiling_signal"];
+    }
+    configure_profiling(profiling);
+
+    // Checks if the parallelization's thresholds must be measured onto this host before the executions
+    // They are cached for each host into config/thresholds.json, so the next runs use them too
+    bool calibrate = false;
+    if(config.contains("calibrate_thresholds")) {
+        calibrate = config["calibrate_thresholds"];
+    }
+    std::filesystem::path thresholds_path = project_folder / "config" / "thresholds.json";
+    ParallelThresholds thresholds;
+    if(calibrate) {
+        thresholds = calibrate_thresholds();
+        save_thresholds(thresholds_path, thresholds);
+    }
+    if(thresholds.calibrated || load_thresholds(thresholds_path, thresholds))
+        print_thresholds(thresholds);
+    configure_thresholds(thresholds);
+
+    // The counters are opened only onto the OpenMP's threads, which are started and recorded here: they never exit and
+    // the phases reuse them, while the results writer's thread is left out
+    if(perf_counters)
+        record_perf_threads();
+
     // Search for a specific seed in the configuration
     // This allows to generate the same maze everytime. (other parameters like size, must remain the same too)
     long generation_seed = -1;
@@ -71,65 +228,241 @@ int main() {
         solution_seed = config["solution_seed"];
     }
 
-    // Initializing variables for timing checks
-    std::chrono::high_resolution_clock::time_point start_ts;
-    std::chrono::high_resolution_clock::time_point end_ts;
-    float elapsed_milliseconds;
+    // Checks if the mazes must be saved into binary files too, so that they can be solved again later
+    bool save_maze = false;
+    if(config.contains("save_maze_file")) {
+        save_maze = config["save_maze_file"];
+    }
 
-    // Initializes the variables that will hold the processed seeds
-    // Used to not alter the original seeds
-    long final_generation_seed;
-    long final_solution_seed;
+    // Format of the saved mazes' images. The binary ones are a lot smaller and faster to write than the ascii one
+    IMAGE_FORMAT image_format = IMAGE_FORMAT::TXT;
+    if(config.contains("image_format")) {
+        if(config["image_format"] == "pgm")
+            image_format = IMAGE_FORMAT::PGM;
+        else if(config["image_format"] == "pbm")
+            image_format = IMAGE_FORMAT::PBM;
+        else if(config["image_format"] == "none")
+            image_format = IMAGE_FORMAT::NO_IMAGE;
+    }
+
+    // Maximum number of executions whose results can wait to be written, while the next ones are running
+    // Each of them holds a whole maze into memory
+    int results_queue_size = 2;
+    if(config.contains("results_queue_size")) {
+        results_queue_size = config["results_queue_size"];
+    }
+
+    // Number of threads that render each big image in the background, while the next executions are running
+    // 0 uses all the available ones
+    int render_threads = 0;
+    if(config.contains("render_threads")) {
+        render_threads = config["render_threads"];
+    }
+
+    // Algorithm that generates the mazes of the parallel version
+    GENERATION_ALGORITHM parallel_algorithm = GENERATION_ALGORITHM::DEPTH_FIRST;
+    if(streamed_generation)
+        parallel_algorithm = GENERATION_ALGORITHM::ELLER;
+    else if(generation_tiles > 1 && !packed_maze)
+        parallel_algorithm = GENERATION_ALGORITHM::TILED_DEPTH_FIRST;
+
+    // Search for a maze file in the configuration
+    // If given, both the versions solve the maze it contains instead of generating a new one
+    MappedMazeFile maze_file;
+    PackedMaze loaded_maze;
+    Coordinates loaded_exit;
+    bool load_maze = config.contains("maze_file") && !config["maze_file"].get<std::string>().empty();
+    if(load_maze) {
+        std::filesystem::path maze_file_path = config["maze_file"].get<std::string>();
+        if(maze_file_path.is_relative())
+            maze_file_path = project_folder / maze_file_path;
+        if(!maze_file.open(maze_file_path, true))
+            exit(1);
+
+        // The maze is solved directly from the mapped file
+        maze_file.attach(loaded_maze);
+        size = maze_file.header().size;
+        generation_seed = maze_file.header().generation_seed;
+        loaded_exit = Coordinates(maze_file.header().exit_row, maze_file.header().exit_col);
+        std::cout << "Loaded the maze from " << maze_file_path << std::endl;
+    }
+
+    // The results are written in the background, while the next executions are running
+    ResultsWriter results_writer(project_folder, results_queue_size, save_maze, image_format, render_threads);
+
+    // Reads the versions to execute once, so that the executions never touch the configuration
+    bool execute_sequential = config["execute_sequential"];
+    bool execute_parallel = config["execute_parallel"];
+    if(aggregate_particles && execute_sequential) {
+        std::cout << "The sequential version moves each particle on its own, so it is skipped by the aggregate simulation" << std::endl;
+        execute_sequential = false;
+    }
+
+    // The solutions can be compared only if both the versions solve the same maze
+    bool compare_solutions = verify_solutions && execute_sequential && execute_parallel &&
+                             (load_maze || parallel_algorithm == GENERATION_ALGORITHM::DEPTH_FIRST);
+    if(verify_solutions && !compare_solutions)
+        std::cout << "The solutions are not verified, since the two versions don't solve the same mazes" << std::endl;
+
+    // The parallel version paints the solution into the maze's grid only if it is shown, saved or compared
+    // Otherwise the packed maze is solved without ever building the grid
+    bool paint_solution = show_steps || image_format != IMAGE_FORMAT::NO_IMAGE || save_maze || compare_solutions;
+
+    // The parallel version generates and solves the mazes into a context, whose memory is reused by the next executions
+    // Each thread has its own one, since in throughput mode the executions run concurrently
+    std::vector<SolverContext> solver_contexts(throughput_mode ? omp_get_max_threads() : 1);
 
     // Tests the 2 versions non-stop with the configuration seeds if given. Otherwise, a new pair of seeds is generated
     // at each iteration. But both the versions will share the seeds everytime so that the generated maze and solution
     // moves are the same.
-    for(int i = 0; i < n_executions; i++) {
+    // In throughput mode the executions are independent tasks, run concurrently by the threads' team. Each of them uses
+    // a single thread, so that many small mazes keep all the cores busy. Otherwise the executions run one after another,
+    // outside of any parallel region: their own regions would be nested into it, and each nested region creates a new
+    // team of threads instead of reusing the same one.
+    std::cout << std::fixed << std::setprecision(3);
+    auto run_execution = [&](int execution) {
+        // The progress of the concurrent executions is collected and printed at once when they end, so that their
+        // lines don't interleave
+        std::ostringstream execution_log;
+        if(throughput_mode) {
+            omp_set_num_threads(1);
+            execution_log << std::fixed << std::setprecision(3);
+            set_execution_output(&execution_log);
+        }
+
+        // Initializing variables for timing checks
+        std::chrono::high_resolution_clock::time_point start_ts;
+        std::chrono::high_resolution_clock::time_point end_ts;
+        float elapsed_milliseconds;
+        PhaseTimings timings;
+        PhaseCounters counters;
+        SolutionOutcome outcome;
+
+        // Initializes the variables that will hold the processed seeds
+        // Used to not alter the original seeds
+        long final_generation_seed;
+        long final_solution_seed;
+
         // Evaluating seeds
         std::mt19937 generation_rng = evaluate_seed(generation_seed, final_generation_seed, "generation");
         std::mt19937 solution_rng = evaluate_seed(solution_seed, final_solution_seed, "solution");
 
-        // Ensures the maze has an odd size and checks if the size is withing the allowed range
-        process_size(size, generation_rng);
-        std::cout << "Maze Size: [" << size << ", " << size << "]" << std::endl;
+        // The sequential version's results wait for the parallel ones when the solutions are compared
+        ExecutionRecord sequential_record {};
 
-        // Creates the maze matrix
-        std::vector<std::vector<MAZE_PATH>> maze;
-        maze.resize(size);
-        maze.reserve(size);
-        std::vector<std::vector<MAZE_PATH>> maze_with_solution;
+        // Ensures the maze has an odd size and checks if the size is withing the allowed range
+        int execution_size = size;
+        if(!load_maze)
+            process_size(execution_size, generation_rng);
+        execution_output() << "Maze Size: [" << execution_size << ", " << execution_size << "]" << std::endl;
 
         // SEQUENTIAL VERSION
-        if(config["execute_sequential"]) {
-            std::cout << "\n\nSEQUENTIAL VERSION:\n" << std::endl;
-            start_ts = std::chrono::high_resolution_clock::now();
-            maze_with_solution = sequential_solution(maze,size, n_particles, generation_rng, solution_rng, show_steps);
-            end_ts = std::chrono::high_resolution_clock::now();
+        if(execute_sequential) {
+            execution_output() << "\n\nSEQUENTIAL VERSION:\n" << std::endl;
+            // Creates the maze matrix
+            // Its memory is allocated by the generation itself
+            Maze maze;
+            Maze maze_with_solution;
+            std::vector<int> exit_coords;
+            timings = PhaseTimings();
+            outcome = SolutionOutcome();
+            {
+                // The profilers are started and stopped outside of the timed part
+                ExecutionProfile profile("sequential", final_generation_seed, final_solution_seed, execution);
+                start_ts = std::chrono::high_resolution_clock::now();
+                if(load_maze)
+                    maze_with_solution = sequential_solution(loaded_maze, execution_size, static_cast<int>(n_particles), solution_rng, show_steps, fast_forward, timings, outcome);
+                else
+                    maze_with_solution = sequential_solution(maze, execution_size, static_cast<int>(n_particles), generation_rng, solution_rng, show_steps, fast_forward, timings, outcome, exit_coords);
+                end_ts = std::chrono::high_resolution_clock::now();
+            }
             elapsed_milliseconds = duration_cast<std::chrono::microseconds>(end_ts-start_ts).count() / 1000.f;
-            std::cout << std::fixed << std::setprecision(3);
-            std::cout << "The execution took " << elapsed_milliseconds << " ms" << std::endl;
+            execution_output() << "The execution took " << elapsed_milliseconds << " ms" << std::endl;
 
-            save_results(project_folder, true, final_generation_seed, final_solution_seed, elapsed_milliseconds, n_particles, maze_with_solution, size);
+            sequential_record = save_results(true, final_generation_seed, final_solution_seed, elapsed_milliseconds, timings, counters, n_particles, maze_with_solution,
+                                             load_maze ? loaded_exit : Coordinates(exit_coords[0], exit_coords[1]), outcome, execution_size,
+                                             load_maze ? static_cast<GENERATION_ALGORITHM>(maze_file.header().algorithm) : GENERATION_ALGORITHM::DEPTH_FIRST);
+            if(!compare_solutions)
+                results_writer.submit(std::move(sequential_record));
 
-            std::cout << "-----------------------------------------------------------" << std::endl;
+            execution_output() << "-----------------------------------------------------------" << std::endl;
         }
 
         // PARALLEL VERSION
-        if(config["execute_parallel"]) {
-            std::cout << "\n\nPARALLEL VERSION:\n" << std::endl;
-            start_ts = std::chrono::high_resolution_clock::now();
-            maze_with_solution = parallel_solution(maze, size, n_particles, generation_rng, solution_rng, show_steps);
-            end_ts = std::chrono::high_resolution_clock::now();
+        if(execute_parallel) {
+            execution_output() << "\n\nPARALLEL VERSION:\n" << std::endl;
+            SolverContext &context = solver_contexts[throughput_mode ? omp_get_thread_num() : 0];
+            std::filesystem::path streamed_file_path;
+            if(!streamed_maze_folder.empty())
+                streamed_file_path = streamed_maze_folder / ("streamed_" + std::to_string(execution) + "_" + std::to_string(final_generation_seed) + ".rmz");
+            timings = PhaseTimings();
+            counters = PhaseCounters();
+            counters.enabled = perf_counters;
+            outcome = SolutionOutcome();
+            {
+                ExecutionProfile profile("parallel", final_generation_seed, final_solution_seed, execution);
+                start_ts = std::chrono::high_resolution_clock::now();
+                if(load_maze)
+                    parallel_solution(context, loaded_maze, execution_size, n_particles, solution_rng, show_steps, fast_forward, packed_maze, paint_solution, aggregate_particles, timings, counters, outcome);
+                else
+                    parallel_solution(context, execution_size, n_particles, generation_rng, solution_rng, show_steps, fast_forward, packed_maze, paint_solution, aggregate_particles, generation_tiles, streamed_generation, streamed_file_path, final_generation_seed, timings, counters, outcome);
+                end_ts = std::chrono::high_resolution_clock::now();
+            }
             elapsed_milliseconds = duration_cast<std::chrono::microseconds>(end_ts-start_ts).count() / 1000.f;
-            std::cout << std::fixed << std::setprecision(3);
-            std::cout << "The execution took " << elapsed_milliseconds << " ms" << std::endl;
+            execution_output() << "The execution took " << elapsed_milliseconds << " ms" << std::endl;
+
+            // The solved maze is handed to the writer, and replaced by one that has already been written
+            const std::vector<int> &exit_coords = context.generator.exit_coords;
+            ExecutionRecord parallel_record = save_results(false, final_generation_seed, final_solution_seed, elapsed_milliseconds, timings, counters, n_particles, context.solved_maze,
+                                                           load_maze ? loaded_exit : Coordinates(exit_coords[0], exit_coords[1]), outcome, execution_size,
+                                                           load_maze ? static_cast<GENERATION_ALGORITHM>(maze_file.header().algorithm) : parallel_algorithm);
+            context.solved_maze = results_writer.recycle_maze();
+
+            // Both the versions walk the particles with the same counter-based generator, so the same particle must exit
+            // in the same step, and the backtracking must take the same steps. The solved mazes are compared as well
+            if(compare_solutions) {
+                bool matching = sequential_record.outcome == parallel_record.outcome && sequential_record.maze == parallel_record.maze;
+                sequential_record.solution_check = parallel_record.solution_check = matching ? SOLUTION_CHECK::MATCHING : SOLUTION_CHECK::MISMATCHING;
+                if(matching)
+                    execution_output() << "The solutions of the two versions match" << std::endl;
+                else
+                    execution_output() << "WARNING: the solutions of the two versions differ!" << std::endl;
+                results_writer.submit(std::move(sequential_record));
+            }
+            results_writer.submit(std::move(parallel_record));
+        }
+
+        execution_output() << "###########################################################" << std::endl;
 
-            save_results(project_folder, false, final_generation_seed, final_solution_seed, elapsed_milliseconds, n_particles, maze_with_solution, size);
+        if(throughput_mode) {
+            set_execution_output(nullptr);
+            #pragma omp critical(execution_log)
+            std::cout << execution_log.str() << std::flush;
         }
+    };
+
+    std::chrono::high_resolution_clock::time_point throughput_start_ts = std::chrono::high_resolution_clock::now();
+    if(throughput_mode) {
+        #pragma omp parallel
+        #pragma omp single
+        for(int i = 0; i < n_executions; i++) {
+            #pragma omp task default(shared) firstprivate(i)
+            run_execution(i);
+        }
+    } else {
+        for(int i = 0; i < n_executions; i++)
+            run_execution(i);
+    }
 
-        std::cout << "###########################################################" << std::endl;
+    if(throughput_mode) {
+        float total_milliseconds = duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - throughput_start_ts).count() / 1000.f;
+        std::cout << n_executions << " executions completed in " << total_milliseconds << " ms ("
+                  << n_executions * 1000.f / total_milliseconds << " executions per second)" << std::endl;
     }
 
+    // Waits for the last results to be written
+    results_writer.close();
+
     return 0;
 }
 
@@ -150,9 +483,11 @@ std::mt19937 evaluate_seed(long seed, long &processed_seed, const std::string& o
     if(seed == -1) {
         std::random_device rd;
         processed_seed = rd();
+    } else {
+        processed_seed = seed;
     }
 
-    std::cout << "Current seed for " << operation << ": " << processed_seed << std::endl;
+    execution_output() << "Current seed for " << operation << ": " << processed_seed << std::endl;
 
     // Used to set a new seed everytime
     std::mt19937 rng(processed_seed); // Random-number engine used (Mersenne-Twister in this case)
@@ -172,11 +507,11 @@ std::mt19937 evaluate_seed(long seed, long &processed_seed, const std::string& o
 void process_size(int &size, std::mt19937 &rng) {
     // Ensures the maze has an odd size and checks if the size is withing the allowed range
     if(size % 2 == 0 || size < SIDE_MIN || size > SIDE_MAX) {
-        std::cout << "Invalid maze size specified. The values must be in [" << SIDE_MIN << ", " << SIDE_MAX << "]" << std::endl;
+        execution_output() << "Invalid maze size specified. The values must be in [" << SIDE_MIN << ", " << SIDE_MAX << "]" << std::endl;
         // Creates two uniform distributions based on a range and uses it to assign the random integers values
         // The value is based onto a random device "/dev/random".
         // This way a new unpredictable seed is used everytime
-        std::uniform_int_distribution<int> uniform_dist(SIDE_MIN, SIDE_MAX - 1); // Guaranteed unbiased
+        std::uniform_int_distribution<int> uniform_dist(SIDE_MIN, SIDE_RANDOM_MAX - 1); // Guaranteed unbiased
         size = uniform_dist(rng);
         // The maze must have an odd size
         while(size % 2 == 0)
@@ -186,80 +521,41 @@ void process_size(int &size, std::mt19937 &rng) {
 
 
 /**
- * Saves the juicy information related to the execution of the project.
+ * Collects the juicy information related to the execution of the project.
  *
  * This function helps to keep track of the records and the measurements taken in order to report and confront them
- * later on.
- * @param project_folder This is the root path of the current project.
+ * later on. The returned record is then handed to the writer, which saves it in the background.
  * @param is_sequential Flag used to tell if the current reported version is sequential or parallel.
  * @param generation_seed This is the seed that has been used for the maze's generation.
  * @param solution_seed This is the seed that has been used for the maze's solution.
  * @param elapsed_milliseconds This is the total elapsed milliseconds required to generate and solve the maze.
+ * @param timings These are the milliseconds spent into each phase of the execution.
+ * @param counters These are the performance counters of the execution's phases. Their samples are moved into the
+ * record.
  * @param n_particles This is the number of spawned particles.
- * @param maze This is the matrix that represents the maze's inner structure along with the solution path.
+ * @param maze This is the matrix that represents the maze's inner structure along with the solution path. It is moved
+ * into the record.
+ * @param exit_coords These are the coordinates of the maze's exit.
+ * @param outcome This is the outcome of the random walk and of the backtracking.
  * @param size This value represents each maze's side size.
+ * @param algorithm This is the algorithm that generated the maze.
+ * @return the record of the execution.
  */
-void save_results(std::filesystem::path &project_folder, bool is_sequential, long &generation_seed, long &solution_seed, float &elapsed_milliseconds, int n_particles, std::vector<std::vector<MAZE_PATH>> &maze, int &size) {
-    std::cout << "Saving the results.." << std::endl;
-
-    std::string version = is_sequential ? "sequential" : "parallel";
-
-    std::filesystem::path images_path = project_folder / "results" / "mazes";
-
-    // Creating the directories if they don't exist
-    if(!std::filesystem::is_directory(images_path) || !std::filesystem::exists(images_path))
-        std::filesystem::create_directories(images_path);
-
-    // Saving the maze's image
-    std::filesystem::path maze_image_path = save_maze_image(images_path, version, maze, size, solution_seed);
-
-    // Writing/appending to the report file
-    std::filesystem::path report_path = project_folder / "results" / "executions_report.csv";
-    std::ofstream report_file;
-    if(!std::filesystem::exists(report_path)) {
-        report_file.open(report_path.c_str(), std::fstream::app);
-        report_file << "version,elapsed_time,maze_size,n_particles,generation_seed,solution_seed,maze_image_path";
-    } else {
-        report_file.open(report_path.c_str(), std::fstream::app);
-    }
-
-    // Saves the current record
-    report_file << "\n" << version << "," << elapsed_milliseconds << "," << size << "," << n_particles << "," << generation_seed << "," << solution_seed << "," << maze_image_path;
-
-    // Closing the file
-    report_file.close();
+ExecutionRecord save_results(bool is_sequential, long &generation_seed, long &solution_seed, float &elapsed_milliseconds, PhaseTimings &timings, PhaseCounters &counters, long n_particles, Maze &maze, const Coordinates &exit_coords, const SolutionOutcome &outcome, int &size, GENERATION_ALGORITHM algorithm) {
+    execution_output() << "Saving the results.." << std::endl;
+
+    ExecutionRecord record {};
+    record.is_sequential = is_sequential;
+    record.generation_seed = generation_seed;
+    record.solution_seed = solution_seed;
+    record.elapsed_milliseconds = elapsed_milliseconds;
+    record.timings = timings;
+    record.counters = std::move(counters);
+    record.n_particles = n_particles;
+    record.size = size;
+    record.maze = std::move(maze);
+    record.exit_coords = exit_coords;
+    record.outcome = outcome;
+    record.algorithm = algorithm;
+    return record;
 }
-
-
-/**
- * Saves the current maze's ascii image to the disk.
- *
- * This function generates a file containing the maze's structure rendered with ascii character in order to
- * be able to visualize it later with it's solution path.
- * @param image_path This is the base location for maze's images.
- * @param version This string is used to tell if the current maze belongs to a sequential or parallel version.
- * @param maze This is the matrix that represents the maze's inner structure along with the solution path.
- * @param size This value represents each maze's side size.
- * @param solution_seed This value represents the seed used for the maze's solution. This is used here to ensure that
- * all mazes' images have different names as if mazes are generated and solved very fast, the timings might coincide.
- * @return `image_path`
- */
-std::filesystem::path save_maze_image(std::filesystem::path &image_path, std::string &version, std::vector<std::vector<MAZE_PATH>> &maze, int &size, long solution_seed) {
-    // Building the unique image path
-    std::time_t now = std::chrono::high_resolution_clock::to_time_t(std::chrono::high_resolution_clock::now());
-    char buf[256] = { 0 };
-    // ISO 8601 format for the timestamp
-    std::strftime(buf, sizeof(buf), "%y-%m-%dT%H:%M:%S", std::localtime(&now));
-    // Here the seed is added in order to avoid multiple images to have the same filename
-    image_path = image_path / (version + "_" + std::string(buf) + "_" + std::to_string(solution_seed) + ".txt");
-
-    // Generating the ascii maze image
-    std::string ascii_maze = generate_ascii_maze(maze, size);
-
-    // Saving the image to the disk
-    std::ofstream output_image(image_path.c_str());
-    output_image << ascii_maze;
-    output_image.close();
-
-    return image_path;
-}
\ No newline at end of file
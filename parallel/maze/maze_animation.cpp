@@ -0,0 +1,155 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#include <chrono>
+#include <iostream>
+#include "maze_animation.h"
+#include "../../utils/utils.h"
+
+
+// FUNCTIONS
+
+/**
+ * Draws the whole maze and starts the renderer's thread.
+ *
+ * @param background This is the matrix shown under the particles. It is copied, so it can be changed afterwards.
+ * @param frames_per_second This is the maximum number of frames drawn each second.
+ */
+MazeAnimator::MazeAnimator(const Maze &background, int frames_per_second) : background(background), shown(background), desired(background) {
+    this->frame_microseconds = 1000000 / std::max(frames_per_second, 1);
+
+    int size = this->background.size();
+    std::cout << "\x1B[2J\x1B[H" << generate_ascii_maze(this->shown, size) << std::flush;
+
+    this->renderer = std::thread(&MazeAnimator::run, this);
+}
+
+
+MazeAnimator::~MazeAnimator() {
+    if(this->renderer.joinable())
+        this->finish(nullptr, 0);
+}
+
+
+/**
+ * Hands the particles' positions over to the renderer, if it is waiting for a new frame.
+ *
+ * This must be called between two steps, by the thread that runs the simulation. Most of the calls return at once,
+ * so the simulation is slowed down only by the copy of the positions, once per frame.
+ * @param positions These are the particles' coordinates, stored as (row, col) pairs.
+ * @param n_particles This is the number of particles.
+ */
+void MazeAnimator::offer(const int *positions, int n_particles) {
+    if(!this->wants_snapshot())
+        return;
+
+    std::lock_guard<std::mutex> lock(this->snapshot_mutex);
+    this->take_snapshot(positions, n_particles);
+}
+
+
+/**
+ * Draws the last positions of the particles and stops the renderer.
+ *
+ * The cursor is left below the maze.
+ * @param positions These are the particles' coordinates, stored as (row, col) pairs. It can be nullptr.
+ * @param n_particles This is the number of particles.
+ */
+void MazeAnimator::finish(const int *positions, int n_particles) {
+    {
+        std::lock_guard<std::mutex> lock(this->snapshot_mutex);
+        if(positions)
+            this->take_snapshot(positions, n_particles);
+        this->stopping = true;
+    }
+    this->snapshot_ready_cv.notify_one();
+    this->renderer.join();
+
+    std::cout << "\x1B[" << this->background.size() + 1 << ";1H" << std::endl;
+}
+
+
+/**
+ * Stores the particles' positions as the cells' flat indexes and wakes the renderer up.
+ *
+ * The caller must hold the snapshot's mutex.
+ * @param positions These are the particles' coordinates, stored as (row, col) pairs.
+ * @param n_particles This is the number of particles.
+ */
+void MazeAnimator::take_snapshot(const int *positions, int n_particles) {
+    this->snapshot.resize(n_particles);
+    for(int index = 0; index < n_particles; index++)
+        this->snapshot[index] = this->background.index(positions[2 * index], positions[2 * index + 1]);
+
+    this->snapshot_ready = true;
+    this->snapshot_wanted.store(false, std::memory_order_release);
+    this->snapshot_ready_cv.notify_one();
+}
+
+
+/**
+ * Renderer's loop: once per frame it asks for a snapshot, waits for it and draws it.
+ */
+void MazeAnimator::run() {
+    std::vector<int> particle_cells;
+    auto next_frame = std::chrono::steady_clock::now();
+
+    while(true) {
+        std::unique_lock<std::mutex> lock(this->snapshot_mutex);
+        // Sleeps until the next frame, unless the animation is over
+        next_frame += std::chrono::microseconds(this->frame_microseconds);
+        this->snapshot_ready_cv.wait_until(lock, next_frame, [this] { return this->stopping; });
+
+        this->snapshot_wanted.store(true, std::memory_order_release);
+        this->snapshot_ready_cv.wait(lock, [this] { return this->snapshot_ready || this->stopping; });
+        this->snapshot_wanted.store(false, std::memory_order_release);
+
+        bool last_frame = this->stopping;
+        if(!this->snapshot_ready)
+            break;
+        this->snapshot_ready = false;
+        particle_cells.swap(this->snapshot);
+        lock.unlock();
+
+        this->draw(particle_cells);
+        if(last_frame)
+            break;
+    }
+}
+
+
+/**
+ * Draws the cells that changed since the previous frame.
+ *
+ * The particles drawn by the previous frame are replaced by the background, then the new ones are drawn.
+ * The start is always shown, even when a particle is onto it.
+ * @param particle_cells These are the flat indexes of the cells that hold a particle.
+ */
+void MazeAnimator::draw(const std::vector<int> &particle_cells) {
+    std::vector<int> previous_cells;
+    previous_cells.swap(this->marked_cells);
+    for(int cell : previous_cells)
+        this->desired[cell] = this->background[cell];
+
+    for(int cell : particle_cells) {
+        if(this->desired[cell] != MAZE_PATH::PARTICLE && this->background[cell] != MAZE_PATH::START) {
+            this->desired[cell] = MAZE_PATH::PARTICLE;
+            this->marked_cells.push_back(cell);
+        }
+    }
+
+    // Moves the cursor onto each changed cell. The rows and the columns of the terminal start from 1
+    this->output.clear();
+    for(const std::vector<int> *cells : {&previous_cells, &this->marked_cells}) {
+        for(int cell : *cells) {
+            if(this->shown[cell] == this->desired[cell])
+                continue;
+            this->shown[cell] = this->desired[cell];
+            this->output += "\x1B[" + std::to_string(this->background.row_of(cell) + 1) + ";" +
+                            std::to_string(this->background.col_of(cell) * 3 + 1) + "H";
+            this->output += ascii_glyph(this->desired[cell]);
+        }
+    }
+
+    if(!this->output.empty())
+        std::cout << this->output << std::flush;
+}
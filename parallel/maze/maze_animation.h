@@ -0,0 +1,56 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#ifndef RANDOMMAZESOLVER_MAZE_ANIMATION_H
+#define RANDOMMAZESOLVER_MAZE_ANIMATION_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../utils/maze/maze.h"
+
+/**
+ * Shows the particles' movements from its own thread.
+ *
+ * The renderer asks for a snapshot of the particles' positions once per frame, and the simulation hands it over
+ * between two steps. The steps in between are never drawn, so the simulation doesn't wait for the terminal.
+ * Only the cells that changed since the previous frame are redrawn, by moving the cursor onto them.
+ */
+class MazeAnimator {
+public:
+    MazeAnimator(const Maze &background, int frames_per_second);
+    ~MazeAnimator();
+    MazeAnimator(const MazeAnimator &) = delete;
+    MazeAnimator &operator=(const MazeAnimator &) = delete;
+
+    /// Cheap check, used by the simulation in order to know if the renderer is waiting for a snapshot.
+    [[nodiscard]] bool wants_snapshot() const { return this->snapshot_wanted.load(std::memory_order_acquire); }
+    void offer(const int *positions, int n_particles);
+    void finish(const int *positions, int n_particles);
+
+private:
+    void run();
+    void take_snapshot(const int *positions, int n_particles);
+    void draw(const std::vector<int> &particle_cells);
+
+    Maze background;
+    // What the terminal is showing and what the current frame should show
+    Maze shown;
+    Maze desired;
+    std::vector<int> marked_cells;
+    std::string output;
+    int frame_microseconds;
+
+    std::thread renderer;
+    std::mutex snapshot_mutex;
+    std::condition_variable snapshot_ready_cv;
+    std::atomic<bool> snapshot_wanted = false;
+    bool snapshot_ready = false;
+    bool stopping = false;
+    std::vector<int> snapshot;
+};
+
+#endif //RANDOMMAZESOLVER_MAZE_ANIMATION_H
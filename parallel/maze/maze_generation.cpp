@@ -1,18 +1,21 @@
 // Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
-#include <iterator>
+#include <omp.h>
 
 #include "maze_generation.h"
+#include "../../utils/philox.h"
+#include "../../utils/utils.h"
 
 
 // PROTOTYPES
-std::vector<int> p_get_exit_coords(int &size, std::mt19937 &rng);
-void p_initialize_maze(std::vector<std::vector<MAZE_PATH>> &maze, int &size, std::vector<int> exit_coords, bool parallelize);
-void p_generate_paths(std::vector<std::vector<MAZE_PATH>> &maze, int &size, std::vector<int> exit_coords, std::mt19937 &rng, bool parallelize);
-void p_visit_forward(std::vector<std::vector<MAZE_PATH>> &maze, int &size, int &curr_index, std::vector<int> &curr_cell, std::vector<std::vector<int>> &curr_track, std::vector<std::vector<bool>> &visited_cells, std::mt19937 &rng, bool is_exit, bool parallelize);
-std::vector<std::vector<int>> p_get_unvisited_near_cells(std::vector<std::vector<MAZE_PATH>> &maze, std::vector<int> &curr_cell, int &size, std::vector<std::vector<bool>> &visited_cells, int &n_cells, bool is_exit);
-void p_backtrack(std::vector<std::vector<MAZE_PATH>> &maze, int &size, int &curr_index, std::vector<int> &curr_cell, std::vector<std::vector<int>> &curr_track, std::vector<std::vector<bool>> &visited_cells,  std::mt19937 &rng, bool parallelize);
+void p_carve_tile(Maze &maze, const Tile &tile, std::mt19937 &rng, std::vector<bool> &visited_nodes, std::vector<int> &curr_track);
+void p_stitch_tiles(Maze &maze, const std::vector<Tile> &tiles, int n_tiles_side, std::mt19937 &rng, GeneratorContext &context);
+void p_generate_packed_paths(PackedMaze &maze, const std::vector<int> &exit_coords, std::mt19937 &rng, GeneratorContext &context);
+int p_get_unvisited_near_nodes(int n_nodes_side, int curr_node, std::vector<bool> &visited_nodes, int (&near_nodes)[4], OPEN_DIRECTION (&near_directions)[4]);
+int p_find_set(std::vector<int> &sets, int node_col);
 
 // FUNCTIONS
 
@@ -22,23 +25,180 @@ void p_backtrack(std::vector<std::vector<MAZE_PATH>> &maze, int &size, int &curr
  *  This function is exported to the other source files in the project as it allows to generate random square mazes
  *  with the given size. If the size is not odd or the relative values is outside the allowed range, it s generated
  *  randomly. A specific seed can be passed to the function in order to generate a specific maze.
+ *  With more than one tile per side, the maze is carved by tiles in parallel and it is no longer the same one generated
+ *  by the sequential version, but it still depends only on the seed and on the number of tiles.
  *
  *  @param maze It's the matrix representing the maze that is being generated.
  *  @param size Represents the length of each maze's side.
  *  @param generation_rng This is the random number engine to use in order to generate random values.
- *  @param parallelize Flag used to determine if it useful to parallelize the code inside the current function.
+ *  @param n_tiles_side This is the number of tiles on each maze's side. 1 carves the whole maze with a single visit.
+ *  @param n_threads This is the number of threads that run the code inside the current function, 1 runs it sequentially.
+ *  @param context This holds the memory used by the visits, reused from the previous generations.
  */
-void p_generate_square_maze(std::vector<std::vector<MAZE_PATH>> &maze, int &size, std::mt19937 generation_rng, bool parallelize) {
-    std::cout << "Generating the maze.." << std::endl;
+void p_generate_square_maze(Maze &maze, int &size, std::mt19937 generation_rng, int n_tiles_side, int n_threads, GeneratorContext &context) {
+    execution_output() << "Generating the maze.." << std::endl;
 
     // Selects the exit's coordinates randomly
-    std::vector<int> exit_coords = p_get_exit_coords(size, generation_rng);
+    std::vector<int> &exit_coords = context.exit_coords;
+    p_get_exit_coords(size, generation_rng, exit_coords);
 
     // Initialize the maze to 0 places the initial walls and sets the random exit
-    p_initialize_maze(maze, size, exit_coords, parallelize);
+    p_initialize_maze(maze, size, exit_coords, n_threads);
 
     // Generates the maze's paths
-    p_generate_paths(maze, size, exit_coords, generation_rng, parallelize);
+    // Each tile needs at least one node on each side
+    n_tiles_side = std::clamp(n_tiles_side, 1, size / 2);
+    std::chrono::steady_clock::time_point start_ts = std::chrono::steady_clock::now();
+    if(n_tiles_side > 1)
+        p_generate_tiled_paths(maze, size, n_tiles_side, generation_rng, n_threads, context);
+    else
+        p_generate_paths(maze, size, exit_coords, generation_rng, context);
+    print_carving_rate(static_cast<long>(size / 2) * (size / 2), start_ts);
+}
+
+
+/**
+ * Generates a random squared maze directly into its packed representation.
+ *
+ *  The maze is the same one that p_generate_square_maze would produce with the same size and seed, but the MAZE_PATH
+ *  grid is never allocated. This allows to generate mazes that would not fit into memory otherwise.
+ *  @see PackedMaze.
+ *
+ *  @param maze It's the packed structure representing the maze that is being generated.
+ *  @param size Represents the length of each maze's side.
+ *  @param generation_rng This is the random number engine to use in order to generate random values.
+ *  @param context This holds the memory used by the visit, reused from the previous generations.
+ */
+void p_generate_packed_maze(PackedMaze &maze, int &size, std::mt19937 generation_rng, GeneratorContext &context) {
+    execution_output() << "Generating the packed maze.." << std::endl;
+
+    // Selects the exit's coordinates randomly
+    std::vector<int> &exit_coords = context.exit_coords;
+    p_get_exit_coords(size, generation_rng, exit_coords);
+
+    // All the nodes start closed, as if every wall was in place
+    maze.resize(size);
+
+    // Generates the maze's paths
+    std::chrono::steady_clock::time_point start_ts = std::chrono::steady_clock::now();
+    p_generate_packed_paths(maze, exit_coords, generation_rng, context);
+
+    // Reports the carving throughput and the memory used
+    print_carving_rate(static_cast<long>(size / 2) * (size / 2), start_ts);
+    execution_output() << "Packed maze size: " << maze.bytes() << " bytes" << std::endl;
+}
+
+/**
+ * Generates a random squared maze one row at a time, by using Eller's algorithm.
+ *
+ *  Each row of nodes is emitted to the sink as soon as it is complete, and only the state of the current row is kept
+ *  in memory. So the memory used grows with the maze's side instead of its area, and the maze can be stored or
+ *  consumed while it is being generated.
+ *  The generated maze is perfect too, but it is not the same one produced by the depth first visit.
+ *
+ *  @param size Represents the length of each maze's side.
+ *  @param generation_rng This is the random number engine to use in order to generate random values.
+ *  @param sink This is the function that receives the open directions' masks of each row of nodes, from the top one.
+ *  @param context This holds the state of the current row, reused from the previous generations.
+ */
+void p_generate_streamed_maze(int &size, std::mt19937 generation_rng, const NodeRowSink &sink, GeneratorContext &context) {
+    execution_output() << "Generating the streamed maze.." << std::endl;
+
+    // Selects the exit's coordinates randomly
+    std::vector<int> &exit_coords = context.exit_coords;
+    p_get_exit_coords(size, generation_rng, exit_coords);
+    int n_nodes_side = size / 2;
+
+    // Masks of the current row and the sets its nodes belong to. The sets are stored as a disjoint-set forest whose
+    // roots are columns of the current row, so they are relabelled at each row
+    std::vector<uint8_t> &open_masks = context.open_masks;
+    open_masks.assign(n_nodes_side, 0);
+    std::vector<int> &sets = context.sets;
+    sets.assign(n_nodes_side, 0);
+    // Set of the node above each node of the current row, -1 if the 2 nodes are not connected
+    std::vector<int> &sets_above = context.sets_above;
+    sets_above.assign(n_nodes_side, -1);
+    std::vector<int> &first_cols = context.first_cols;
+    first_cols.assign(n_nodes_side, 0);
+    std::vector<int> &remaining_nodes = context.remaining_nodes;
+    remaining_nodes.assign(n_nodes_side, 0);
+    std::vector<uint8_t> &joined_below = context.joined_below;
+    joined_below.assign(n_nodes_side, 0);
+
+    // Each decision takes a single random bit, so the engine is called once every 32 decisions
+    uint32_t random_bits = 0;
+    int n_random_bits = 0;
+    auto random_bit = [&]() {
+        if(n_random_bits == 0) {
+            random_bits = generation_rng();
+            n_random_bits = 32;
+        }
+        n_random_bits--;
+        bool bit = random_bits & 1;
+        random_bits >>= 1;
+        return bit;
+    };
+
+    std::chrono::steady_clock::time_point start_ts = std::chrono::steady_clock::now();
+    for(int node_row = 0; node_row < n_nodes_side; node_row++) {
+        bool last_row = node_row == n_nodes_side - 1;
+
+        // The nodes that are open towards the previous row keep its sets, while the other ones start in a new set.
+        // Each set of the previous row is rooted at the first column of the current one that belongs to it
+        std::fill(first_cols.begin(), first_cols.end(), -1);
+        for(int node_col = 0; node_col < n_nodes_side; node_col++) {
+            sets[node_col] = node_col;
+            open_masks[node_col] = 0;
+            int set_above = sets_above[node_col];
+            if(set_above < 0)
+                continue;
+            open_masks[node_col] = OPEN_DIRECTION::OPEN_N;
+            if(first_cols[set_above] < 0)
+                first_cols[set_above] = node_col;
+            else
+                sets[node_col] = first_cols[set_above];
+        }
+
+        // Randomly joins the nearby nodes of different sets. The last row joins all of them, in order to connect the
+        // whole maze
+        for(int node_col = 0; node_col + 1 < n_nodes_side; node_col++) {
+            int west_root = p_find_set(sets, node_col);
+            int east_root = p_find_set(sets, node_col + 1);
+            if(west_root != east_root && (last_row || random_bit())) {
+                sets[std::max(west_root, east_root)] = std::min(west_root, east_root);
+                open_masks[node_col] |= OPEN_DIRECTION::OPEN_E;
+                open_masks[node_col + 1] |= OPEN_DIRECTION::OPEN_W;
+            }
+        }
+
+        // Randomly opens the nodes towards the next row, at least once for each set so that no set gets isolated
+        if(!last_row) {
+            std::fill(remaining_nodes.begin(), remaining_nodes.end(), 0);
+            std::fill(joined_below.begin(), joined_below.end(), 0);
+            for(int node_col = 0; node_col < n_nodes_side; node_col++)
+                remaining_nodes[p_find_set(sets, node_col)]++;
+
+            for(int node_col = 0; node_col < n_nodes_side; node_col++) {
+                int root = p_find_set(sets, node_col);
+                remaining_nodes[root]--;
+                sets_above[node_col] = -1;
+                if(random_bit() || (remaining_nodes[root] == 0 && !joined_below[root])) {
+                    open_masks[node_col] |= OPEN_DIRECTION::OPEN_S;
+                    sets_above[node_col] = root;
+                    joined_below[root] = 1;
+                }
+            }
+        }
+
+        // The exit is always located onto the top or the left border
+        if(exit_coords[0] == 0 && node_row == 0)
+            open_masks[exit_coords[1] / 2] |= OPEN_DIRECTION::OPEN_N;
+        else if(exit_coords[1] == 0 && node_row == exit_coords[0] / 2)
+            open_masks[0] |= OPEN_DIRECTION::OPEN_W;
+
+        sink(node_row, open_masks);
+    }
+    print_carving_rate(static_cast<long>(n_nodes_side) * n_nodes_side, start_ts);
 }
 
 
@@ -55,7 +215,21 @@ void p_generate_square_maze(std::vector<std::vector<MAZE_PATH>> &maze, int &size
  */
 std::vector<int> p_get_exit_coords(int &size, std::mt19937 &rng) {
     std::vector<int> exit_coords;
-    exit_coords.reserve(2);
+    p_get_exit_coords(size, rng, exit_coords);
+    return exit_coords;
+}
+
+
+/**
+ * Randomly selects the exit's cell, and stores its coordinates into an existing vector.
+ *
+ *  @see p_get_exit_coords.
+ *  @param size Represents the length of each maze's side.
+ *  @param rng This is the random number engine to use in order to generate random values.
+ *  @param exit_coords This vector receives the coordinates of the chosen exit cell.
+ */
+void p_get_exit_coords(int &size, std::mt19937 &rng, std::vector<int> &exit_coords) {
+    exit_coords.clear();
 
     // Selects the exit's coordinates randomly
     std::uniform_int_distribution<int> uniform_coord(0, size - 1);
@@ -72,7 +246,6 @@ std::vector<int> p_get_exit_coords(int &size, std::mt19937 &rng) {
 
     exit_coords.push_back(exit_x);
     exit_coords.push_back(exit_y);
-    return exit_coords;
 }
 
 
@@ -86,101 +259,24 @@ std::vector<int> p_get_exit_coords(int &size, std::mt19937 &rng) {
  *  @param maze It's the matrix representing the maze that is being generated.
  *  @param size Represents the length of each maze's side.
  *  @param exit_coords This is the random number engine to use in order to generate random values.
- *  @param parallelize Flag used to determine if it useful to parallelize the code inside the current function.
+ *  @param n_threads This is the number of threads that run the code inside the current function, 1 runs it sequentially.
  */
-void p_initialize_maze(std::vector<std::vector<MAZE_PATH>> &maze, int &size, std::vector<int> exit_coords, bool parallelize) {
-    // Resizes the matrix to avoid sigsev errors
-    #pragma omp parallel if(parallelize)
-    {
-        #pragma omp for
-        for (int i = 0; i < maze.size(); ++i) {
-            maze[i].resize(size);
-        }
-
-        // Initializes the matrix
-        #pragma omp for
-        for (int row = 0; row < size; row++) {
-            for (int col = 0; col < size; col++) {
-                // Place walls on even rows and columns to create the grid
-                if (row % 2 == 0 || col % 2 == 0) {
-                    #pragma omp critical
-                    maze[row][col] = MAZE_PATH::WALL;
-                }
-                    // Set the walkable path
-                else {
-                    #pragma omp critical
-                    maze[row][col] = MAZE_PATH::EMPTY;
-                }
-            }
+void p_initialize_maze(Maze &maze, int &size, const std::vector<int> &exit_coords, int n_threads) {
+    // Resizes the matrix. The grid is filled with walls, the sentinel border included
+    maze.resize(size);
+
+    // Initializes the matrix
+    // Walls are kept on even rows and columns to create the grid, so only the walkable path is set.
+    // Each thread writes its own rows of the contiguous buffer, so no synchronization is required
+    #pragma omp parallel for num_threads(n_threads) if(n_threads > 1)
+    for (int row = 1; row < size; row += 2) {
+        for (int col = 1; col < size; col += 2) {
+            maze(row, col) = MAZE_PATH::EMPTY;
         }
     }
 
     // Placing the exit in the maze
-    maze[exit_coords[0]][exit_coords[1]] = MAZE_PATH::EXIT;
-}
-
-
-/**
- * Initializes the maze's inner structure generation.
- *
- * This function creates the visited cells matrix to keep track of which cell in the maze has been visited during
- * the actual generation. Then it starts the generation of the structure.
- *
- *  @param maze It's the matrix representing the maze that is being generated.
- *  @param size Represents the length of each maze's side.
- *  @param exit_coords This is the random number engine to use in order to generate random values.
- *  @param rng This is the random number engine to use in order to generate random values.
- *  @param parallelize Flag used to determine if it useful to parallelize the code inside the current function.
- */
-void p_generate_paths(std::vector<std::vector<MAZE_PATH>> &maze, int &size, std::vector<int> exit_coords, std::mt19937 &rng, bool parallelize) {
-    std::vector<std::vector<bool>> visited_cells;
-    visited_cells.resize(size);
-    std::vector<std::vector<int>> curr_track;
-
-    // Initializes the current path tracking and sets the relative index to 0
-    int curr_index = 0;
-    curr_track.push_back(exit_coords);
-
-//    // Initializes the visited_cells array to false as no cell has been visited yet
-//    for(int row = 0; row < size; row++) {
-//        std::vector<bool> curr_col;
-//        curr_col.resize(size);
-//        curr_col.reserve(size);
-//        for(int col = 0; col < size; col++)
-//        {
-//            curr_col[col] = false;
-//        }
-//        visited_cells[row] = curr_col;
-//    }
-
-    // Initializes the visited_cells array to false as no cell has been visited yet
-    #pragma omp parallel if(parallelize)
-    {
-        #pragma omp for
-        for (int i = 0; i < size; ++i) {
-            visited_cells[i].resize(size);
-        }
-
-        #pragma omp for
-        for(int i = 0; i < size; i++) {
-            for (int j = 0; j < size; j++) {
-                #pragma omp critical
-                visited_cells[i][j] = false;
-            }
-        }
-    }
-
-    // Sets the exit cell as first visited cell
-    visited_cells[exit_coords[0]][exit_coords[1]] = true;
-
-    // Selects the exit as starting cell for the path generation
-    std::vector<int> curr_cell = exit_coords;
-
-    // Retrieves the nearest cells if there is any
-    // Then randomly select one of them and proceeds visiting it
-    // If a dead end is found, it backtracks all steps until it finds a new unvisited cell
-    // If by backtracking all cells have been visited, the maze has been completely generated
-    p_visit_forward(maze, size, curr_index, curr_cell, curr_track, visited_cells, rng, true, parallelize);
+    maze(exit_coords[0], exit_coords[1]) = MAZE_PATH::EXIT;
 }
 
 
@@ -193,109 +289,80 @@ void p_generate_paths(std::vector<std::vector<MAZE_PATH>> &maze, int &size, std:
  *  considered is found and connects the current cell with it. If by backtracking the initial cell is reached, it means
  *  that there is no remaining cell to consider and the generation stops.
  *
+ *  The depth first visit is performed iteratively: the current track is an explicit stack of flat cell indices that is
+ *  reserved once, so no heap allocation happens while carving and the maze's size is not limited by the call stack.
+ *  The visited cells and the track are kept by the context, so that the next generations reuse their memory.
+ *  The random values are drawn in the same order as the original recursive visit, so the same seed always produces
+ *  the same maze.
+ *
  *  @param maze It's the matrix representing the maze that is being generated.
  *  @param size Represents the length of each maze's side.
- *  @param curr_index Represents the current index related to the visited cells tracking in the actual path. This will
- *  be used later in order to follow the steps back and find new unvisited cells (backtracking).
- *  @param exit_coords This is the random number engine to use in order to generate random values.
- *  @param curr_cell This is the current cell for which the near unvisited cells are being checked. If there is any,
- *  a connection between the 2 is performed by removing the wall in between.
- *  @param curr_track Contains all the coordinates of the visited cells in the current path, and keeps track
- *  of their traversal order.
- *  @param visited_cells This is the matrix used to keep track of all the cells that have been visited.
+ *  @param exit_coords These are the coordinates of the maze's exit, from which the generation starts.
  *  @param rng This is the random number engine to use in order to generate random values.
- *  @param is_exit This flag is used to determine if the current cell corresponds to the exit. If so there is surely only
- *  one nearby unvisited cell, but no wall in between. So the wall removal is unneeded.
- *  @param parallelize Flag used to determine if it useful to parallelize the code inside the current function.
+ *  @param context This holds the visited cells and the track, reused from the previous generations.
  */
-void p_visit_forward(std::vector<std::vector<MAZE_PATH>> &maze, int &size, int &curr_index, std::vector<int> &curr_cell, std::vector<std::vector<int>> &curr_track, std::vector<std::vector<bool>> &visited_cells, std::mt19937 &rng, bool is_exit, bool parallelize) {
+void p_generate_paths(Maze &maze, int &size, const std::vector<int> &exit_coords, std::mt19937 &rng, GeneratorContext &context) {
+    // Initializes the visited_cells array to false as no cell has been visited yet
+    // It shares the maze's layout, so cells are addressed by their flat index
+    std::vector<bool> &visited_cells = context.visited_cells;
+    visited_cells.assign(static_cast<size_t>(maze.stride()) * maze.stride(), false);
+
+    // The track can't be longer than the number of walkable cells plus the exit
+    std::vector<int> &curr_track = context.curr_track;
+    curr_track.clear();
+    curr_track.reserve(static_cast<size_t>(size / 2) * (size / 2) + 1);
+
+    // Sets the exit cell as first visited cell and selects it as starting cell for the path generation
+    int curr_cell = maze.index(exit_coords[0], exit_coords[1]);
+    visited_cells[curr_cell] = true;
+    curr_track.push_back(curr_cell);
+
+    // The exit cell has a near unvisited cell without the wall in between, while all the other cells
+    // have near unvisited cells separated by walls
+    bool is_exit = true;
+    int near_cells[4];
+
     // Retrieves the nearest cells if there is any
     // Then randomly select one of them and proceeds visiting it
     // If a dead end is found, it backtracks all steps until it finds a new unvisited cell
     // If by backtracking all cells have been visited, the maze has been completely generated
-    int n_cells = 0;
-    std::vector<std::vector<int>> near_cells = p_get_unvisited_near_cells(maze, curr_cell, size, visited_cells, n_cells, is_exit);
-
     // IMPORTANT:
     // The following loop can't be parallelized as the algorithm to generate the path follows a sequential movement logic
-    // n_cells is updated by the function call above
-    while(n_cells > 0) {
-        curr_index += 1;
-        // Creates the uniform_distributor that will select a random unvisited cell
-        std::uniform_int_distribution<int> uniform_cell_idx(0, n_cells - 1);
-
-        // Uses the distribution above to select the new cell to connect with
-        int new_cell_index = uniform_cell_idx(rng);
-        if(new_cell_index > n_cells - 1) {
-            std::cout << "Wrong index found";
-            exit(1);
-        }
-        std::vector<int> new_cell = near_cells[new_cell_index];
-
-        // Removes the walls only if the current cell is not the exit as the exit cell has a near unvisited cell without
-        // the wall in between.
-        // Non exit cells have near unvisited cells separated by walls
-        if(!is_exit) {
-            int row_to_del = -1;
-            int col_to_del = -1;
-
-            // Removing the wall in between new_cell and curr_cell
-
-            // Case in which the 2 cells are located onto the same column
-            if(new_cell[1] == curr_cell[1])
-            {
-                // The wall's cell X coordinate is smaller than new_cell's one and bigger than curr_cell's
-                if(new_cell[0] > curr_cell[0]) {
-                    row_to_del = new_cell[0] - 1;
-                    col_to_del = new_cell[1];
-                }
-                // The wall's cell X coordinate is bigger than new_cell's one and smaller than curr_cell's
-                else {
-                    row_to_del = new_cell[0] + 1;
-                    col_to_del = new_cell[1];
-                }
-            // Case in which the 2 cells are located onto the same row
-            } else if (new_cell[0] == curr_cell[0])
-            {
-                // The wall's cell Y coordinate is smaller than new_cell's one and bigger than curr_cell's
-                if(new_cell[1] > curr_cell[1]) {
-                    row_to_del = new_cell[0];
-                    col_to_del = new_cell[1] - 1;
-                }
-                // The wall's cell Y coordinate is bigger than new_cell's one and smaller than curr_cell's
-                else {
-                    row_to_del = new_cell[0];
-                    col_to_del = new_cell[1] + 1;
-                }
-            }
+    while(true) {
+        int n_cells = p_get_unvisited_near_cells(maze, curr_cell, visited_cells, near_cells, is_exit);
 
-            // Deletes the wall in between the 2 cells
-            if(row_to_del > -1 && col_to_del > -1) {
-                maze[row_to_del][col_to_del] = MAZE_PATH::EMPTY;
-            }
-            else {
-                std::cout << "Unexpected error while generating the maze path." << std::endl;
-                std::cout << "The selected unvisited cell is not located beside the current one!\nExiting..";
-                exit(1);
+        if(n_cells > 0) {
+            // Creates the uniform_distributor that will select a random unvisited cell
+            std::uniform_int_distribution<int> uniform_cell_idx(0, n_cells - 1);
+
+            // Uses the distribution above to select the new cell to connect with
+            int new_cell = near_cells[uniform_cell_idx(rng)];
+
+            // Removes the wall in between the 2 cells, which is always located halfway between their flat indexes.
+            // The exit cell is skipped as it has no wall in between
+            if(!is_exit) {
+                maze[(curr_cell + new_cell) / 2] = MAZE_PATH::EMPTY;
+            } else {
+                // We are moving from the exit cell to the near unvisited cell
+                is_exit = false;
             }
-        // We are moving from the exit cell to the near unvisited cell
+
+            // Sets the new cell as current one to consider
+            curr_cell = new_cell;
+            // Updates the matrix of all the visited cells so far
+            visited_cells[curr_cell] = true;
+            // Updates the current path for the eventual backtracking
+            curr_track.push_back(curr_cell);
         } else {
-            is_exit = false;
+            // Follows the path's steps back until a new unvisited cell is found
+            curr_track.pop_back();
+            // If we reached the exit again it means we visited all maze cells available,
+            // so we can safely stop backtracking
+            if(curr_track.size() <= 1)
+                break;
+            curr_cell = curr_track.back();
         }
-
-        // Sets the new cell as current one to consider
-        curr_cell = new_cell;
-        // Updates the matrix of all the visited cells so far
-        visited_cells[curr_cell[0]][curr_cell[1]] = true;
-        // Updates the current path for the eventual backtracking
-        curr_track.push_back(curr_cell);
-        // Gets the new unvisited cells nearby the current cell if there is any
-        // n_cells is updated by the function call below
-        near_cells = p_get_unvisited_near_cells(maze, curr_cell, size, visited_cells, n_cells, is_exit);
     }
-    // Follows the path's steps back until a new unvisited cell is found, and then it resumes the path generation
-    // process from there
-    p_backtrack(maze, size, curr_index, curr_cell, curr_track, visited_cells, rng, parallelize);
 }
 
 
@@ -306,115 +373,345 @@ void p_visit_forward(std::vector<std::vector<MAZE_PATH>> &maze, int &size, int &
  * possible path joining targets.
  *
  *  @param maze It's the matrix representing the maze that is being generated.
- *  @param curr_cell This is the current cell for which the near unvisited cells are being checked.
- *  @param size Represents the length of each maze's side.
+ *  @param curr_cell This is the flat index of the current cell for which the near unvisited cells are being checked.
  *  @param visited_cells This is the matrix used to keep track of all the cells that have been visited.
- *  @param n_cells This is a reference to a variable representing the total count of nearby unvisited cells.
+ *  @param near_cells This array is filled with the flat indexes of the available cells for joining paths.
  *  @param is_exit This flag is used to determine if the current cell corresponds to the exit. If so there is surely only
  *  one nearby unvisited cell, but no wall in between. So the wall removal is unneeded.
  *
- *  @return the matrix containing all the available cells' coordinates for joining paths.
+ *  @return the total count of nearby unvisited cells.
  */
-std::vector<std::vector<int>> p_get_unvisited_near_cells(std::vector<std::vector<MAZE_PATH>> &maze, std::vector<int> &curr_cell, int &size, std::vector<std::vector<bool>> &visited_cells, int &n_cells, bool is_exit) {
-    // Initialize the matrix to -1 pairs
-    std::vector<std::vector<int>> near_cells;
-    near_cells.reserve(4);
-    n_cells = 0;
+int p_get_unvisited_near_cells(Maze &maze, int curr_cell, std::vector<bool> &visited_cells, int (&near_cells)[4], bool is_exit) {
+    int n_cells = 0;
     // If the current cell corresponds to the exit, we check for unvisited cells immediately near to it
     // otherwise we look for cells behind walls
     int index_offset = is_exit ? 1 : 2;
-    std::vector<int> curr_pos;
-    curr_pos.reserve(2);
-
-    // Getting the indexes of the cells behind the walls
+    // Getting the indexes of the cells behind the walls, in the east, north, west and south order,
     // and checking if they have been visited already
+    // Cells outside the maze belong to its sentinel border, so they are always seen as walls
+    const int offsets[4] = {index_offset * maze.stride(), index_offset, -index_offset * maze.stride(), -index_offset};
 
-    // Looking for an unvisited cell located at east in relation to the current cell
-    int index = curr_cell[0] + index_offset;
-    if(index >= 0 && index < size && !visited_cells[index][curr_cell[1]] && maze[index][curr_cell[1]] != MAZE_PATH::WALL)
-    {
-        curr_pos.push_back(index);
-        curr_pos.push_back(curr_cell[1]);
-        near_cells.push_back(curr_pos);
-        n_cells += 1;
+    for(int offset : offsets) {
+        int index = curr_cell + offset;
+        if(maze[index] != MAZE_PATH::WALL && !visited_cells[index])
+            near_cells[n_cells++] = index;
     }
 
-    curr_pos.clear();
+    return n_cells;
+}
+
 
-    // Looking for an unvisited cell located at north in relation to the current cell
-    index = curr_cell[1] + index_offset;
-    if(index >= 0 && index < size && !visited_cells[curr_cell[0]][index] && maze[curr_cell[0]][index] != MAZE_PATH::WALL) {
-        curr_pos.push_back(curr_cell[0]);
-        curr_pos.push_back(index);
-        near_cells.push_back(curr_pos);
-        n_cells += 1;
+/**
+ * Randomly generates the maze's paths by carving independent tiles and joining them afterwards.
+ *
+ *  The nodes are split into a grid of tiles, and each tile is carved by its own depth first visit, which produces a
+ *  perfect maze inside the tile. The visits don't share any state, so the tiles are carved in parallel.
+ *  Then the tiles are joined by opening a single wall for each edge of a random spanning tree of the tiles' grid, so
+ *  the whole maze is still perfect: every cell can reach any other one through exactly one path.
+ *  Each tile draws its random values from its own engine, seeded with the tile's index, so the generated maze depends
+ *  only on the seed and on the number of tiles, not on the number of threads.
+ *  The exit is placed onto the border during the initialization and it is already open towards its near cell.
+ *
+ *  @param maze It's the matrix representing the maze that is being generated.
+ *  @param size Represents the length of each maze's side.
+ *  @param n_tiles_side This is the number of tiles on each maze's side.
+ *  @param rng This is the random number engine to use in order to generate random values.
+ *  @param n_threads This is the number of threads that run the code inside the current function, 1 runs it sequentially.
+ *  @param context This holds the tiles and the memory used by their visits, reused from the previous generations.
+ */
+void p_generate_tiled_paths(Maze &maze, int &size, int n_tiles_side, std::mt19937 &rng, int n_threads, GeneratorContext &context) {
+    int n_nodes_side = size / 2;
+    int n_tiles = n_tiles_side * n_tiles_side;
+
+    // The nodes are split as evenly as possible, so the tiles' sides differ by one node at most
+    std::vector<Tile> &tiles = context.tiles;
+    tiles.clear();
+    tiles.reserve(n_tiles);
+    for(int tile_row = 0; tile_row < n_tiles_side; tile_row++) {
+        for(int tile_col = 0; tile_col < n_tiles_side; tile_col++) {
+            int first_row = tile_row * n_nodes_side / n_tiles_side;
+            int first_col = tile_col * n_nodes_side / n_tiles_side;
+            tiles.push_back(Tile(first_row, first_col, (tile_row + 1) * n_nodes_side / n_tiles_side - first_row,
+                                 (tile_col + 1) * n_nodes_side / n_tiles_side - first_col));
+        }
     }
 
-    curr_pos.clear();
+    execution_output() << "Carving " << n_tiles << " tiles.." << std::endl;
 
-    // Looking for an unvisited cell located at west in relation to the current cell
-    index = curr_cell[0] - index_offset;
-    if(index >= 0 && index < size && !visited_cells[index][curr_cell[1]] && maze[index][curr_cell[1]] != MAZE_PATH::WALL)
-    {
-        curr_pos.push_back(index);
-        curr_pos.push_back(curr_cell[1]);
-        near_cells.push_back(curr_pos);
-        n_cells += 1;
-    }
+    // The tiles' engines are seeded by a counter-based generator keyed by a single value of the generation's sequence,
+    // so each tile's seed depends only on its index
+    Philox4x32 tiles_rng(rng());
 
-    curr_pos.clear();
+    // Each thread carves its tiles with its own visited nodes and track
+    if(context.tiles_visited_nodes.size() < static_cast<size_t>(n_threads)) {
+        context.tiles_visited_nodes.resize(n_threads);
+        context.tiles_tracks.resize(n_threads);
+    }
 
-    // Looking for an unvisited cell located at south in relation to the current cell
-    index = curr_cell[1] - index_offset;
-    if(index >= 0 && index < size && !visited_cells[curr_cell[0]][index] && maze[curr_cell[0]][index] != MAZE_PATH::WALL) {
-        curr_pos.push_back(curr_cell[0]);
-        curr_pos.push_back(index);
-        near_cells.push_back(curr_pos);
-        n_cells += 1;
+    // Each thread writes only the walls inside its own tiles
+    #pragma omp parallel for schedule(dynamic) num_threads(n_threads) if(n_threads > 1)
+    for(int tile_index = 0; tile_index < n_tiles; tile_index++) {
+        std::mt19937 tile_rng(tiles_rng({static_cast<uint32_t>(tile_index), 0, 0, 0})[0]);
+        int thread_index = omp_get_thread_num();
+        p_carve_tile(maze, tiles[tile_index], tile_rng, context.tiles_visited_nodes[thread_index], context.tiles_tracks[thread_index]);
     }
 
-    return near_cells;
+    p_stitch_tiles(maze, tiles, n_tiles_side, rng, context);
 }
 
 
 /**
- * Follows the current path back until a new unvisited cell is found nearby.
+ * Carves the paths of a single tile.
  *
- *  This function is responsible for following the current path's steps back in order to find new possible routes to
- *  generate the other maze's paths. If by backtracking a cell with at least on nearby unvisited cell is found,
- *  the current track resumes from it and the path generation process can continue.
- *  If the starting cell is reached it means that all the cells in the maze have already been considered and the
- *  generation stops.
+ *  This is the same iterative depth first visit performed by p_generate_packed_paths, restricted to the nodes of the
+ *  tile. The visit starts from a random node, and it never opens the walls placed onto the tile's edges.
  *
  *  @param maze It's the matrix representing the maze that is being generated.
- *  @param size Represents the length of each maze's side.
- *  @param curr_index Represents the current index related to the visited cells tracking in the actual path. This will
- *  be used later in order to follow the steps back and find new unvisited cells (backtracking).
- *  @param curr_cell This is the current cell for which the near unvisited cells are being checked. If there is any,
- *  a connection between the 2 is performed by removing the wall in between.
- *  @param curr_track Contains all the coordinates of the visited cells in the current path, and keeps track
- *  of their traversal order.
- *  @param visited_cells This is the matrix used to keep track of all the cells that have been visited.
+ *  @param tile This is the tile to carve.
  *  @param rng This is the random number engine to use in order to generate random values.
- *  @param parallelize Flag used to determine if it useful to parallelize the code inside the current function.
+ *  @param visited_nodes This is the memory that keeps track of the tile's visited nodes.
+ *  @param curr_track This is the memory that holds the nodes that lead to the current one.
  */
-void p_backtrack(std::vector<std::vector<MAZE_PATH>> &maze, int &size, int &curr_index, std::vector<int> &curr_cell, std::vector<std::vector<int>> &curr_track, std::vector<std::vector<bool>> &visited_cells,  std::mt19937 &rng, bool parallelize) {
-    // Follows the steps back until a new unvisited cell is found or
-    // the maze has been completely visited
-    // Starts from -2 since the latest element in the track corresponds to the latest visited cell (no near unvisited ones)
-    int n_cells = 0;
+void p_carve_tile(Maze &maze, const Tile &tile, std::mt19937 &rng, std::vector<bool> &visited_nodes, std::vector<int> &curr_track) {
+    int n_nodes = tile.n_rows * tile.n_cols;
+    visited_nodes.assign(n_nodes, false);
+
+    // The track can't be longer than the number of nodes
+    curr_track.clear();
+    curr_track.reserve(n_nodes);
+
+    std::uniform_int_distribution<int> uniform_start_idx(0, n_nodes - 1);
+    int curr_node = uniform_start_idx(rng);
+    visited_nodes[curr_node] = true;
+    curr_track.push_back(curr_node);
+
+    int near_nodes[4];
+    OPEN_DIRECTION near_directions[4];
+
+    while(true) {
+        // A tile's nodes are indexed exactly as the nodes of a smaller rectangular maze
+        int n_near_nodes = 0;
+        int node_row = curr_node / tile.n_cols;
+        int node_col = curr_node % tile.n_cols;
+        if(node_row + 1 < tile.n_rows && !visited_nodes[curr_node + tile.n_cols]) {
+            near_nodes[n_near_nodes] = curr_node + tile.n_cols;
+            near_directions[n_near_nodes++] = OPEN_DIRECTION::OPEN_S;
+        }
+        if(node_col + 1 < tile.n_cols && !visited_nodes[curr_node + 1]) {
+            near_nodes[n_near_nodes] = curr_node + 1;
+            near_directions[n_near_nodes++] = OPEN_DIRECTION::OPEN_E;
+        }
+        if(node_row > 0 && !visited_nodes[curr_node - tile.n_cols]) {
+            near_nodes[n_near_nodes] = curr_node - tile.n_cols;
+            near_directions[n_near_nodes++] = OPEN_DIRECTION::OPEN_N;
+        }
+        if(node_col > 0 && !visited_nodes[curr_node - 1]) {
+            near_nodes[n_near_nodes] = curr_node - 1;
+            near_directions[n_near_nodes++] = OPEN_DIRECTION::OPEN_W;
+        }
 
-    // If the track index is 0 we reached the exit again it means we visited all maze cells available,
-    // so we can safely stop backtracking
-    for(int index = curr_index - 1; index > 0; index--) {
-        curr_cell = curr_track[index];
-        curr_track.pop_back();
-        curr_index = index;
-        // n_cells is updated by the function call below
-        p_get_unvisited_near_cells(maze, curr_cell, size, visited_cells, n_cells, false);
-        if(n_cells > 0) {
-            p_visit_forward(maze, size, curr_index, curr_cell, curr_track, visited_cells, rng, false, parallelize);
-            break;
+        if(n_near_nodes > 0) {
+            // Selects a random unvisited node and removes the wall in between, located halfway between the 2 cells
+            std::uniform_int_distribution<int> uniform_node_idx(0, n_near_nodes - 1);
+            int new_node_index = uniform_node_idx(rng);
+            int wall_row = 2 * (tile.first_row + node_row) + 1;
+            int wall_col = 2 * (tile.first_col + node_col) + 1;
+            switch(near_directions[new_node_index]) {
+                case OPEN_DIRECTION::OPEN_S: wall_row++; break;
+                case OPEN_DIRECTION::OPEN_E: wall_col++; break;
+                case OPEN_DIRECTION::OPEN_N: wall_row--; break;
+                case OPEN_DIRECTION::OPEN_W: wall_col--; break;
+            }
+            maze(wall_row, wall_col) = MAZE_PATH::EMPTY;
+
+            curr_node = near_nodes[new_node_index];
+            visited_nodes[curr_node] = true;
+            curr_track.push_back(curr_node);
+        } else {
+            // Follows the path's steps back until a new unvisited node is found
+            curr_track.pop_back();
+            if(curr_track.empty())
+                break;
+            curr_node = curr_track.back();
         }
     }
-}
\ No newline at end of file
+}
+
+
+/**
+ * Joins the carved tiles into a single perfect maze.
+ *
+ *  A random depth first visit of the tiles' grid selects a spanning tree of the tiles. For each of its edges, the wall
+ *  located at a random position of the border shared by the 2 tiles is removed.
+ *
+ *  @param maze It's the matrix representing the maze that is being generated.
+ *  @param tiles These are the tiles, row by row.
+ *  @param n_tiles_side This is the number of tiles on each maze's side.
+ *  @param rng This is the random number engine to use in order to generate random values.
+ *  @param context This holds the memory used by the visit of the tiles.
+ */
+void p_stitch_tiles(Maze &maze, const std::vector<Tile> &tiles, int n_tiles_side, std::mt19937 &rng, GeneratorContext &context) {
+    std::vector<bool> &visited_tiles = context.visited_cells;
+    visited_tiles.assign(tiles.size(), false);
+    std::vector<int> &curr_track = context.curr_track;
+    curr_track.clear();
+    curr_track.reserve(tiles.size());
+
+    int curr_tile = 0;
+    visited_tiles[curr_tile] = true;
+    curr_track.push_back(curr_tile);
+
+    int near_tiles[4];
+    OPEN_DIRECTION near_directions[4];
+
+    while(true) {
+        int n_tiles = p_get_unvisited_near_nodes(n_tiles_side, curr_tile, visited_tiles, near_tiles, near_directions);
+
+        if(n_tiles > 0) {
+            std::uniform_int_distribution<int> uniform_tile_idx(0, n_tiles - 1);
+            int new_tile_index = uniform_tile_idx(rng);
+            int new_tile = near_tiles[new_tile_index];
+
+            // The wall is opened onto the edge of the tile that is located below or on the right
+            const Tile &tile = tiles[std::max(curr_tile, new_tile)];
+            if(near_directions[new_tile_index] == OPEN_DIRECTION::OPEN_S || near_directions[new_tile_index] == OPEN_DIRECTION::OPEN_N) {
+                std::uniform_int_distribution<int> uniform_col(tile.first_col, tile.first_col + tile.n_cols - 1);
+                maze(2 * tile.first_row, 2 * uniform_col(rng) + 1) = MAZE_PATH::EMPTY;
+            } else {
+                std::uniform_int_distribution<int> uniform_row(tile.first_row, tile.first_row + tile.n_rows - 1);
+                maze(2 * uniform_row(rng) + 1, 2 * tile.first_col) = MAZE_PATH::EMPTY;
+            }
+
+            curr_tile = new_tile;
+            visited_tiles[curr_tile] = true;
+            curr_track.push_back(curr_tile);
+        } else {
+            curr_track.pop_back();
+            if(curr_track.empty())
+                break;
+            curr_tile = curr_track.back();
+        }
+    }
+}
+
+
+/**
+ * Randomly generates the paths of a packed maze by connecting its nodes.
+ *
+ *  This is the same iterative depth first visit performed by p_generate_paths, applied to the nodes of the maze.
+ *  The nearby nodes are considered in the same order and the random values are drawn in the same order too, so the
+ *  generated maze does not depend on its representation.
+ *
+ *  @param maze It's the packed structure representing the maze that is being generated.
+ *  @param exit_coords These are the coordinates of the maze's exit, from which the generation starts.
+ *  @param rng This is the random number engine to use in order to generate random values.
+ *  @param context This holds the visited nodes and the track, reused from the previous generations.
+ */
+void p_generate_packed_paths(PackedMaze &maze, const std::vector<int> &exit_coords, std::mt19937 &rng, GeneratorContext &context) {
+    int n_nodes_side = maze.nodes_side();
+    std::vector<bool> &visited_nodes = context.visited_cells;
+    visited_nodes.assign(static_cast<size_t>(n_nodes_side) * n_nodes_side, false);
+
+    // The track can't be longer than the number of nodes
+    std::vector<int> &curr_track = context.curr_track;
+    curr_track.clear();
+    curr_track.reserve(static_cast<size_t>(n_nodes_side) * n_nodes_side);
+
+    // The exit is always located onto the top or the left border, right outside of the first node to visit
+    int node_row = exit_coords[0] / 2;
+    int node_col = exit_coords[1] / 2;
+    maze.connect(node_row, node_col, exit_coords[0] == 0 ? OPEN_DIRECTION::OPEN_N : OPEN_DIRECTION::OPEN_W);
+
+    // The grid generation draws a value in order to move from the exit to its only near cell.
+    // The same value is drawn here to keep the 2 random sequences aligned
+    std::uniform_int_distribution<int> exit_cell_idx(0, 0);
+    exit_cell_idx(rng);
+
+    int curr_node = node_row * n_nodes_side + node_col;
+    visited_nodes[curr_node] = true;
+    curr_track.push_back(curr_node);
+
+    int near_nodes[4];
+    OPEN_DIRECTION near_directions[4];
+
+    // IMPORTANT:
+    // The following loop can't be parallelized as the algorithm to generate the path follows a sequential movement logic
+    while(true) {
+        int n_nodes = p_get_unvisited_near_nodes(n_nodes_side, curr_node, visited_nodes, near_nodes, near_directions);
+
+        if(n_nodes > 0) {
+            // Selects a random unvisited node and connects it to the current one
+            std::uniform_int_distribution<int> uniform_node_idx(0, n_nodes - 1);
+            int new_node_index = uniform_node_idx(rng);
+            maze.connect(curr_node / n_nodes_side, curr_node % n_nodes_side, near_directions[new_node_index]);
+
+            curr_node = near_nodes[new_node_index];
+            visited_nodes[curr_node] = true;
+            curr_track.push_back(curr_node);
+        } else {
+            // Follows the path's steps back until a new unvisited node is found
+            curr_track.pop_back();
+            if(curr_track.empty())
+                break;
+            curr_node = curr_track.back();
+        }
+    }
+}
+
+
+/**
+ * Checks for nearby unvisited nodes in order to create paths.
+ *
+ * The nodes are checked in the same order used by p_get_unvisited_near_cells for the grid's cells.
+ *
+ *  @param n_nodes_side This is the number of nodes on each maze's side.
+ *  @param curr_node This is the index of the current node for which the near unvisited nodes are being checked.
+ *  @param visited_nodes This is the vector used to keep track of all the nodes that have been visited.
+ *  @param near_nodes This array is filled with the indexes of the available nodes for joining paths.
+ *  @param near_directions This array is filled with the directions that lead to the available nodes.
+ *
+ *  @return the total count of nearby unvisited nodes.
+ */
+int p_get_unvisited_near_nodes(int n_nodes_side, int curr_node, std::vector<bool> &visited_nodes, int (&near_nodes)[4], OPEN_DIRECTION (&near_directions)[4]) {
+    int n_nodes = 0;
+    int node_row = curr_node / n_nodes_side;
+    int node_col = curr_node % n_nodes_side;
+
+    if(node_row + 1 < n_nodes_side && !visited_nodes[curr_node + n_nodes_side]) {
+        near_nodes[n_nodes] = curr_node + n_nodes_side;
+        near_directions[n_nodes++] = OPEN_DIRECTION::OPEN_S;
+    }
+    if(node_col + 1 < n_nodes_side && !visited_nodes[curr_node + 1]) {
+        near_nodes[n_nodes] = curr_node + 1;
+        near_directions[n_nodes++] = OPEN_DIRECTION::OPEN_E;
+    }
+    if(node_row > 0 && !visited_nodes[curr_node - n_nodes_side]) {
+        near_nodes[n_nodes] = curr_node - n_nodes_side;
+        near_directions[n_nodes++] = OPEN_DIRECTION::OPEN_N;
+    }
+    if(node_col > 0 && !visited_nodes[curr_node - 1]) {
+        near_nodes[n_nodes] = curr_node - 1;
+        near_directions[n_nodes++] = OPEN_DIRECTION::OPEN_W;
+    }
+
+    return n_nodes;
+}
+
+
+/**
+ * Retrieves the set a node of the current row belongs to.
+ *
+ *  The path is compressed while it is followed, so the next lookups are faster.
+ *
+ *  @param sets This is the disjoint-set forest of the current row's nodes.
+ *  @param node_col This is the column of the node.
+ *
+ *  @return the column of the set's root.
+ */
+int p_find_set(std::vector<int> &sets, int node_col) {
+    while(sets[node_col] != node_col) {
+        sets[node_col] = sets[sets[node_col]];
+        node_col = sets[node_col];
+    }
+    return node_col;
+}
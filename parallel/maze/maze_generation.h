@@ -1,26 +1,59 @@
 // Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
 
-#ifndef RANDOMMAZESOLVER_MAZE_GENERATION_H
-#define RANDOMMAZESOLVER_MAZE_GENERATION_H
+#ifndef RANDOMMAZESOLVER_PARALLEL_MAZE_GENERATION_H
+#define RANDOMMAZESOLVER_PARALLEL_MAZE_GENERATION_H
 
 #include <vector>
 #include <random>
 
+#include "../../utils/maze/maze.h"
+#include "../../utils/maze/packed_maze.h"
+
 // ENUMS AND STRUCTS
 
-/** This structure is used in order to determine the maze's inner structure and
- * the available cells for the particles' movement.
+/// Rectangular block of nodes carved independently from the other ones. The bounds are expressed in nodes.
+struct Tile {
+    int first_row;
+    int first_col;
+    int n_rows;
+    int n_cols;
+};
+
+
+/**
+ * Memory used by the depth first visits of the generation.
+ *
+ * It is kept between the executions, so that generating mazes of the same size again allocates nothing.
  */
-enum MAZE_PATH
-{
-    EMPTY = 0x0,
-    WALL = 0x1,
-    EXIT = 0x2,
-    SOLUTION = 0x3,
-    START = 0x4,
-    PARTICLE = 0x5,
+struct GeneratorContext {
+    std::vector<int> exit_coords;
+    // Cells, nodes or tiles visited so far, depending on the visit
+    std::vector<bool> visited_cells;
+    // Cells, nodes or tiles that lead from the first one to the current one
+    std::vector<int> curr_track;
+    std::vector<Tile> tiles;
+    // Visited nodes and track of the tile that is being carved by each thread
+    std::vector<std::vector<bool>> tiles_visited_nodes;
+    std::vector<std::vector<int>> tiles_tracks;
+    // State of the current row of the streamed generation
+    std::vector<uint8_t> open_masks;
+    std::vector<int> sets;
+    std::vector<int> sets_above;
+    std::vector<int> first_cols;
+    std::vector<int> remaining_nodes;
+    std::vector<uint8_t> joined_below;
 };
 
-void p_generate_square_maze(std::vector<std::vector<MAZE_PATH>> &maze, int &size, std::mt19937 generation_rng, bool parallelize);
+void p_generate_square_maze(Maze &maze, int &size, std::mt19937 generation_rng, int n_tiles_side, int n_threads, GeneratorContext &context);
+void p_generate_packed_maze(PackedMaze &maze, int &size, std::mt19937 generation_rng, GeneratorContext &context);
+void p_generate_streamed_maze(int &size, std::mt19937 generation_rng, const NodeRowSink &sink, GeneratorContext &context);
+
+// Stages of the generation, exported in order to be benchmarked one at a time
+std::vector<int> p_get_exit_coords(int &size, std::mt19937 &rng);
+void p_get_exit_coords(int &size, std::mt19937 &rng, std::vector<int> &exit_coords);
+void p_initialize_maze(Maze &maze, int &size, const std::vector<int> &exit_coords, int n_threads);
+void p_generate_paths(Maze &maze, int &size, const std::vector<int> &exit_coords, std::mt19937 &rng, GeneratorContext &context);
+int p_get_unvisited_near_cells(Maze &maze, int curr_cell, std::vector<bool> &visited_cells, int (&near_cells)[4], bool is_exit);
+void p_generate_tiled_paths(Maze &maze, int &size, int n_tiles_side, std::mt19937 &rng, int n_threads, GeneratorContext &context);
 
-#endif //RANDOMMAZESOLVER_MAZE_GENERATION_H
\ No newline at end of file
+#endif //RANDOMMAZESOLVER_PARALLEL_MAZE_GENERATION_H
\ No newline at end of file
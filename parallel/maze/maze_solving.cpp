@@ -1,153 +1,265 @@
 // Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
 
 #include <random>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <climits>
+#include <cmath>
 #include <iostream>
+#include <memory>
 #include <omp.h>
 #include "maze_solving.h"
 #include "../../utils/utils.h"
-
-
-// ENUM AND STRUCTS
-
-/// Supported movements system for particles' shifting.
-enum MOVES {
-    F = 0, // Used just for particles' initializations (frozen)
-    N = 1,
-    E = 2,
-    S = 3,
-    W = 4,
-};
-
-/// Supported coordinates system for particles' positioning and movements.
-struct Coordinates {
-    Coordinates() : row(-1), col(-1) {}
-    Coordinates(int c_x, int c_y) : row(c_x), col(c_y) {}
-
-    int row;
-    int col;
-};
-
-
-/// Struct used to represent all the particles and handle their movements inside the maze
-struct Particles {
-    std::vector<Coordinates> positions;
-    std::vector<MOVES> moves;
-    std::vector<std::vector<Coordinates>> paths;
-    int how_many;
-
-    // F is used just for particles' initializations (frozen)
-    explicit Particles(int how_many) : how_many(how_many), positions(std::vector<Coordinates>(how_many, Coordinates())), moves(std::vector<MOVES>(how_many, MOVES::F)), paths(std::vector<std::vector<Coordinates>>(how_many, std::vector<Coordinates>(0, Coordinates()))) {}
-
-    /**
-     * Allows to add new particles data to the current structure's vectors.
-     *
-     * This function updates the relative vectors' elements at the corresponding index.
-     * @param index This represents the index of the current particle values inside the vectors.
-     * @param coord
-     */
-    void addParticle(int index, Coordinates coord) {
-        this->positions[index] = coord;
-        this->paths[index].push_back(coord);
-    }
-
-
-    /**
-     * This function is used to move the particle.
-     *
-     * It allows to update the particle's coordinates and path while it moves randomly and also when backtracking
-     * it's previous movements.
-     * Backtracking is also applied when the particle needs to follow the first particle that exited the maze.
-     * @see backtrack_exited_particle.
-     *
-     * @param index This represents the index of the current particle values inside the vectors.
-     * @param new_move This represents the next particle move to implement.
-     * @param backtracking This variable indicates if the particle is going forward or backtracking the previous
-     * movements contained in the track vector.
-     */
-    void update_coordinates(int index, MOVES new_move, bool backtracking=false) {
-        switch (new_move) {
-            case MOVES::N:
-                this->positions[index] = Coordinates(this->positions[index].row - 1, this->positions[index].col);
-                break;
-            case MOVES::S:
-                this->positions[index] = Coordinates(this->positions[index].row + 1, this->positions[index].col);
-                break;
-            case MOVES::E:
-                this->positions[index] = Coordinates(this->positions[index].row, this->positions[index].col + 1);
-                break;
-            case MOVES::W:
-                this->positions[index] = Coordinates(this->positions[index].row, this->positions[index].col - 1);
-                break;
-            case MOVES::F:
-                std::cout<< "Unexpected error: the F move is meant only for particles' initialization!" << std::endl;
-                exit(1);
-        }
-
-        int path_size = static_cast<int>(this->paths[index].size());
-        // The first position is always kept
-        // Case in which the particle is backtracking or the new set position is the last but one in the track!
-        // (eventual random backtrack)
-        // This is extremely useful as it frees up memory that would be wasted as some of the contained coordinates are
-        // not relevant for the maze's solution
-        if((backtracking || path_size > 1 && this->positions[index].row == this->paths[index][path_size - 2].row && this->positions[index].col == this->paths[index][path_size - 2].col))
-            this->paths[index].pop_back();
-            // Case in which the particle has moved onto a new cell
-        else
-            this->paths[index].push_back(this->positions[index]);
-        this->moves[index] = new_move;
-    }
-};
+#include "../../utils/philox.h"
+#include "../../utils/maze/move_table.h"
+#include "../../utils/maze/move_stack.h"
+#include "../../utils/perf_counters.h"
+#include "../../utils/profiler.h"
+#include "particle_step.h"
+#include "maze_animation.h"
+
+
+// GLOBAL VARIABLES
+// Number of particles handed to the step kernel at once. Each block is moved by a single thread
+constexpr int STEP_BLOCK = 64;
+// Number of steps the threads move their own particles by, before waiting for each other during the random walk
+constexpr uint32_t WALK_ROUND_STEPS = 8;
+// Published exit when no particle has reached it yet
+constexpr uint64_t NO_EXIT = UINT64_MAX;
+// Maximum number of frames drawn each second when the steps are shown
+constexpr int ANIMATION_FPS = 30;
+// States of each cell in the aggregate simulation, one for each MOVES value that brought the particles there
+constexpr int N_CELL_STATES = 5;
 
 
 // PROTOTYPES
-std::vector<std::vector<MAZE_PATH>> p_reach_exit_randomly(std::vector<std::vector<MAZE_PATH>> &maze, int &size, Coordinates &initial_position, Particles &particles, std::mt19937 &rng, bool show_steps, bool parallelize);
-std::vector<MOVES> p_get_possible_moves(std::vector<std::vector<MAZE_PATH>> &maze, int &size, Coordinates curr_particle_pos);
-void p_backtrack_exited_particle(std::vector<std::vector<MAZE_PATH>> &maze, std::vector<std::vector<MAZE_PATH>> &maze_copy, Coordinates &initial_position, int &size, Particles &particles, const std::vector<Coordinates>& exited_particle_path, int exited_particle_index, bool show_steps, bool parallelize);
-MOVES p_get_next_move_from_path(Coordinates curr_particle_pos, Coordinates &next_coords);
+template<typename MazeLayout, typename MoveLayout> Maze &p_solve_layout(SolverContext &context, MazeLayout &maze, const MoveLayout &move_table, int size, int n_particles, std::mt19937 &solution_rng, bool show_steps, bool fast_forward, bool paint_solution, const PhaseThreads &threads, PhaseTimings &timings, PhaseCounters &counters, SolutionOutcome &outcome);
+template<typename MazeLayout> Coordinates p_spawn_position(MazeLayout &maze, int size, std::mt19937 &solution_rng);
+Philox4x32 p_movement_rng(std::mt19937 &solution_rng);
+template<typename MoveLayout> int p_walk_layout(const MoveLayout &move_table, Particles &particles, const Philox4x32 &movement_rng, uint32_t max_steps, int n_threads, WalkBuffers &buffers, MazeAnimator *animator);
+int p_choose_moves(const MoveTable &move_table, const Philox4x32 &movement_rng, uint32_t step, const Coordinates *positions, const MOVES *moves, MOVES *next_moves, int begin, int end);
+int p_choose_moves(const PackedMaze &maze, const Philox4x32 &movement_rng, uint32_t step, const Coordinates *positions, const MOVES *moves, MOVES *next_moves, int begin, int end);
+void p_publish_exit(std::atomic<uint64_t> &exit_key, uint64_t key);
+uint32_t p_walk_counts(const MoveTable &move_table, Coordinates initial_position, uint64_t n_particles, const Philox4x32 &movement_rng, uint32_t max_steps, int n_threads, OccupancyBuffers &buffers, uint64_t &exited_particles);
+double p_stirling_tail(double k);
+template<typename MazeLayout, typename MoveLayout> Maze &p_reach_exit_randomly(SolverContext &context, MazeLayout &maze, const MoveLayout &move_table, int &size, Coordinates &initial_position, const Philox4x32 &movement_rng, bool show_steps, bool fast_forward, bool paint_solution, const PhaseThreads &threads, PhaseTimings &timings, PhaseCounters &counters, SolutionOutcome &outcome);
+uint8_t p_get_possible_moves(const PackedMaze &maze, Coordinates curr_particle_pos);
+MAZE_PATH p_get_cell(const Maze &maze, Coordinates coords);
+MAZE_PATH p_get_cell(const PackedMaze &maze, Coordinates coords);
+void p_copy_maze(Maze &maze, Maze &maze_copy);
+void p_copy_maze(PackedMaze &maze, Maze &maze_copy);
 
 
 // FUNCTIONS
 
 /**
- * Used to solve the maze, by moving all the particles randomly.
+ * Used to solve the maze held by the context's grid, by moving all the particles randomly.
  *
  * After choosing a random spawn point, generates the specified amount of particles, and starts their movements logic.
  * @see p_reach_exit_randomly.
- * @param maze This is the matrix that represents the maze's structure.
+ * @param context This holds the maze to solve, along with the memory used by the solution.
  * @param size This value represents each maze's side size.
  * @param n_particles This allows to specify the number of particles to spawn.
  * @param solution_rng This is the random number engine to use in order to generate random values.
  * @param show_steps Flag used to determine if each movement step must be shown on screen.
- * @param parallelize Flag used to determine if it useful to parallelize the code inside the current function.
- * @return the matrix that represents the maze's inner structure along with the solution path.
+ * @param fast_forward Flag used to compute the outcome of the backtracking directly, when the steps are not shown.
+ * @param paint_solution Flag used to draw the maze and to store the solution path into a MAZE_PATH grid. It must be set
+ * when the steps are shown.
+ * @param threads These are the threads that run the random walk and the backtracking.
+ * @param timings These are the phases' timings of the current execution, the solution's ones are added to them.
+ * @param counters These are the performance counters of the current execution, collected only if they are enabled.
+ * @param outcome This receives the exited particle's index, the step in which it has exited and the backtracking's steps.
+ * @return the matrix that represents the maze's inner structure along with the solution path, empty if the solution
+ * is not painted.
  */
-std::vector<std::vector<MAZE_PATH>> p_solve(std::vector<std::vector<MAZE_PATH>> maze, int size, int n_particles, std::mt19937 solution_rng, bool show_steps, bool parallelize) {
-    // Choosing a random starting position
-    std::uniform_int_distribution<int> uniform_dist(size / 6, 5 * size / 6); // Guaranteed unbiased
+Maze &p_solve(SolverContext &context, int size, int n_particles, std::mt19937 solution_rng, bool show_steps, bool fast_forward, bool paint_solution, const PhaseThreads &threads, PhaseTimings &timings, PhaseCounters &counters, SolutionOutcome &outcome) {
+    PhaseClock::time_point setup_start_ts = PhaseClock::now();
 
-    // Selects an initial position
-    Coordinates initial_position = Coordinates(uniform_dist(solution_rng), uniform_dist(solution_rng));
-    while(maze[initial_position.row][initial_position.col] != MAZE_PATH::EMPTY)
-        initial_position = Coordinates(uniform_dist(solution_rng), uniform_dist(solution_rng));
+    // The moves of every cell are computed just once, instead of looking at the cells nearby at each step
+    context.move_table.build(context.maze);
+    timings.setup += elapsed_milliseconds_since(setup_start_ts);
+
+    execution_output() << "Using the " << p_step_kernel_name(p_step_kernel()) << " step kernel" << std::endl;
+    return p_solve_layout(context, context.maze, context.move_table, size, n_particles, solution_rng, show_steps, fast_forward, paint_solution, threads, timings, counters, outcome);
+}
 
-    // SoAoS
-    Particles particles(n_particles);
 
-    #pragma omp parallel for if(parallelize)
-    for(int i = 0; i < n_particles; i++) {
-        particles.addParticle(i, initial_position);
-    }
+/**
+ * Used to solve a packed maze, by moving all the particles randomly.
+ *
+ * The particles move directly onto the packed structure, and the solution's path is indexed by its own cells, so the
+ * MAZE_PATH grid is built only in order to show the maze and to store the solution path. Without painting the solution,
+ * nothing proportional to the grid is allocated.
+ * @see p_solve.
+ * @param context This holds the memory used by the solution.
+ * @param maze This is the packed structure that represents the maze's structure.
+ * @param size This value represents each maze's side size.
+ * @param n_particles This allows to specify the number of particles to spawn.
+ * @param solution_rng This is the random number engine to use in order to generate random values.
+ * @param show_steps Flag used to determine if each movement step must be shown on screen.
+ * @param fast_forward Flag used to compute the outcome of the backtracking directly, when the steps are not shown.
+ * @param paint_solution Flag used to draw the maze and to store the solution path into a MAZE_PATH grid. It must be set
+ * when the steps are shown.
+ * @param threads These are the threads that run the random walk and the backtracking.
+ * @param timings These are the phases' timings of the current execution, the solution's ones are added to them.
+ * @param counters These are the performance counters of the current execution, collected only if they are enabled.
+ * @param outcome This receives the exited particle's index, the step in which it has exited and the backtracking's steps.
+ * @return the matrix that represents the maze's inner structure along with the solution path, empty if the solution
+ * is not painted.
+ */
+Maze &p_solve(SolverContext &context, PackedMaze &maze, int size, int n_particles, std::mt19937 solution_rng, bool show_steps, bool fast_forward, bool paint_solution, const PhaseThreads &threads, PhaseTimings &timings, PhaseCounters &counters, SolutionOutcome &outcome) {
+    // The nodes' masks already hold the open directions, so the packed maze is its own move table
+    return p_solve_layout(context, maze, maze, size, n_particles, solution_rng, show_steps, fast_forward, paint_solution, threads, timings, counters, outcome);
+}
+
+
+/**
+ * Used to solve the maze held by the context's grid, by moving the number of particles onto each cell instead of each
+ * particle.
+ *
+ * All the particles spawn at the same position and follow the same rules, so they can be told apart only by their cell
+ * and by their last move. Counting the particles in each of these states makes the memory and the time of the solution
+ * depend on the maze's size only, so billions of particles can be simulated. The particles have no path: the solved
+ * maze holds just their spawn point, and there is nothing to backtrack.
+ * @see p_walk_counts.
+ * @param context This holds the maze to solve, along with the memory used by the solution.
+ * @param size This value represents each maze's side size.
+ * @param n_particles This allows to specify the number of particles to spawn.
+ * @param solution_rng This is the random number engine to use in order to generate random values.
+ * @param show_steps Flag used to determine if the maze must be shown on screen.
+ * @param threads These are the threads that run the random walk.
+ * @param timings These are the phases' timings of the current execution, the solution's ones are added to them.
+ * @param counters These are the performance counters of the current execution, collected only if they are enabled.
+ * @param outcome This receives the step in which the first particles have exited, as the particles have no index.
+ * @return the matrix that represents the maze's inner structure along with the particles' spawn point, held by the
+ * context.
+ */
+Maze &p_solve_aggregate(SolverContext &context, int size, long n_particles, std::mt19937 solution_rng, bool show_steps, const PhaseThreads &threads, PhaseTimings &timings, PhaseCounters &counters, SolutionOutcome &outcome) {
+    PhaseClock::time_point setup_start_ts = PhaseClock::now();
+    float setup_start_display = timings.display;
+
+    context.move_table.build(context.maze);
+    Coordinates initial_position = p_spawn_position(context.maze, size, solution_rng);
 
     // Initial point always shown
+    Maze &solved_maze = context.solved_maze;
+    p_copy_maze(context.maze, solved_maze);
+    solved_maze(initial_position.row, initial_position.col) = MAZE_PATH::START;
+    display_ascii_maze(solved_maze, size, show_steps, timings, context.display_buffer);
+
+    Philox4x32 movement_rng = p_movement_rng(solution_rng);
+
+    // The initial maze's print is already part of the display's phase
+    timings.setup += elapsed_milliseconds_since(setup_start_ts) - (timings.display - setup_start_display);
+
+    execution_output() << "Solving the maze with " << n_particles << " aggregated particles.." << std::endl;
+
+    uint64_t exited_particles;
+    uint32_t exit_steps;
+    {
+        PerfScope random_walk_counters(counters, "random_walk");
+        ProfileScope random_walk_profile("random_walk");
+        PhaseClock::time_point phase_start_ts = PhaseClock::now();
+
+        exit_steps = p_walk_counts(context.move_table, initial_position, static_cast<uint64_t>(std::max(n_particles, 0L)), movement_rng, UINT32_MAX, threads.random_walk, context.occupancy, exited_particles);
+        timings.random_walk += elapsed_milliseconds_since(phase_start_ts);
+    }
+    if(exited_particles > 0)
+        outcome.exit_step = exit_steps - 1;
+
+    execution_output() << "Exit reached by " << exited_particles << " particles after " << exit_steps << " steps!" << std::endl;
+
+    return solved_maze;
+}
+
+
+/**
+ * Spawns the particles at a random position and starts their movements logic.
+ *
+ * The function works with any maze's representation that provides the p_get_cell and p_copy_maze overloads, along
+ * with any move table that provides the p_choose_moves one.
+ * The particles and the maze's copies are taken from the context, so their memory is reused.
+ * @param context This holds the memory used by the solution.
+ * @param maze This is the structure that represents the maze.
+ * @param move_table This is the structure that holds the moves available onto each cell of the maze.
+ * @param size This value represents each maze's side size.
+ * @param n_particles This allows to specify the number of particles to spawn.
+ * @param solution_rng This is the random number engine to use in order to generate random values.
+ * @param show_steps Flag used to determine if each movement step must be shown on screen.
+ * @param fast_forward Flag used to compute the outcome of the backtracking directly, when the steps are not shown.
+ * @param paint_solution Flag used to draw the maze and to store the solution path into a MAZE_PATH grid.
+ * @param threads These are the threads that run the random walk and the backtracking.
+ * @param timings These are the phases' timings of the current execution, the solution's ones are added to them.
+ * @param counters These are the performance counters of the current execution, collected only if they are enabled.
+ * @param outcome This receives the exited particle's index, the step in which it has exited and the backtracking's steps.
+ * @return the matrix that represents the maze's inner structure along with the solution path, held by the context.
+ */
+template<typename MazeLayout, typename MoveLayout>
+Maze &p_solve_layout(SolverContext &context, MazeLayout &maze, const MoveLayout &move_table, int size, int n_particles, std::mt19937 &solution_rng, bool show_steps, bool fast_forward, bool paint_solution, const PhaseThreads &threads, PhaseTimings &timings, PhaseCounters &counters, SolutionOutcome &outcome) {
+    PhaseClock::time_point setup_start_ts = PhaseClock::now();
+    float setup_start_display = timings.display;
+
+    Coordinates initial_position = p_spawn_position(maze, size, solution_rng);
+
+    // SoA, the paths of the previous execution are discarded
+    context.paths_arena.reset();
+    context.particles.reset(n_particles, initial_position);
+
+    // Initial point always shown, unless the maze is not drawn at all
     // Adds the particles to the maze copy in order to show them
-    std::vector<std::vector<MAZE_PATH>> maze_copy = maze;
-    maze_copy[initial_position.row][initial_position.col] = MAZE_PATH::START;
-    display_ascii_maze(maze_copy, size, show_steps);
+    if(paint_solution) {
+        Maze &maze_copy = context.display_maze;
+        p_copy_maze(maze, maze_copy);
+        maze_copy(initial_position.row, initial_position.col) = MAZE_PATH::START;
+        display_ascii_maze(maze_copy, size, show_steps, timings, context.display_buffer);
+    }
 
-    std::cout << "Solving the maze.." << std::endl;
+    Philox4x32 movement_rng = p_movement_rng(solution_rng);
+
+    // The initial maze's print is already part of the display's phase
+    timings.setup += elapsed_milliseconds_since(setup_start_ts) - (timings.display - setup_start_display);
+
+    execution_output() << "Solving the maze.." << std::endl;
 
     // Starts the solving procedure
-    return p_reach_exit_randomly(maze, size, initial_position, particles, solution_rng, show_steps, parallelize);
+    return p_reach_exit_randomly(context, maze, move_table, size, initial_position, movement_rng, show_steps, fast_forward, paint_solution, threads, timings, counters, outcome);
+}
+
+
+/**
+ * Picks the particles' spawn position randomly, onto an empty cell in the middle of the maze.
+ *
+ * @param maze This is the structure that represents the maze.
+ * @param size This value represents each maze's side size.
+ * @param solution_rng This is the random number engine to use in order to generate random values.
+ * @return the coordinates of the spawn position.
+ */
+template<typename MazeLayout>
+Coordinates p_spawn_position(MazeLayout &maze, int size, std::mt19937 &solution_rng) {
+    // Choosing a random starting position
+    std::uniform_int_distribution<int> uniform_dist(size / 6, 5 * size / 6); // Guaranteed unbiased
+
+    // Selects an initial position
+    Coordinates initial_position = Coordinates(uniform_dist(solution_rng), uniform_dist(solution_rng));
+    while(p_get_cell(maze, initial_position) != MAZE_PATH::EMPTY)
+        initial_position = Coordinates(uniform_dist(solution_rng), uniform_dist(solution_rng));
+    return initial_position;
+}
+
+
+/**
+ * Creates the counter-based generator that drives the particles' movements.
+ *
+ * Its key is the next value of the solution's random sequence. The two halves are drawn in separate statements in
+ * order to keep their order well-defined.
+ * @param solution_rng This is the random number engine to use in order to generate random values.
+ * @return the generator of the particles' random values.
+ */
+Philox4x32 p_movement_rng(std::mt19937 &solution_rng) {
+    uint64_t movement_seed = static_cast<uint64_t>(solution_rng()) << 32;
+    movement_seed |= solution_rng();
+    return Philox4x32(movement_seed);
 }
 
 /**
@@ -155,257 +267,743 @@ std::vector<std::vector<MAZE_PATH>> p_solve(std::vector<std::vector<MAZE_PATH>>
  *
  * All the particles move around randomly until one of them reaches the maze's exit.
  * Once this happen all the remaining particles start backtracking their own steps.
+ * The random value of each particle depends only on its index and on the current step, so the threads share no
+ * generator's state and the movements do not depend on their scheduling. Every particle completes the step in which
+ * the exit is reached, and if more than one particle exits in that step, the one with the lowest index is selected.
+ * This way the solution is the same as the one found by the sequential version, with any number of threads.
+ * @param context This holds the particles, the solved maze and the memory used by the backtracking.
  * @param maze This is the matrix that represents the maze's structure.
+ * @param move_table This is the structure that holds the moves available onto each cell of the maze.
  * @param size This value represents each maze's side size.
  * @param initial_position These are the coordinates that represents the spawn position of all the particles.
- * @param particles This is the structure that contains all the particles' vectors.
- * @param rng This is the random number engine to use in order to generate random values.
+ * @param movement_rng This is the counter-based generator used in order to generate the particles' random values.
  * @param show_steps Flag used to determine if each movement step must be shown on screen.
- * @param parallelize Flag used to determine if it useful to parallelize the code inside the current function.
- * @return the matrix that represents the maze's inner structure along with the solution path.
+ * @param fast_forward Flag used to compute the outcome of the backtracking directly, when the steps are not shown.
+ * @param paint_solution Flag used to store the solution path into a MAZE_PATH grid and to show it. Otherwise the
+ * solved maze is left empty.
+ * @param threads These are the threads that run the random walk and the backtracking.
+ * @param timings These are the phases' timings of the current execution. The time spent waiting for the animation is
+ * subtracted from the phase that has shown it.
+ * @param counters These are the performance counters of the current execution, collected only if they are enabled.
+ * @param outcome This receives the exited particle's index, the step in which it has exited and the backtracking's steps.
+ * @return the matrix that represents the maze's inner structure along with the solution path, held by the context.
  */
-std::vector<std::vector<MAZE_PATH>> p_reach_exit_randomly(std::vector<std::vector<MAZE_PATH>> &maze, int &size, Coordinates &initial_position, Particles &particles, std::mt19937 &rng, bool show_steps, bool parallelize) {
-    bool exit_reached = false;
-    int exited_particle_index = -1;
-    std::vector<std::vector<MAZE_PATH>> maze_copy;
-
-    while(!exit_reached) {
-        if(show_steps)
-            // Copies the maze to show the particles positions
-            maze_copy = maze;
-
-        #pragma omp parallel for if(parallelize)
-        for(int index = 0; index < particles.how_many; index++) {
-            if(!exit_reached) {
-                 std::vector<MOVES> moves = p_get_possible_moves(maze, size, particles.positions[index]);
-                bool same_move_allowed = false;
-                for(MOVES move : moves) {
-                    // Keeps going on if it can go only on opposite directions
-                    if(moves.size() == 2 && particles.moves[index] == move) {
-                        same_move_allowed = true;
-                        particles.update_coordinates(index, move);
-                        break;
+template<typename MazeLayout, typename MoveLayout>
+Maze &p_reach_exit_randomly(SolverContext &context, MazeLayout &maze, const MoveLayout &move_table, int &size, Coordinates &initial_position, const Philox4x32 &movement_rng, bool show_steps, bool fast_forward, bool paint_solution, const PhaseThreads &threads, PhaseTimings &timings, PhaseCounters &counters, SolutionOutcome &outcome) {
+    Particles &particles = context.particles;
+    int exited_particle_index;
+
+    // The steps are drawn by another thread, which takes the particles' positions once per frame
+    // Only the first and the last frames keep the simulation waiting
+    std::unique_ptr<MazeAnimator> animator;
+    PhaseClock::time_point display_start_ts;
+    if(show_steps) {
+        display_start_ts = PhaseClock::now();
+        Maze background;
+        p_copy_maze(maze, background);
+        background(initial_position.row, initial_position.col) = MAZE_PATH::START;
+        animator = std::make_unique<MazeAnimator>(background, ANIMATION_FPS);
+        timings.display += elapsed_milliseconds_since(display_start_ts);
+    }
+
+    PhaseClock::time_point phase_start_ts;
+    {
+        PerfScope random_walk_counters(counters, "random_walk");
+        ProfileScope random_walk_profile("random_walk");
+        phase_start_ts = PhaseClock::now();
+
+        exited_particle_index = p_walk_particles(move_table, particles, movement_rng, UINT32_MAX, threads.random_walk, context.walk, animator.get());
+        timings.random_walk += elapsed_milliseconds_since(phase_start_ts);
+    }
+    outcome.exited_particle_index = exited_particle_index;
+    outcome.exit_step = context.walk.exit_step;
+
+    if(animator) {
+        display_start_ts = PhaseClock::now();
+        animator->finish(reinterpret_cast<const int *>(particles.positions.data()), particles.how_many);
+        timings.display += elapsed_milliseconds_since(display_start_ts);
+    }
+
+    phase_start_ts = PhaseClock::now();
+    std::vector<Coordinates> &exited_particle_path = context.exited_particle_path;
+    std::vector<MOVES> &exited_particle_moves = context.exited_particle_moves;
+    particles.path_coordinates(exited_particle_index, exited_particle_moves, exited_particle_path);
+
+    // The solution path is stored into the MAZE_PATH grid, only if it is going to be shown or saved
+    Maze &solved_maze = context.solved_maze;
+    if(paint_solution) {
+        p_copy_maze(maze, solved_maze);
+
+        // The solution's length is known only now, so its painting picks its own threads
+        p_paint_solution(solved_maze, exited_particle_path, p_phase_threads(SOLUTION_PAINTING_PHASE, static_cast<long>(exited_particle_path.size())));
+        solved_maze(initial_position.row, initial_position.col) = MAZE_PATH::START;
+    } else {
+        solved_maze.clear();
+    }
+    timings.solution_painting += elapsed_milliseconds_since(phase_start_ts);
+
+    // Shows the maze with the solution path
+    if(paint_solution)
+        display_ascii_maze(solved_maze, size, show_steps, timings, context.display_buffer);
+
+    execution_output() << "Exit reached!" << std::endl;
+    execution_output() << "Backtracking the exited particle.." << std::endl;
+
+    // Backtracking the first particle that went out
+    // When the steps are not shown, the outcome of the backtracking is known in advance and can be computed directly
+    int backtrack_steps;
+    {
+        PerfScope backtrack_counters(counters, "backtrack");
+        ProfileScope backtrack_profile("backtrack");
+        phase_start_ts = PhaseClock::now();
+        float phase_start_display = timings.display;
+
+        if(fast_forward && !show_steps)
+            backtrack_steps = p_fast_forward_exited_particle(particles, exited_particle_path, exited_particle_moves, exited_particle_index, threads.backtrack, context.backtrack);
+        else
+            backtrack_steps = p_backtrack_exited_particle(solved_maze, particles, exited_particle_path, exited_particle_moves, exited_particle_index, show_steps, threads.backtrack, context.backtrack, timings);
+        timings.backtrack += elapsed_milliseconds_since(phase_start_ts) - (timings.display - phase_start_display);
+    }
+    outcome.backtrack_steps = backtrack_steps;
+
+    execution_output() << "All particles have reached the exit in " << backtrack_steps << " steps!" << std::endl;
+
+    return solved_maze;
+}
+
+
+/**
+ * Moves the particles onto the move table of a MAZE_PATH grid until one of them reaches the exit.
+ *
+ * @see p_walk_layout.
+ */
+int p_walk_particles(const MoveTable &move_table, Particles &particles, const Philox4x32 &movement_rng, uint32_t max_steps, int n_threads, WalkBuffers &buffers, MazeAnimator *animator) {
+    return p_walk_layout(move_table, particles, movement_rng, max_steps, n_threads, buffers, animator);
+}
+
+
+/**
+ * Moves the particles onto a packed maze until one of them reaches the exit.
+ *
+ * @see p_walk_layout.
+ */
+int p_walk_particles(const PackedMaze &maze, Particles &particles, const Philox4x32 &movement_rng, uint32_t max_steps, int n_threads, WalkBuffers &buffers, MazeAnimator *animator) {
+    return p_walk_layout(maze, particles, movement_rng, max_steps, n_threads, buffers, animator);
+}
+
+
+/**
+ * Moves the particles until one of them reaches the exit, with a single team of threads.
+ *
+ * Each thread owns a contiguous range of particles and moves it by WALK_ROUND_STEPS steps at a time onto a copy of
+ * the positions and of the last moves, while recording the chosen moves. The first particles that reach the exit
+ * publish their step and index with an atomic minimum, and the threads stop moving their particles past that step.
+ * Once every thread has completed the round, the recorded moves are applied to the particles' positions and paths,
+ * up to the step in which the exit has been reached. In that last step only the particles up to the exited one are
+ * moved, as the sequential version moves the particles in order and stops the step as soon as one of them exits.
+ * So the threads meet once per round instead of being forked and joined at each step, and the particles end up
+ * exactly as if they had been moved one step at a time: the exited particle is still the one with the lowest index
+ * among those that exit in the first step.
+ * @param move_table This is the structure that holds the moves available onto each cell of the maze.
+ * @param particles This is the structure that contains all the particles' vectors.
+ * @param movement_rng This is the counter-based generator used in order to generate the particles' random values.
+ * @param max_steps This is the maximum number of steps the particles are moved by.
+ * @param n_threads This is the number of threads that run the code inside the current function, 1 runs it sequentially.
+ * @param buffers This holds the copies of the particles' positions and moves, and the moves recorded in each round.
+ * It also receives the step in which the exit has been reached.
+ * @param animator This draws the particles' positions at the end of each round, when the steps are shown. It can be
+ * null.
+ * @return the lowest index of the particles that have reached the exit, INT_MAX if there is none within max_steps.
+ */
+template<typename MoveLayout>
+int p_walk_layout(const MoveLayout &move_table, Particles &particles, const Philox4x32 &movement_rng, uint32_t max_steps, int n_threads, WalkBuffers &buffers, MazeAnimator *animator) {
+    int n_particles = particles.how_many;
+    if(n_particles == 0)
+        return INT_MAX;
+
+    buffers.positions.assign(particles.positions.begin(), particles.positions.end());
+    buffers.moves.assign(particles.moves.begin(), particles.moves.end());
+    buffers.round_moves.resize(static_cast<size_t>(n_particles) * WALK_ROUND_STEPS);
+
+    // Step and index of the exited particle, combined so that the lowest value is the lowest index of the first step
+    std::atomic<uint64_t> exit_key = NO_EXIT;
+
+    #pragma omp parallel num_threads(n_threads)
+    {
+        // The ranges are made of whole blocks, so that the threads never share the step kernel's blocks
+        int range_size = (n_particles + omp_get_num_threads() - 1) / omp_get_num_threads();
+        range_size = (range_size + STEP_BLOCK - 1) / STEP_BLOCK * STEP_BLOCK;
+        int range_begin = std::min(omp_get_thread_num() * range_size, n_particles);
+        int range_end = std::min(range_begin + range_size, n_particles);
+        std::array<MOVES, STEP_BLOCK> next_moves{};
+
+        for(uint32_t round_start = 0; round_start < max_steps; round_start += WALK_ROUND_STEPS) {
+            uint32_t round_end = max_steps - round_start < WALK_ROUND_STEPS ? max_steps : round_start + WALK_ROUND_STEPS;
+
+            for(uint32_t step = round_start; step < round_end; step++) {
+                // Another thread has already found the exit in an earlier step
+                if(exit_key.load(std::memory_order_relaxed) / n_particles < step)
+                    break;
+
+                int exited_particle_index = INT_MAX;
+                for(int block = range_begin; block < range_end; block += STEP_BLOCK) {
+                    int block_end = std::min(block + STEP_BLOCK, range_end);
+                    int block_exited_index = p_choose_moves(move_table, movement_rng, step, buffers.positions.data(), buffers.moves.data(), next_moves.data(), block, block_end);
+                    exited_particle_index = std::min(exited_particle_index, block_exited_index);
+
+                    for(int index = block; index < block_end; index++) {
+                        MOVES move = next_moves[index - block];
+                        buffers.positions[index].row += MOVE_ROW_DELTA[move];
+                        buffers.positions[index].col += MOVE_COL_DELTA[move];
+                        buffers.moves[index] = move;
+                        buffers.round_moves[static_cast<size_t>(index) * WALK_ROUND_STEPS + (step - round_start)] = move;
                     }
                 }
-                // The same move wasn't available because of the walls nearby
-                if(!same_move_allowed) {
-                    // Choosing a random move
-                    std::uniform_int_distribution<int> uniform_dist(0, static_cast<int>(moves.size()) - 1); // Guaranteed unbiased
-                    MOVES new_move = moves[uniform_dist(rng)];
-                    particles.update_coordinates(index, new_move);
+
+                if(exited_particle_index != INT_MAX) {
+                    p_publish_exit(exit_key, static_cast<uint64_t>(step) * n_particles + exited_particle_index);
+                    break;
                 }
+            }
+
+            #pragma omp barrier
+            // The exits of the next round can be published while the slower threads are still reading this one, but
+            // they come after its last step
+            uint64_t round_exit = exit_key.load();
+            bool exit_reached = round_exit / n_particles < round_end;
+            uint32_t round_steps = exit_reached ? static_cast<uint32_t>(round_exit / n_particles) - round_start + 1 : round_end - round_start;
+            int round_exited_index = exit_reached ? static_cast<int>(round_exit % n_particles) : INT_MAX;
+
+            for(int index = range_begin; index < range_end; index++) {
+                const MOVES *recorded_moves = &buffers.round_moves[static_cast<size_t>(index) * WALK_ROUND_STEPS];
+                // The step stops at the exited particle, so the ones after it don't take the exit step's move
+                uint32_t particle_steps = index > round_exited_index ? round_steps - 1 : round_steps;
+                for(uint32_t round_step = 0; round_step < particle_steps; round_step++)
+                    particles.update_coordinates(index, recorded_moves[round_step]);
+            }
+
+            if(exit_reached)
+                break;
+
+            // The animator reads the positions of all the particles, which are updated again only after the next round
+            if(animator) {
+                #pragma omp barrier
+                #pragma omp master
+                animator->offer(reinterpret_cast<const int *>(particles.positions.data()), particles.how_many);
+            }
+        }
+    }
+
+    uint64_t exit = exit_key.load();
+    if(exit == NO_EXIT)
+        return INT_MAX;
+
+    buffers.exit_step = static_cast<uint32_t>(exit / n_particles);
+    return static_cast<int>(exit % n_particles);
+}
 
-                if(show_steps) {
-                    // Add the particles to the maze_copy
-                    maze_copy[particles.positions[index].row][particles.positions[index].col] = MAZE_PATH::PARTICLE;
-                    #pragma omp critical
-                    // Shows the start everytime
-                    maze_copy[initial_position.row][initial_position.col] = MAZE_PATH::START;
+
+/**
+ * Chooses the next move of a block of particles onto the move table of a MAZE_PATH grid.
+ *
+ * @see p_step_particles.
+ * @param move_table This is the table that holds the moves available onto each cell of the maze.
+ * @param movement_rng This is the counter-based generator used in order to generate the particles' random values.
+ * @param step This is the current step of the movements.
+ * @param positions These are the particles' positions.
+ * @param moves These are the last moves of the particles.
+ * @param next_moves This receives the chosen moves. The move of the particle at index begin is stored at position 0.
+ * @param begin This is the index of the first particle of the block.
+ * @param end This is the index after the last particle of the block.
+ * @return the lowest index of the particles that reach the exit with their next move, INT_MAX if there is none.
+ */
+int p_choose_moves(const MoveTable &move_table, const Philox4x32 &movement_rng, uint32_t step, const Coordinates *positions, const MOVES *moves, MOVES *next_moves, int begin, int end) {
+    static_assert(sizeof(Coordinates) == 2 * sizeof(int), "The step kernels read the positions as (row, col) pairs");
+    StepInput input = {move_table.data(), move_table.stride(), &movement_rng, step};
+    return p_step_particles(p_step_kernel(), input, reinterpret_cast<const int *>(positions), moves, next_moves, begin, end);
+}
+
+
+/**
+ * Chooses the next move of a block of particles onto a packed maze.
+ *
+ * The packed maze has no table to gather from, so each particle decodes the moves of its own cell.
+ * @param maze This is the packed structure that represents the maze's structure.
+ * @param movement_rng This is the counter-based generator used in order to generate the particles' random values.
+ * @param step This is the current step of the movements.
+ * @param positions These are the particles' positions.
+ * @param moves These are the last moves of the particles.
+ * @param next_moves This receives the chosen moves. The move of the particle at index begin is stored at position 0.
+ * @param begin This is the index of the first particle of the block.
+ * @param end This is the index after the last particle of the block.
+ * @return the lowest index of the particles that reach the exit with their next move, INT_MAX if there is none.
+ */
+int p_choose_moves(const PackedMaze &maze, const Philox4x32 &movement_rng, uint32_t step, const Coordinates *positions, const MOVES *moves, MOVES *next_moves, int begin, int end) {
+    int exited_particle_index = INT_MAX;
+
+    for(int index = begin; index < end; index++) {
+        uint8_t cell_moves = p_get_possible_moves(maze, positions[index]);
+        int n_moves = moves_count(cell_moves);
+        MOVES new_move;
+        // Keeps going on if it can go only on opposite directions
+        if(n_moves == 2 && moves_mask(cell_moves) & MOVE_BIT[moves[index]]) {
+            new_move = moves[index];
+        }
+        // The same move wasn't available because of the walls nearby
+        else {
+            // Choosing a random move
+            uint32_t random_value = movement_rng.particle_value(static_cast<uint32_t>(index), step);
+            new_move = MOVES_DECODE[moves_mask(cell_moves)][bounded_index(random_value, n_moves)];
+        }
+        next_moves[index - begin] = new_move;
+
+        // The particle is going to reach the exit
+        Coordinates next_position(positions[index].row + MOVE_ROW_DELTA[new_move], positions[index].col + MOVE_COL_DELTA[new_move]);
+        if(p_get_cell(maze, next_position) == MAZE_PATH::EXIT && exited_particle_index == INT_MAX)
+            exited_particle_index = index;
+    }
+
+    return exited_particle_index;
+}
+
+
+/**
+ * Lowers the published exit to the given one, if it comes earlier.
+ *
+ * @param exit_key This is the published exit, as its step times the number of particles plus the particle's index.
+ * @param key This is the exit that has just been found.
+ */
+void p_publish_exit(std::atomic<uint64_t> &exit_key, uint64_t key) {
+    uint64_t published = exit_key.load(std::memory_order_relaxed);
+    while(key < published && !exit_key.compare_exchange_weak(published, key, std::memory_order_relaxed)) {}
+}
+
+
+/**
+ * Moves the particles' counts until some of them reach the exit, with a single team of threads.
+ *
+ * The particles that are onto the same cell and came with the same move behave all the same way: they keep going on
+ * along a corridor, otherwise each of them picks one of the cell's moves with the same probability. So at each step the
+ * count of each state either moves as a whole or it is split among the moves by a multinomial draw. Each cell draws
+ * from a stream bound to its index and to the step, so the outcome doesn't depend on the number of threads.
+ * The steps are made of two passes, so that each count is written by a single thread: first each cell splits its own
+ * particles among its moves, then each cell gathers the ones that enter it from the cells nearby. Only the box that
+ * holds the particles is visited, since they spread slowly into the maze's corridors.
+ * @param move_table This is the structure that holds the moves available onto each cell of the maze.
+ * @param initial_position These are the coordinates that represents the spawn position of all the particles.
+ * @param n_particles This is the number of particles to spawn.
+ * @param movement_rng This is the counter-based generator used in order to generate the cells' random values.
+ * @param max_steps This is the maximum number of steps the particles are moved by.
+ * @param n_threads This is the number of threads that run the code inside the current function, 1 runs it sequentially.
+ * @param buffers This holds the particles' counts and the ones that leave each cell during the current step.
+ * @param exited_particles This receives the number of particles that have reached the exit, 0 if none has within
+ * max_steps.
+ * @return the number of steps after which the first particles have reached the exit.
+ */
+uint32_t p_walk_counts(const MoveTable &move_table, Coordinates initial_position, uint64_t n_particles, const Philox4x32 &movement_rng, uint32_t max_steps, int n_threads, OccupancyBuffers &buffers, uint64_t &exited_particles) {
+    int stride = move_table.stride();
+    int n_cells = stride * stride;
+    buffers.counts.assign(static_cast<size_t>(n_cells) * N_CELL_STATES, 0);
+    buffers.outgoing.assign(static_cast<size_t>(n_cells) * N_CELL_STATES, 0);
+    exited_particles = 0;
+
+    int exit_cell = 0;
+    while(exit_cell < n_cells && !moves_exit(move_table[exit_cell]))
+        exit_cell++;
+    if(n_particles == 0 || exit_cell == n_cells)
+        return 0;
+
+    // The particles that haven't moved yet have the frozen move, which never lets them go on along a corridor
+    int initial_cell = (initial_position.row + 1) * stride + initial_position.col + 1;
+    buffers.counts[static_cast<size_t>(initial_cell) * N_CELL_STATES + MOVES::F] = n_particles;
+
+    // Offset of the cell reached by each move, as a flat index
+    std::array<int, N_CELL_STATES> move_offsets{};
+    for(int move = MOVES::N; move <= MOVES::W; move++)
+        move_offsets[move] = MOVE_ROW_DELTA[move] * stride + MOVE_COL_DELTA[move];
+
+    uint64_t *counts = buffers.counts.data();
+    uint64_t *outgoing = buffers.outgoing.data();
+    uint32_t exit_steps = 0;
+
+    // Rows and columns of the table that hold any particle. The box only grows, so the cells outside of it have never
+    // held any particle, and nothing leaves them
+    int top = initial_position.row + 1, bottom = top;
+    int left = initial_position.col + 1, right = left;
+
+    #pragma omp parallel num_threads(n_threads) if(n_threads > 1)
+    {
+        // The exited particles are counted by a single thread, before the barrier that ends each step
+        for(uint32_t step = 0; step < max_steps && exited_particles == 0; step++) {
+            // The box is updated while the cells gather their particles, so each thread reads it beforehand
+            int step_top = top, step_bottom = bottom, step_left = left, step_right = right;
+
+            // Each cell splits its own particles among its moves
+            #pragma omp for schedule(static)
+            for(int row = step_top; row <= step_bottom; row++) {
+                for(int cell = row * stride + step_left; cell <= row * stride + step_right; cell++) {
+                    const uint64_t *cell_counts = counts + static_cast<size_t>(cell) * N_CELL_STATES;
+                    uint64_t *cell_outgoing = outgoing + static_cast<size_t>(cell) * N_CELL_STATES;
+                    std::fill(cell_outgoing, cell_outgoing + N_CELL_STATES, 0);
+
+                    uint8_t cell_moves = move_table[cell];
+                    uint64_t random_particles = 0;
+                    for(int move = MOVES::F; move <= MOVES::W; move++) {
+                        // Keeps going on if it can go only on opposite directions
+                        if(moves_count(cell_moves) == 2 && moves_mask(cell_moves) & MOVE_BIT[move])
+                            cell_outgoing[move] += cell_counts[move];
+                        else
+                            random_particles += cell_counts[move];
+                    }
+
+                    if(random_particles > 0) {
+                        PhiloxStream stream(movement_rng, static_cast<uint32_t>(cell), step);
+                        p_split_count(random_particles, cell_moves, stream, cell_outgoing);
+                    }
                 }
+            }
+
+            // Each cell gathers the particles that enter it, so the box can grow by a cell on each side. The border
+            // of the table is never entered
+            #pragma omp for schedule(static) reduction(min:top, left) reduction(max:bottom, right)
+            for(int row = std::max(step_top - 1, 1); row <= std::min(step_bottom + 1, stride - 2); row++) {
+                for(int col = std::max(step_left - 1, 1); col <= std::min(step_right + 1, stride - 2); col++) {
+                    int cell = row * stride + col;
+                    uint64_t *cell_counts = counts + static_cast<size_t>(cell) * N_CELL_STATES;
+                    uint64_t cell_particles = 0;
+                    cell_counts[MOVES::F] = 0;
+                    for(int move = MOVES::N; move <= MOVES::W; move++) {
+                        cell_counts[move] = outgoing[static_cast<size_t>(cell - move_offsets[move]) * N_CELL_STATES + move];
+                        cell_particles += cell_counts[move];
+                    }
 
-                // The particle has reached the exit
-                if(maze[particles.positions[index].row][particles.positions[index].col] == MAZE_PATH::EXIT) {
-                    #pragma omp critical
-                    {
-                        exited_particle_index = index;
-                        exit_reached = true;
-                    };
+                    if(cell_particles > 0) {
+                        top = std::min(top, row);
+                        bottom = std::max(bottom, row);
+                        left = std::min(left, col);
+                        right = std::max(right, col);
+                    }
                 }
             }
+
+            #pragma omp single
+            {
+                for(int move = MOVES::N; move <= MOVES::W; move++)
+                    exited_particles += counts[static_cast<size_t>(exit_cell) * N_CELL_STATES + move];
+                exit_steps = step + 1;
+            }
         }
+    }
+
+    return exited_particles > 0 ? exit_steps : 0;
+}
 
-        if(show_steps && !maze_copy.empty())
-            // Displays the particles in the maze
-            display_ascii_maze(maze_copy, size, show_steps);
 
+/**
+ * Splits the particles that pick a random move among the moves of their cell, with the same probability each.
+ *
+ * The multinomial draw is made of a binomial one for each move but the last, which takes the remaining particles.
+ * @param count This is the number of particles to split.
+ * @param cell_moves This is the encoded cell the particles are onto.
+ * @param stream This is the stream of random values bound to the cell and to the current step.
+ * @param cell_outgoing This receives the particles that leave the cell with each move, indexed by the MOVES value.
+ */
+void p_split_count(uint64_t count, uint8_t cell_moves, PhiloxStream &stream, uint64_t *cell_outgoing) {
+    int n_moves = moves_count(cell_moves);
+    const std::array<MOVES, 4> &moves = MOVES_DECODE[moves_mask(cell_moves)];
+
+    for(int move = 0; move < n_moves - 1 && count > 0; move++) {
+        uint64_t moving = p_draw_binomial(count, 1.0 / (n_moves - move), stream);
+        cell_outgoing[moves[move]] += moving;
+        count -= moving;
     }
+    cell_outgoing[moves[n_moves - 1]] += count;
+}
 
-    std::vector<Coordinates> exited_particle_path = particles.paths[exited_particle_index];
 
-    #pragma omp parallel for if(exited_particle_path.size() / omp_get_max_threads() > 100)
-    // Shows the maze's path that lead to the solution
-    for(Coordinates coord : exited_particle_path) {
-        maze[coord.row][coord.col] = MAZE_PATH::SOLUTION;
+/**
+ * Draws the number of successes out of count trials, each one with the given probability.
+ *
+ * When the expected successes are few, the gaps between them are drawn from a geometric distribution. Otherwise the
+ * Hormann's transformed rejection with squeeze (BTRS) is used, which accepts most of its candidates without computing
+ * any logarithm. Unlike std::binomial_distribution, no logarithm of the gamma function is needed.
+ * @param count This is the number of trials.
+ * @param probability This is the probability of each trial's success, at most 0.5.
+ * @param stream This is the stream of random values to draw from.
+ * @return the number of successes.
+ */
+uint64_t p_draw_binomial(uint64_t count, double probability, PhiloxStream &stream) {
+    double n = static_cast<double>(count);
+
+    if(n * probability < 10) {
+        double log_failure = std::log1p(-probability);
+        double trials = 0;
+        uint64_t successes = 0;
+        while(true) {
+            trials += std::ceil(std::log(open_unit_value(stream())) / log_failure);
+            if(trials > n)
+                return successes;
+            successes++;
+        }
     }
-    maze[initial_position.row][initial_position.col] = MAZE_PATH::START;
-
-    // Shows the maze with the solution path
-    display_ascii_maze(maze, size, show_steps);
 
-    std::cout << "Exit reached!" << std::endl;
-    std::cout << "Backtracking the exited particle.." << std::endl;
+    double deviation = std::sqrt(n * probability * (1 - probability));
+    double b = 1.15 + 2.53 * deviation;
+    double a = -0.0873 + 0.0248 * b + 0.01 * probability;
+    double c = n * probability + 0.5;
+    double v_r = 0.92 - 4.2 / b;
+    double odds = probability / (1 - probability);
+    double alpha = (2.83 + 5.1 / b) * deviation;
+    double mode = std::floor((n + 1) * probability);
+
+    while(true) {
+        double u = open_unit_value(stream()) - 0.5;
+        double v = open_unit_value(stream());
+        double us = 0.5 - std::abs(u);
+        double k = std::floor((2 * a / us + b) * u + c);
+        if(k < 0 || k > n)
+            continue;
+        // The candidates inside the squeeze are accepted right away
+        if(us >= 0.07 && v <= v_r)
+            return static_cast<uint64_t>(k);
+
+        v = std::log(v * alpha / (a / (us * us) + b));
+        double bound = (mode + 0.5) * std::log((mode + 1) / (odds * (n - mode + 1))) +
+                       (n + 1) * std::log((n - mode + 1) / (n - k + 1)) +
+                       (k + 0.5) * std::log(odds * (n - k + 1) / (k + 1)) +
+                       p_stirling_tail(mode) + p_stirling_tail(n - mode) - p_stirling_tail(k) - p_stirling_tail(n - k);
+        if(v <= bound)
+            return static_cast<uint64_t>(k);
+    }
+}
 
-    // Backtracking the first particle that went out
-    p_backtrack_exited_particle(maze, maze_copy, initial_position, size, particles, exited_particle_path, exited_particle_index, show_steps, parallelize);
 
+/**
+ * Computes the error of the Stirling's approximation of log(k!).
+ *
+ * @param k This is the non-negative integer whose factorial is approximated.
+ * @return the difference between log(k!) and its approximation.
+ */
+double p_stirling_tail(double k) {
+    static constexpr std::array<double, 10> SMALL_TAILS = {0.0810614667953272, 0.0413406959554092, 0.0276779256849983,
+                                                           0.02079067210376509, 0.0166446911898211, 0.0138761288230707,
+                                                           0.0118967099458917, 0.0104112652619720, 0.00925546218271273,
+                                                           0.00833056343336287};
+    if(k <= 9)
+        return SMALL_TAILS[static_cast<int>(k)];
+
+    double squared = (k + 1) * (k + 1);
+    return (1.0 / 12 - (1.0 / 360 - 1.0 / 1260 / squared) / squared) / (k + 1);
+}
 
-    std::cout << "All particles have reached the exit!" << std::endl;
 
-    return maze;
+/**
+ * This function is used to determine the available moves for the current particle inside a packed maze.
+ *
+ * The moves are encoded from the open directions of the particle's cell, in the same format used by the move table.
+ * @param maze This is the packed structure that represents the maze's structure.
+ * @param curr_particle_pos This is the position of the current particle for which the moves are being evaluated.
+ * @return the encoded moves of the cell, to be decoded with moves_mask, moves_count and MOVES_DECODE.
+ */
+uint8_t p_get_possible_moves(const PackedMaze &maze, Coordinates curr_particle_pos) {
+    return encode_moves(maze.moves(curr_particle_pos.row, curr_particle_pos.col));
 }
 
 
 /**
- * This function is used to determine the available moves for the current particle.
+ * Reads the content of a maze's cell.
  *
- * The moves are selected based onto the state of the cells nearby in the maze.
- * If a near cell does not contain a wall, then it represent a possible move.
  * @param maze This is the matrix that represents the maze's structure.
- * @param size This value represents each maze's side size.
- * @param curr_particle_pos This is the position of the current particle for which the moves are being evaluated.
- * @return A vector of moves representing the next possible shifts of the current particle.
+ * @param coords These are the coordinates of the cell.
+ * @return the value of the cell.
  */
-std::vector<MOVES> p_get_possible_moves(std::vector<std::vector<MAZE_PATH>> &maze, int &size, Coordinates curr_particle_pos) {
-    std::vector<MOVES> moves;
-    moves.reserve(4);
+MAZE_PATH p_get_cell(const Maze &maze, Coordinates coords) {
+    return maze(coords.row, coords.col);
+}
 
-    if(-1 < curr_particle_pos.row - 1 < size && maze[curr_particle_pos.row - 1][curr_particle_pos.col] != MAZE_PATH::WALL)
-        moves.push_back(MOVES::N);
 
-    if(-1 < curr_particle_pos.row + 1 < size && maze[curr_particle_pos.row + 1][curr_particle_pos.col] != MAZE_PATH::WALL)
-        moves.push_back(MOVES::S);
+/**
+ * Reads the content of a packed maze's cell, as it would be stored into the MAZE_PATH grid.
+ *
+ * @param maze This is the packed structure that represents the maze's structure.
+ * @param coords These are the coordinates of the cell.
+ * @return the value of the cell.
+ */
+MAZE_PATH p_get_cell(const PackedMaze &maze, Coordinates coords) {
+    return maze.cell(coords.row, coords.col);
+}
 
-    if(-1 < curr_particle_pos.col - 1 < size && maze[curr_particle_pos.row][curr_particle_pos.col - 1] != MAZE_PATH::WALL)
-        moves.push_back(MOVES::W);
 
-    if(-1 < curr_particle_pos.col + 1 < size && maze[curr_particle_pos.row][curr_particle_pos.col + 1] != MAZE_PATH::WALL)
-        moves.push_back(MOVES::E);
+/**
+ * Copies the maze's structure into a MAZE_PATH grid, used for printing purposes and to store the solution.
+ *
+ * @param maze This is the matrix that represents the maze's structure.
+ * @param maze_copy This is the matrix that receives the copy.
+ */
+void p_copy_maze(Maze &maze, Maze &maze_copy) {
+    maze_copy = maze;
+}
 
-    return moves;
+
+/**
+ * Expands a packed maze into a MAZE_PATH grid, used for printing purposes and to store the solution.
+ *
+ * @param maze This is the packed structure that represents the maze's structure.
+ * @param maze_copy This is the matrix that receives the expanded maze.
+ */
+void p_copy_maze(PackedMaze &maze, Maze &maze_copy) {
+    maze.to_maze(maze_copy);
 }
 
 /**
  * This function is called once a particle has managed to exit the maze.
  *
  * The remaining particles backtrack their own previous steps until they end up onto the solution's path.
- * Once they are on the right track, their path is replaced by the remaining steps followed by the exited particle and
- * they starts to backtrack them until they exit.
- * @param maze This is the matrix that represents the maze's structure.
- * @param maze_copy This matrix is used only for printing purposes to not alter the maze itself.
- * @param initial_position These are the coordinates that represents the spawn position of all the particles.
- * @param size This value represents each maze's side size.
+ * Once they are on the right track, they follow the remaining moves of the exited particle until they exit.
+ * The solution's path is shared by all the particles: each cell of the path is mapped to its position onto it, so
+ * checking if a particle is on the track takes a single lookup, and each particle on the track just keeps a cursor to
+ * its position onto the path.
+ * @param maze This is the matrix that represents the maze's structure, along with the solution path and the start.
+ * It is used only to show the steps.
  * @param particles This is the structure that contains all the particles' vectors.
  * @param exited_particle_path This vector contains the steps required to reach the exit starting from the initial position.
+ * @param exited_particle_moves This vector contains the moves that lead from each step of the path to the next one.
  * @param exited_particle_index This integer number represents the exited particle's index related to the particles' vector.
  * @param show_steps Flag used to determine if each movement step must be shown on screen.
- * @param parallelize Flag used to determine if it useful to parallelize the code inside the current function.
+ * @param n_threads This is the number of threads that run the code inside the current function, 1 runs it sequentially.
+ * @param buffers This holds the memory used by the path's index and by the particles' cursors.
+ * @param timings These are the phases' timings of the current execution, the animation's first and last frames are
+ * added to them.
+ * @return the number of steps required for all the particles to exit.
  */
-void p_backtrack_exited_particle(std::vector<std::vector<MAZE_PATH>> &maze, std::vector<std::vector<MAZE_PATH>> &maze_copy, Coordinates &initial_position, int &size, Particles &particles, const std::vector<Coordinates>& exited_particle_path, int exited_particle_index, bool show_steps, bool parallelize) {
+int p_backtrack_exited_particle(Maze &maze, Particles &particles, const std::vector<Coordinates>& exited_particle_path, const std::vector<MOVES>& exited_particle_moves, int exited_particle_index, bool show_steps, int n_threads, BacktrackBuffers &buffers, PhaseTimings &timings) {
     int n_particles = static_cast<int>(particles.how_many);
-    std::vector<bool> particles_on_track_map;
-    particles_on_track_map.reserve(n_particles);
-    std::vector<bool> exited_particles_map;
-    exited_particles_map.reserve(n_particles);
-
-    #pragma omp parallel for if(parallelize)
-    // Initializes the 2 maps elements to false
-    for(int index = 0; index < n_particles; index++) {
-        particles_on_track_map[index]= false;
-        exited_particles_map[index] = false;
-    }
+    int solution_length = static_cast<int>(exited_particle_moves.size());
+
+    PathIndex &solution_index = buffers.solution_index;
+    solution_index.build(exited_particle_path);
 
-    particles_on_track_map[exited_particle_index] = true;
+    // Position of each particle onto the solution's path, -1 until the particle is on the track
+    std::vector<int> &cursors = buffers.cursors;
+    cursors.assign(n_particles, -1);
+    std::vector<uint8_t> &exited_particles_map = buffers.exited_particles_map;
+    exited_particles_map.assign(n_particles, false);
+
+    cursors[exited_particle_index] = solution_length;
     exited_particles_map[exited_particle_index] = true;
 
     int n_exited_particles = 1;
-    maze_copy.clear();
+    int steps = 0;
+
+    std::unique_ptr<MazeAnimator> animator;
+    PhaseClock::time_point display_start_ts;
+    if(show_steps) {
+        display_start_ts = PhaseClock::now();
+        animator = std::make_unique<MazeAnimator>(maze, ANIMATION_FPS);
+        timings.display += elapsed_milliseconds_since(display_start_ts);
+    }
 
     while(n_exited_particles < particles.how_many) {
-        if(show_steps) {
-            // Resets the maze to show the steps
-            maze_copy = maze;
-            maze_copy[initial_position.row][initial_position.col] = MAZE_PATH::START;
-        }
+        steps++;
 
-        #pragma omp parallel for if(parallelize)
+        #pragma omp parallel for num_threads(n_threads) if(n_threads > 1) reduction(+:n_exited_particles)
         // Backtracking the particles movements until they are on the solution path
         // After that they follow the first exited particle's movements
         for(int particle_index = 0; particle_index < n_particles; particle_index++) {
             if(!exited_particles_map[particle_index]) {
                 // If the particle wasn't on the solution path in the previous iteration checks if it is now
-                if(!particles_on_track_map[particle_index]) {
-                    for(int path_index = 0; path_index < exited_particle_path.size(); path_index++) {
-                        Coordinates coord = exited_particle_path[path_index];
-                        // The particle is now onto the right track
-                        if(particles.positions[particle_index].row == coord.row && particles.positions[particle_index].col == coord.col) {
-                            particles_on_track_map[particle_index] = true;
-                            // Since indexes start from 0 an index of 5 means that we need to skip 6 elements, so + 1
-                            // + 2 in the end as we need to skip the current position (already equal to the path index's one)
-                            particles.paths[particle_index].clear();
-                            int remaining_path_size = static_cast<int>(exited_particle_path.size());
-                            particles.paths[particle_index].reserve(remaining_path_size);
-
-                            // Assigns the remaining correct steps to the current particle, in reverse order (useful for
-                            // using the "update_coordinates" function as it is)
-                            for(int index = remaining_path_size - 1; index > path_index; index--) {
-                                particles.paths[particle_index].push_back(exited_particle_path[index]);
-                            }
-                            break;
-                        }
+                if(cursors[particle_index] < 0)
+                    cursors[particle_index] = solution_index.find(particles.positions[particle_index]);
+
+                if(cursors[particle_index] >= 0) {
+                    // Following the solution's path
+                    if(cursors[particle_index] < solution_length) {
+                        particles.update_position(particle_index, exited_particle_moves[cursors[particle_index]]);
+                        cursors[particle_index]++;
+                    } else {
+                        n_exited_particles += 1;
+                        exited_particles_map[particle_index] = true;
                     }
+                } else {
+                    // Following the particle's steps back. The top of the stack is the move that led to the current
+                    // position
+                    MOVES last_move = particles.paths_arena.top(particles.paths[particle_index]);
+                    particles.update_coordinates(particle_index, MOVE_OPPOSITE[last_move], true);
                 }
+            }
+        }
 
-                // Following the particle's steps back
-                if(!particles.paths[particle_index].empty()) {
-                    Coordinates next_coords = particles.paths[particle_index].back();
-                    if(next_coords.row == particles.positions[particle_index].row && next_coords.col == particles.positions[particle_index].col) {
-                        particles.paths[particle_index].pop_back();
-                        next_coords = particles.paths[particle_index].back();
-                    }
-                    particles.update_coordinates(particle_index, p_get_next_move_from_path(particles.positions[particle_index], next_coords), true);
+        if(animator)
+            animator->offer(reinterpret_cast<const int *>(particles.positions.data()), particles.how_many);
+    }
+    if(animator) {
+        display_start_ts = PhaseClock::now();
+        animator->finish(reinterpret_cast<const int *>(particles.positions.data()), particles.how_many);
+        timings.display += elapsed_milliseconds_since(display_start_ts);
+    }
+    return steps;
+}
 
-                    // Displays the particle's steps
-                    if(show_steps) {
-                        maze_copy[particles.positions[particle_index].row][particles.positions[particle_index].col] = MAZE_PATH::PARTICLE;
-                    }
-                } else if (!exited_particles_map[particle_index]){
-                    #pragma omp critical
-                    n_exited_particles += 1;
-                    exited_particles_map[particle_index] = true;
-                }
-            } else {
-                // Displays the particle's position
-                if(show_steps) {
-                    maze_copy[particles.positions[particle_index].row][particles.positions[particle_index].col] = MAZE_PATH::PARTICLE;
-                }
-            }
+
+/**
+ * Computes the outcome of the backtracking without simulating it step by step.
+ *
+ * Each particle unwinds its own path until it reaches a cell of the solution's path, then it would follow the
+ * remaining moves of the exited particle. So a particle that joins the path at index k after b steps back is counted
+ * as exited at the step b + (L - k) + 1, where L is the number of the solution's moves, exactly as in
+ * p_backtrack_exited_particle. The particles are processed independently and are all left onto the exit.
+ * @param particles This is the structure that contains all the particles' vectors.
+ * @param exited_particle_path This vector contains the steps required to reach the exit starting from the initial position.
+ * @param exited_particle_moves This vector contains the moves that lead from each step of the path to the next one.
+ * @param exited_particle_index This integer number represents the exited particle's index related to the particles' vector.
+ * @param n_threads This is the number of threads that run the code inside the current function, 1 runs it sequentially.
+ * @param buffers This holds the memory used by the path's index.
+ * @return the number of steps required for all the particles to exit.
+ */
+int p_fast_forward_exited_particle(Particles &particles, const std::vector<Coordinates>& exited_particle_path, const std::vector<MOVES>& exited_particle_moves, int exited_particle_index, int n_threads, BacktrackBuffers &buffers) {
+    int solution_length = static_cast<int>(exited_particle_moves.size());
+    PathIndex &solution_index = buffers.solution_index;
+    solution_index.build(exited_particle_path);
+    int steps = 0;
+
+    #pragma omp parallel for num_threads(n_threads) if(n_threads > 1) reduction(max:steps)
+    for(int particle_index = 0; particle_index < particles.how_many; particle_index++) {
+        if(particle_index == exited_particle_index)
+            continue;
+
+        // Unwinds the particle's path until it ends up onto the solution's path
+        int steps_back = 0;
+        int path_index = solution_index.find(particles.positions[particle_index]);
+        while(path_index < 0) {
+            MOVES last_move = particles.paths_arena.top(particles.paths[particle_index]);
+            particles.update_coordinates(particle_index, MOVE_OPPOSITE[last_move], true);
+            path_index = solution_index.find(particles.positions[particle_index]);
+            steps_back++;
         }
 
-        if(show_steps)
-            display_ascii_maze(maze_copy, size, show_steps);
+        // Follows the remaining moves of the solution at once
+        if(path_index < solution_length)
+            particles.moves[particle_index] = exited_particle_moves.back();
+        particles.positions[particle_index] = exited_particle_path.back();
+
+        steps = std::max(steps, steps_back + solution_length - path_index + 1);
     }
-//    for(Particle particle : particles) {
-//        std::cout << particle.pos.row << " nn " << particle.pos.col << std::endl;
-//        if(particle.pos.row != exited_particle_path.back().row || particle.pos.col != exited_particle_path.back().col) {
-//            std::cout << "Wrong" << std::endl;
-//            exit(0);
-//        }
-//    }
+
+    return steps;
 }
 
 
 /**
- * This function is used while backtracking in order to get the next move for the current particle while backtracking.
+ * Shows the maze's path that lead to the solution.
  *
- * It checks the difference between the current particle's position and it's new coordinates in order to discover
- * it's next move.
- * @param curr_particle_pos This is the position of the current particle for which the move is being evaluated.
- * @param next_coords This are the next particle's coordinates.
- * @return The move that the particle has to perform in order to keep backtracking and reach the exit.
+ * @param maze This is the matrix that represents the maze's structure, which receives the solution's path.
+ * @param exited_particle_path This vector contains the steps required to reach the exit starting from the initial position.
+ * @param n_threads This is the number of threads that run the code inside the current function, 1 runs it sequentially.
  */
-MOVES p_get_next_move_from_path(Coordinates curr_particle_pos, Coordinates &next_coords) {
-    if(next_coords.row == curr_particle_pos.row)
-        // The next position is to the right
-        if(next_coords.col > curr_particle_pos.col)
-            return MOVES::E;
-        // The next position i on the left
-        else
-            return MOVES::W;
-    else
-        // The next position is below
-        if(next_coords.row > curr_particle_pos.row)
-            return MOVES::S;
-        // The next position is above
-        else
-            return MOVES::N;
-}
\ No newline at end of file
+void p_paint_solution(Maze &maze, const std::vector<Coordinates>& exited_particle_path, int n_threads) {
+    #pragma omp parallel for num_threads(n_threads) if(n_threads > 1)
+    for(int path_index = 0; path_index < static_cast<int>(exited_particle_path.size()); path_index++) {
+        maze(exited_particle_path[path_index].row, exited_particle_path[path_index].col) = MAZE_PATH::SOLUTION;
+    }
+}
+
@@ -1,11 +1,34 @@
 // Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
 
-#ifndef RANDOMMAZESOLVER_MAZE_SOLVING_H
-#define RANDOMMAZESOLVER_MAZE_SOLVING_H
+#ifndef RANDOMMAZESOLVER_PARALLEL_MAZE_SOLVING_H
+#define RANDOMMAZESOLVER_PARALLEL_MAZE_SOLVING_H
 
 #include <vector>
 #include "maze_generation.h"
+#include "particles.h"
+#include "solver_context.h"
+#include "../thresholds.h"
+#include "../../utils/philox.h"
+#include "../../utils/phase_timings.h"
+#include "../../utils/perf_counters.h"
+#include "../../utils/solution_outcome.h"
+#include "../../utils/maze/move_table.h"
 
-std::vector<std::vector<MAZE_PATH>> p_solve(std::vector<std::vector<MAZE_PATH>> maze, int size, int n_particles, std::mt19937 solution_rng, bool show_steps, bool parallelize);
+class MazeAnimator;
 
-#endif //RANDOMMAZESOLVER_MAZE_SOLVING_H
+Maze &p_solve(SolverContext &context, int size, int n_particles, std::mt19937 solution_rng, bool show_steps, bool fast_forward, bool paint_solution, const PhaseThreads &threads, PhaseTimings &timings, PhaseCounters &counters, SolutionOutcome &outcome);
+Maze &p_solve(SolverContext &context, PackedMaze &maze, int size, int n_particles, std::mt19937 solution_rng, bool show_steps, bool fast_forward, bool paint_solution, const PhaseThreads &threads, PhaseTimings &timings, PhaseCounters &counters, SolutionOutcome &outcome);
+Maze &p_solve_aggregate(SolverContext &context, int size, long n_particles, std::mt19937 solution_rng, bool show_steps, const PhaseThreads &threads, PhaseTimings &timings, PhaseCounters &counters, SolutionOutcome &outcome);
+
+// Stages of the solution, exported in order to be benchmarked one at a time
+int p_walk_particles(const MoveTable &move_table, Particles &particles, const Philox4x32 &movement_rng, uint32_t max_steps, int n_threads, WalkBuffers &buffers, MazeAnimator *animator);
+int p_walk_particles(const PackedMaze &maze, Particles &particles, const Philox4x32 &movement_rng, uint32_t max_steps, int n_threads, WalkBuffers &buffers, MazeAnimator *animator);
+int p_backtrack_exited_particle(Maze &maze, Particles &particles, const std::vector<Coordinates>& exited_particle_path, const std::vector<MOVES>& exited_particle_moves, int exited_particle_index, bool show_steps, int n_threads, BacktrackBuffers &buffers, PhaseTimings &timings);
+int p_fast_forward_exited_particle(Particles &particles, const std::vector<Coordinates>& exited_particle_path, const std::vector<MOVES>& exited_particle_moves, int exited_particle_index, int n_threads, BacktrackBuffers &buffers);
+void p_paint_solution(Maze &maze, const std::vector<Coordinates>& exited_particle_path, int n_threads);
+
+// Draws of the aggregate simulation, exported in order to be tested
+void p_split_count(uint64_t count, uint8_t cell_moves, PhiloxStream &stream, uint64_t *cell_outgoing);
+uint64_t p_draw_binomial(uint64_t count, double probability, PhiloxStream &stream);
+
+#endif //RANDOMMAZESOLVER_PARALLEL_MAZE_SOLVING_H
@@ -0,0 +1,310 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#include <array>
+#include <climits>
+#include "particle_step.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define P_STEP_X86
+#endif
+
+
+// PROTOTYPES
+int p_step_particles_scalar(const StepInput &input, const int *positions, const MOVES *moves, MOVES *next_moves, int begin, int end);
+#ifdef P_STEP_X86
+int p_step_particles_sse2(const StepInput &input, const int *positions, const MOVES *moves, MOVES *next_moves, int begin, int end);
+int p_step_particles_avx2(const StepInput &input, const int *positions, const MOVES *moves, MOVES *next_moves, int begin, int end);
+#endif
+
+
+// GLOBAL VARIABLES
+/// MOVES_DECODE widened to 32-bit values and flattened as mask * 4 + slot, so that it can be gathered.
+alignas(32) static const std::array<int, 64> MOVES_DECODE_32 = [] {
+    std::array<int, 64> decode{};
+    for(int mask = 0; mask < 16; mask++)
+        for(int slot = 0; slot < 4; slot++)
+            decode[mask * 4 + slot] = MOVES_DECODE[mask][slot];
+    return decode;
+}();
+
+
+// FUNCTIONS
+
+/**
+ * Detects the fastest particles' step implementation supported by the current CPU.
+ *
+ * The detection is performed only once, at the first call.
+ * @return the kernel to use for the particles' step.
+ */
+STEP_KERNEL p_step_kernel() {
+    static const STEP_KERNEL kernel = [] {
+        #ifdef P_STEP_X86
+            __builtin_cpu_init();
+            if(__builtin_cpu_supports("avx2"))
+                return STEP_KERNEL::AVX2;
+            if(__builtin_cpu_supports("sse2"))
+                return STEP_KERNEL::SSE2;
+        #endif
+        return STEP_KERNEL::SCALAR;
+    }();
+    return kernel;
+}
+
+
+/**
+ * Retrieves a printable name of the given kernel.
+ *
+ * @param kernel This is the kernel used for the particles' step.
+ * @return the name of the kernel.
+ */
+const char *p_step_kernel_name(STEP_KERNEL kernel) {
+    switch (kernel) {
+        case STEP_KERNEL::AVX2:
+            return "AVX2";
+        case STEP_KERNEL::SSE2:
+            return "SSE2";
+        default:
+            return "scalar";
+    }
+}
+
+
+/**
+ * Chooses the next move of a range of particles and checks if any of them reaches the exit.
+ *
+ * Each particle keeps going on if its cell is a corridor that allows its last move, otherwise it picks one of the
+ * available moves with the random value bound to its index and to the current step. All the kernels follow exactly
+ * the same rules, so they always choose the same moves.
+ * The particles' positions and paths are not updated here: the moves are only written into next_moves.
+ * @param kernel This is the implementation to use.
+ * @param input These are the values shared by all the particles in the current step.
+ * @param positions These are the particles' positions, stored as interleaved (row, col) pairs.
+ * @param moves These are the last moves of the particles.
+ * @param next_moves This receives the chosen moves. The move of the particle at index begin is stored at position 0.
+ * @param begin This is the index of the first particle of the range.
+ * @param end This is the index after the last particle of the range.
+ * @return the lowest index of the particles that reach the exit with their next move, INT_MAX if there is none.
+ */
+int p_step_particles(STEP_KERNEL kernel, const StepInput &input, const int *positions, const MOVES *moves, MOVES *next_moves, int begin, int end) {
+    switch (kernel) {
+        #ifdef P_STEP_X86
+        case STEP_KERNEL::AVX2:
+            return p_step_particles_avx2(input, positions, moves, next_moves, begin, end);
+        case STEP_KERNEL::SSE2:
+            return p_step_particles_sse2(input, positions, moves, next_moves, begin, end);
+        #endif
+        default:
+            return p_step_particles_scalar(input, positions, moves, next_moves, begin, end);
+    }
+}
+
+
+/**
+ * Portable implementation of the particles' step, that handles a particle at a time.
+ *
+ * It is also used for the particles left over by the vectorized kernels.
+ * @see p_step_particles.
+ */
+int p_step_particles_scalar(const StepInput &input, const int *positions, const MOVES *moves, MOVES *next_moves, int begin, int end) {
+    const std::array<int, 5> deltas = {0, -input.stride, 1, input.stride, -1};
+    int exited_particle_index = INT_MAX;
+
+    for(int index = begin; index < end; index++) {
+        int cell = (positions[2 * index] + 1) * input.stride + positions[2 * index + 1] + 1;
+        uint8_t moves_cell = input.move_table[cell];
+        int n_moves = moves_count(moves_cell);
+
+        // Keeps going on if it can go only on opposite directions
+        bool keep_move = n_moves == 2 && moves_mask(moves_cell) & MOVE_BIT[moves[index]];
+        uint32_t random_value = input.movement_rng->particle_value(static_cast<uint32_t>(index), input.step);
+        MOVES random_move = MOVES_DECODE[moves_mask(moves_cell)][bounded_index(random_value, n_moves)];
+        MOVES next_move = keep_move ? moves[index] : random_move;
+        next_moves[index - begin] = next_move;
+
+        // The particle is going to reach the exit
+        if(moves_exit(input.move_table[cell + deltas[next_move]]) && exited_particle_index == INT_MAX)
+            exited_particle_index = index;
+    }
+
+    return exited_particle_index;
+}
+
+
+#ifdef P_STEP_X86
+
+/**
+ * Multiplies 4 lanes of 32-bit values and splits the 64-bit products into their 2 halves.
+ *
+ * @param a These are the values to multiply.
+ * @param b These are the multipliers.
+ * @param hi This receives the high halves of the products.
+ * @param lo This receives the low halves of the products.
+ */
+__attribute__((target("sse2")))
+static inline void p_multiply_sse2(__m128i a, __m128i b, __m128i &hi, __m128i &lo) {
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    lo = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+    hi = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 3, 1)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 3, 1)));
+}
+
+
+/**
+ * Multiplies 8 lanes of 32-bit values and keeps the high halves of the 64-bit products.
+ *
+ * @param a These are the values to multiply.
+ * @param b These are the multipliers.
+ * @return the high halves of the products.
+ */
+__attribute__((target("avx2")))
+static inline __m256i p_multiply_hi_avx2(__m256i a, __m256i b) {
+    __m256i even = _mm256_mul_epu32(a, b);
+    __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+    return _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+}
+
+
+/**
+ * SSE2 implementation of the particles' step.
+ *
+ * SSE2 has no gathers, so the move table is read a lane at a time, while the random values of 4 particles are
+ * computed together. They are the most expensive part of the step.
+ * @see p_step_particles.
+ */
+__attribute__((target("sse2")))
+int p_step_particles_sse2(const StepInput &input, const int *positions, const MOVES *moves, MOVES *next_moves, int begin, int end) {
+    const std::array<int, 5> deltas = {0, -input.stride, 1, input.stride, -1};
+    const std::array<uint32_t, 2> key = input.movement_rng->get_key();
+    int exited_particle_index = INT_MAX;
+
+    int index = begin;
+    for(; index + 4 <= end; index += 4) {
+        // Philox4x32-10 onto the counters (step, index, 0, 0)
+        __m128i counter_0 = _mm_set1_epi32(static_cast<int>(input.step));
+        __m128i counter_1 = _mm_add_epi32(_mm_set1_epi32(index), _mm_setr_epi32(0, 1, 2, 3));
+        __m128i counter_2 = _mm_setzero_si128();
+        __m128i counter_3 = _mm_setzero_si128();
+        __m128i key_0 = _mm_set1_epi32(static_cast<int>(key[0]));
+        __m128i key_1 = _mm_set1_epi32(static_cast<int>(key[1]));
+        for(int round = 0; round < 10; round++) {
+            __m128i hi_0, lo_0, hi_1, lo_1;
+            p_multiply_sse2(counter_0, _mm_set1_epi32(static_cast<int>(Philox4x32::M0)), hi_0, lo_0);
+            p_multiply_sse2(counter_2, _mm_set1_epi32(static_cast<int>(Philox4x32::M1)), hi_1, lo_1);
+            counter_0 = _mm_xor_si128(_mm_xor_si128(hi_1, counter_1), key_0);
+            counter_1 = lo_1;
+            counter_2 = _mm_xor_si128(_mm_xor_si128(hi_0, counter_3), key_1);
+            counter_3 = lo_0;
+            key_0 = _mm_add_epi32(key_0, _mm_set1_epi32(static_cast<int>(Philox4x32::W0)));
+            key_1 = _mm_add_epi32(key_1, _mm_set1_epi32(static_cast<int>(Philox4x32::W1)));
+        }
+        alignas(16) std::array<uint32_t, 4> random_values{};
+        _mm_store_si128(reinterpret_cast<__m128i *>(random_values.data()), counter_0);
+
+        for(int lane = 0; lane < 4; lane++) {
+            int particle = index + lane;
+            int cell = (positions[2 * particle] + 1) * input.stride + positions[2 * particle + 1] + 1;
+            uint8_t moves_cell = input.move_table[cell];
+            int n_moves = moves_count(moves_cell);
+
+            bool keep_move = n_moves == 2 && moves_mask(moves_cell) & MOVE_BIT[moves[particle]];
+            MOVES random_move = MOVES_DECODE[moves_mask(moves_cell)][bounded_index(random_values[lane], n_moves)];
+            MOVES next_move = keep_move ? moves[particle] : random_move;
+            next_moves[particle - begin] = next_move;
+
+            if(moves_exit(input.move_table[cell + deltas[next_move]]) && exited_particle_index == INT_MAX)
+                exited_particle_index = particle;
+        }
+    }
+
+    int remaining_exited_index = p_step_particles_scalar(input, positions, moves, next_moves + (index - begin), index, end);
+    return exited_particle_index != INT_MAX ? exited_particle_index : remaining_exited_index;
+}
+
+
+/**
+ * AVX2 implementation of the particles' step, that handles 8 particles at a time without branches.
+ *
+ * The move table is gathered 4 bytes at a time. Reading the 3 bytes after a walkable cell is always safe, as the
+ * table ends with the sentinel border.
+ * @see p_step_particles.
+ */
+__attribute__((target("avx2")))
+int p_step_particles_avx2(const StepInput &input, const int *positions, const MOVES *moves, MOVES *next_moves, int begin, int end) {
+    const std::array<uint32_t, 2> key = input.movement_rng->get_key();
+    alignas(32) const std::array<int, 8> deltas = {0, -input.stride, 1, input.stride, -1, 0, 0, 0};
+    const auto *move_table = reinterpret_cast<const int *>(input.move_table);
+    int exited_particle_index = INT_MAX;
+
+    const __m256i stride = _mm256_set1_epi32(input.stride);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+    const __m256i deinterleave = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i m_0 = _mm256_set1_epi32(static_cast<int>(Philox4x32::M0));
+    const __m256i m_1 = _mm256_set1_epi32(static_cast<int>(Philox4x32::M1));
+
+    int index = begin;
+    for(; index + 8 <= end; index += 8) {
+        // Splits the (row, col) pairs of the 8 particles and computes their cells' indexes
+        __m256i low = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(positions + 2 * index)), deinterleave);
+        __m256i high = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(positions + 2 * index + 8)), deinterleave);
+        __m256i rows = _mm256_permute2x128_si256(low, high, 0x20);
+        __m256i cols = _mm256_permute2x128_si256(low, high, 0x31);
+        __m256i cells = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_add_epi32(rows, one), stride), _mm256_add_epi32(cols, one));
+
+        __m256i moves_cells = _mm256_and_si256(_mm256_i32gather_epi32(move_table, cells, 1), byte_mask);
+        __m256i masks = _mm256_and_si256(moves_cells, _mm256_set1_epi32(0xF));
+        __m256i counts = _mm256_and_si256(_mm256_srli_epi32(moves_cells, 4), _mm256_set1_epi32(0x7));
+
+        // Keeps going on if it can go only on opposite directions. F becomes a shift by -1, which gives no bit at all
+        __m256i last_moves = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(moves + index)));
+        __m256i last_bits = _mm256_sllv_epi32(one, _mm256_sub_epi32(last_moves, one));
+        __m256i keep_move = _mm256_andnot_si256(_mm256_cmpeq_epi32(_mm256_and_si256(masks, last_bits), _mm256_setzero_si256()),
+                                                _mm256_cmpeq_epi32(counts, _mm256_set1_epi32(2)));
+
+        // Philox4x32-10 onto the counters (step, index, 0, 0)
+        __m256i counter_0 = _mm256_set1_epi32(static_cast<int>(input.step));
+        __m256i counter_1 = _mm256_add_epi32(_mm256_set1_epi32(index), lanes);
+        __m256i counter_2 = _mm256_setzero_si256();
+        __m256i counter_3 = _mm256_setzero_si256();
+        __m256i key_0 = _mm256_set1_epi32(static_cast<int>(key[0]));
+        __m256i key_1 = _mm256_set1_epi32(static_cast<int>(key[1]));
+        for(int round = 0; round < 10; round++) {
+            __m256i hi_0 = p_multiply_hi_avx2(counter_0, m_0);
+            __m256i lo_0 = _mm256_mullo_epi32(counter_0, m_0);
+            __m256i hi_1 = p_multiply_hi_avx2(counter_2, m_1);
+            __m256i lo_1 = _mm256_mullo_epi32(counter_2, m_1);
+            counter_0 = _mm256_xor_si256(_mm256_xor_si256(hi_1, counter_1), key_0);
+            counter_1 = lo_1;
+            counter_2 = _mm256_xor_si256(_mm256_xor_si256(hi_0, counter_3), key_1);
+            counter_3 = lo_0;
+            key_0 = _mm256_add_epi32(key_0, _mm256_set1_epi32(static_cast<int>(Philox4x32::W0)));
+            key_1 = _mm256_add_epi32(key_1, _mm256_set1_epi32(static_cast<int>(Philox4x32::W1)));
+        }
+
+        // Choosing a random move, as bounded_index does
+        __m256i slots = p_multiply_hi_avx2(counter_0, counts);
+        __m256i random_moves = _mm256_i32gather_epi32(MOVES_DECODE_32.data(), _mm256_add_epi32(_mm256_slli_epi32(masks, 2), slots), 4);
+        __m256i chosen_moves = _mm256_blendv_epi8(random_moves, last_moves, keep_move);
+
+        // Checks if the particles are going to reach the exit
+        __m256i next_cells = _mm256_add_epi32(cells, _mm256_i32gather_epi32(deltas.data(), chosen_moves, 4));
+        __m256i next_moves_cells = _mm256_i32gather_epi32(move_table, next_cells, 1);
+        __m256i exits = _mm256_cmpeq_epi32(_mm256_and_si256(next_moves_cells, _mm256_set1_epi32(MOVES_EXIT)), _mm256_set1_epi32(MOVES_EXIT));
+        int exited_lanes = _mm256_movemask_ps(_mm256_castsi256_ps(exits));
+        if(exited_lanes && exited_particle_index == INT_MAX)
+            exited_particle_index = index + __builtin_ctz(exited_lanes);
+
+        // Narrows the moves back to bytes
+        __m256i packed = _mm256_shuffle_epi8(chosen_moves, _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                                             0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+        __m128i narrowed = _mm_unpacklo_epi32(_mm256_castsi256_si128(packed), _mm256_extracti128_si256(packed, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(next_moves + (index - begin)), narrowed);
+    }
+
+    int remaining_exited_index = p_step_particles_scalar(input, positions, moves, next_moves + (index - begin), index, end);
+    return exited_particle_index != INT_MAX ? exited_particle_index : remaining_exited_index;
+}
+
+#endif
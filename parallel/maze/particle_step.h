@@ -0,0 +1,33 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#ifndef RANDOMMAZESOLVER_PARTICLE_STEP_H
+#define RANDOMMAZESOLVER_PARTICLE_STEP_H
+
+#include <cstdint>
+
+#include "../../utils/philox.h"
+#include "../../utils/maze/move_table.h"
+
+// ENUMS AND STRUCTS
+
+/// Implementations of the particles' step, from the slowest to the fastest one.
+enum STEP_KERNEL {
+    SCALAR = 0,
+    SSE2 = 1,
+    AVX2 = 2,
+};
+
+
+/// Values shared by all the particles that are moving in the same step.
+struct StepInput {
+    const uint8_t *move_table;
+    int stride;
+    const Philox4x32 *movement_rng;
+    uint32_t step;
+};
+
+STEP_KERNEL p_step_kernel();
+const char *p_step_kernel_name(STEP_KERNEL kernel);
+int p_step_particles(STEP_KERNEL kernel, const StepInput &input, const int *positions, const MOVES *moves, MOVES *next_moves, int begin, int end);
+
+#endif //RANDOMMAZESOLVER_PARTICLE_STEP_H
@@ -0,0 +1,161 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#ifndef RANDOMMAZESOLVER_PARTICLES_H
+#define RANDOMMAZESOLVER_PARTICLES_H
+
+#include <iostream>
+#include <vector>
+
+#include "../../utils/maze/coordinates.h"
+#include "../../utils/maze/move_stack.h"
+
+// ENUMS AND STRUCTS
+
+/// Struct used to represent all the particles and handle their movements inside the maze
+struct Particles {
+    std::vector<Coordinates> positions;
+    std::vector<MOVES> moves;
+    // Each path is stored as the stack of moves that leads from the start to the particle's position
+    std::vector<MoveStack> paths;
+    MoveStackArena &paths_arena;
+    Coordinates start;
+    int how_many;
+
+    // F is used just for particles' initializations (frozen)
+    Particles(int how_many, MoveStackArena &paths_arena) : positions(std::vector<Coordinates>(how_many, Coordinates())), moves(std::vector<MOVES>(how_many, MOVES::F)), paths(std::vector<MoveStack>(how_many)), paths_arena(paths_arena), how_many(how_many) {}
+
+    /**
+     * Spawns a new set of particles at the same position, by reusing the memory of the previous ones.
+     *
+     * The paths are emptied, so the arena that holds them must be reset too.
+     * @param how_many This is the number of particles to spawn.
+     * @param coord These are the coordinates of the spawn position, which is the starting point of every path.
+     */
+    void reset(int how_many, Coordinates coord) {
+        this->positions.assign(how_many, coord);
+        this->moves.assign(how_many, MOVES::F);
+        this->paths.assign(how_many, MoveStack());
+        this->start = coord;
+        this->how_many = how_many;
+    }
+
+
+    /**
+     * Allows to add new particles data to the current structure's vectors.
+     *
+     * This function updates the relative vectors' elements at the corresponding index.
+     * All the particles spawn at the same position, which is the starting point of every path.
+     * @param index This represents the index of the current particle values inside the vectors.
+     * @param coord
+     */
+    void addParticle(int index, Coordinates coord) {
+        this->positions[index] = coord;
+        this->start = coord;
+    }
+
+
+    /**
+     * This function is used to move the particle.
+     *
+     * It allows to update the particle's coordinates and path while it moves randomly and also when backtracking
+     * it's previous movements.
+     * Backtracking is also applied when the particle needs to follow the first particle that exited the maze.
+     * @see backtrack_exited_particle.
+     *
+     * @param index This represents the index of the current particle values inside the vectors.
+     * @param new_move This represents the next particle move to implement.
+     * @param backtracking This variable indicates if the particle is going forward or backtracking the previous
+     * movements contained in the track vector.
+     */
+    void update_coordinates(int index, MOVES new_move, bool backtracking=false) {
+        this->update_position(index, new_move);
+
+        MoveStack &path = this->paths[index];
+        // Case in which the particle is backtracking or the new move undoes the last one, so that the particle is back
+        // onto the last but one cell of its track (eventual random backtrack)
+        // This is extremely useful as it frees up memory that would be wasted as some of the moves are not relevant
+        // for the maze's solution
+        if(backtracking || (!path.empty() && this->paths_arena.top(path) == MOVE_OPPOSITE[new_move]))
+            this->paths_arena.pop(path);
+        // Case in which the particle has moved onto a new cell
+        else
+            this->paths_arena.push(path, new_move);
+    }
+
+
+    /**
+     * This function is used to move the particle without touching its path.
+     *
+     * It is used by the particles that follow the solution's path, which is shared by all of them.
+     * @param index This represents the index of the current particle values inside the vectors.
+     * @param new_move This represents the next particle move to implement.
+     */
+    void update_position(int index, MOVES new_move) {
+        switch (new_move) {
+            case MOVES::N:
+                this->positions[index] = Coordinates(this->positions[index].row - 1, this->positions[index].col);
+                break;
+            case MOVES::S:
+                this->positions[index] = Coordinates(this->positions[index].row + 1, this->positions[index].col);
+                break;
+            case MOVES::E:
+                this->positions[index] = Coordinates(this->positions[index].row, this->positions[index].col + 1);
+                break;
+            case MOVES::W:
+                this->positions[index] = Coordinates(this->positions[index].row, this->positions[index].col - 1);
+                break;
+            case MOVES::F:
+                std::cout<< "Unexpected error: the F move is meant only for particles' initialization!" << std::endl;
+                exit(1);
+        }
+        this->moves[index] = new_move;
+    }
+
+
+    /**
+     * Decodes the path of a particle into the coordinates of its cells.
+     *
+     * @param index This represents the index of the current particle values inside the vectors.
+     * @return the coordinates of the path's cells, from the start to the particle's position.
+     */
+    [[nodiscard]] std::vector<Coordinates> path_coordinates(int index) const {
+        std::vector<MOVES> path_moves;
+        std::vector<Coordinates> path_coords;
+        this->path_coordinates(index, path_moves, path_coords);
+        return path_coords;
+    }
+
+
+    /**
+     * Decodes the path of a particle into existing vectors, whose memory is reused.
+     *
+     * @param index This represents the index of the current particle values inside the vectors.
+     * @param path_moves This vector receives the moves of the path, from the start to the particle's position.
+     * @param path_coords This vector receives the coordinates of the path's cells, from the start to the particle's
+     * position.
+     */
+    void path_coordinates(int index, std::vector<MOVES> &path_moves, std::vector<Coordinates> &path_coords) const {
+        this->paths_arena.moves(this->paths[index], path_moves);
+        path_coords.clear();
+        path_coords.reserve(path_moves.size() + 1);
+        path_coords.push_back(this->start);
+        for(MOVES move : path_moves) {
+            Coordinates last = path_coords.back();
+            switch (move) {
+                case MOVES::N:
+                    path_coords.emplace_back(last.row - 1, last.col);
+                    break;
+                case MOVES::S:
+                    path_coords.emplace_back(last.row + 1, last.col);
+                    break;
+                case MOVES::E:
+                    path_coords.emplace_back(last.row, last.col + 1);
+                    break;
+                default:
+                    path_coords.emplace_back(last.row, last.col - 1);
+            }
+        }
+    }
+};
+
+#endif //RANDOMMAZESOLVER_PARTICLES_H
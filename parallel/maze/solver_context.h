@@ -0,0 +1,88 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#ifndef RANDOMMAZESOLVER_SOLVER_CONTEXT_H
+#define RANDOMMAZESOLVER_SOLVER_CONTEXT_H
+
+#include <cstdint>
+#include <vector>
+
+#include "maze_generation.h"
+#include "particles.h"
+#include "../../utils/utils.h"
+#include "../../utils/maze/move_stack.h"
+#include "../../utils/maze/maze_file.h"
+#include "../../utils/maze/move_table.h"
+#include "../../utils/maze/path_index.h"
+
+// ENUMS AND STRUCTS
+
+/// Memory used by the backtracking, kept between the executions.
+struct BacktrackBuffers {
+    // Position of each cell onto the solution's path, sized to the path
+    PathIndex solution_index;
+    // Position of each particle onto the solution's path
+    std::vector<int> cursors;
+    std::vector<uint8_t> exited_particles_map;
+};
+
+
+/// Memory used by the random walk, kept between the executions.
+struct WalkBuffers {
+    // Copies of the particles' positions and last moves, which the threads move ahead during each round
+    std::vector<Coordinates> positions;
+    std::vector<MOVES> moves;
+    // Moves chosen for each particle during the current round, grouped by particle
+    std::vector<MOVES> round_moves;
+    // Step in which the exited particle has reached the exit, set by the walk when there is one
+    uint32_t exit_step = 0;
+};
+
+
+/// Memory used by the aggregate simulation, kept between the executions.
+struct OccupancyBuffers {
+    // Particles onto each cell, one count for each move that brought them there. Indexed as the maze's buffer, times
+    // the 5 MOVES values, since the particles that haven't moved yet have the frozen one
+    std::vector<uint64_t> counts;
+    // Particles that leave each cell with each move during the current step, with the same layout
+    std::vector<uint64_t> outgoing;
+};
+
+
+/**
+ * Everything the parallel version needs in order to generate and solve a maze.
+ *
+ * The structures are reset in place at each execution instead of being created again, so their memory is allocated
+ * by the first executions and then reused: as long as the mazes and the particles don't grow, the next executions
+ * make no heap allocation. A context can be used by a single execution at a time.
+ */
+struct SolverContext {
+    // Grid the maze is generated into, or expanded into when it is loaded
+    Maze maze;
+    // Used by the packed and the streamed generations
+    PackedMaze packed;
+    // Sink of the streamed generation, and the file it has written, that the packed maze is attached to
+    MazeFileWriter streamed_writer;
+    MappedMazeFile streamed_file;
+    // Copy of the maze that receives the solution's path
+    Maze solved_maze;
+    // Copy of the maze printed along with the particles' spawn point
+    Maze display_maze;
+    MoveTable move_table;
+    // Memory that holds the particles' paths. It is reset at each execution, but its blocks are kept
+    MoveStackArena paths_arena;
+    Particles particles {0, paths_arena};
+    std::vector<Coordinates> exited_particle_path;
+    std::vector<MOVES> exited_particle_moves;
+    WalkBuffers walk;
+    BacktrackBuffers backtrack;
+    OccupancyBuffers occupancy;
+    GeneratorContext generator;
+    AsciiBuffer display_buffer;
+
+    SolverContext() = default;
+    // The particles refer to the context's own arena
+    SolverContext(const SolverContext &) = delete;
+    SolverContext &operator=(const SolverContext &) = delete;
+};
+
+#endif //RANDOMMAZESOLVER_SOLVER_CONTEXT_H
@@ -1,11 +1,17 @@
 // Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
 
+#include <cstdlib>
 #include <iostream>
 #include <random>
 #include <omp.h>
 
 #include "../parallel/maze/maze_generation.h"
 #include "../parallel/maze/maze_solving.h"
+#include "../utils/profiler.h"
+
+
+// PROTOTYPES
+PhaseThreads p_solution_threads(long n_items);
 
 
 // FUNCTIONS
@@ -13,40 +19,151 @@
 /**
  * This function is the parallel version access point used to generate the maze and solve it randomly.
  *
- * @param maze This is the matrix that represents the maze's structure.
+ * The maze is generated into the context, whose memory is reused from the previous executions.
+ * @param context This holds the maze and the memory used by the generation and by the solution.
  * @param size This value represents each maze's side size.
  * @param n_particles This allows to specify the number of particles to spawn.
  * @param generation_rng This is the random number engine to use for the random generation values.
  * @param solution_rng This is the random number engine to use for the random solution values.
  * @param show_steps Flag used to determine if each movement step must be shown on screen.
- * @return the matrix that represents the maze's inner structure along with the solution path.
+ * @param fast_forward Flag used to compute the outcome of the backtracking directly, when the steps are not shown.
+ * @param packed_maze Flag used to generate and solve the maze by using its packed representation.
+ * @param paint_solution Flag used to store the solution path into the returned grid. Without it, the packed
+ * representation is solved without ever building the grid.
+ * @param aggregate_particles Flag used to move the number of particles onto each cell, instead of each particle. It
+ * moves them onto the grid's move table, so it can't be used along with the packed representation.
+ * @param generation_tiles This is the number of tiles on each maze's side, carved in parallel by the generation.
+ * @param streamed_generation Flag used to generate the maze one row at a time, by keeping only the current row in memory.
+ * @param streamed_file_path This is the maze file that receives the streamed maze's rows, which is then solved from its
+ * mapping. When empty, the rows are collected into the packed maze instead.
+ * @param generation_seed This is the seed of the generation, stored into the streamed maze file.
+ * @param timings These are the phases' timings of the current execution, filled by the generation and the solution.
+ * @param counters These are the performance counters of the current execution, collected only if they are enabled.
+ * @param outcome This receives the exited particle's index, the step in which it has exited and the backtracking's steps.
+ * @return the matrix that represents the maze's inner structure along with the solution path, held by the context.
  */
-std::vector<std::vector<MAZE_PATH>> parallel_solution(std::vector<std::vector<MAZE_PATH>> maze, int &size, int n_particles, std::mt19937 generation_rng, std::mt19937 solution_rng, bool show_steps) {
-    bool parallelize = false;
+Maze &parallel_solution(SolverContext &context, int &size, long n_particles, std::mt19937 generation_rng, std::mt19937 solution_rng, bool show_steps, bool fast_forward, bool packed_maze, bool paint_solution, bool aggregate_particles, int generation_tiles, bool streamed_generation, const std::filesystem::path &streamed_file_path, long generation_seed, PhaseTimings &timings, PhaseCounters &counters, SolutionOutcome &outcome) {
+    PhaseClock::time_point generation_start_ts = PhaseClock::now();
 
     #ifdef _OPENMP
         if(!omp_get_nested())
             omp_set_nested(true);
         if(omp_get_max_active_levels() < 2)
             omp_set_max_active_levels(2);
-
-        if(size * size / static_cast<int>(omp_get_max_threads()) > 100) {
-            parallelize = true;
-            std::cout << "Parallelizing the generation!" << std::endl;
-        }
     #endif
 
+    // A single thread is available when the executions run concurrently
+    int generation_threads = p_phase_threads(GENERATION_PHASE, static_cast<long>(size) * size);
+    if(generation_threads > 1)
+        execution_output() << "Parallelizing the generation onto " << generation_threads << " threads!" << std::endl;
+
+    // The packed representation is generated sequentially and doesn't need the MAZE_PATH grid at all
+    PackedMaze &packed = context.packed;
+
     // Generates a square maze with the specified width and height if given
     // Otherwise a random maze is generated
-    p_generate_square_maze(maze, size, generation_rng, parallelize);
+    {
+        PerfScope generation_counters(counters, "generation");
+        ProfileScope generation_profile("generation");
+        // The previous streamed maze might be mapped from the same file
+        context.streamed_file.close();
+        if(streamed_generation && !streamed_file_path.empty()) {
+            // The rows are written to the file as soon as they are generated, so only the current one is in memory.
+            // The packed maze is then attached to the file's mapping, whose pages are loaded and evicted as needed
+            MazeFileWriter &writer = context.streamed_writer;
+            if(!writer.open(streamed_file_path, size))
+                exit(1);
+            p_generate_streamed_maze(size, generation_rng, [&writer](int, const std::vector<uint8_t> &open_masks) {
+                writer.write_row(open_masks);
+            }, context.generator);
 
-    #ifdef _OPENMP
-        parallelize = false;
-        if(n_particles / omp_get_max_threads() > 100) {
-            parallelize = true;
-            std::cout << "Parallelizing the solution!" << std::endl;
-        }
-    #endif
+            MazeFileHeader header {};
+            header.exit_row = context.generator.exit_coords[0];
+            header.exit_col = context.generator.exit_coords[1];
+            header.algorithm = GENERATION_ALGORITHM::ELLER;
+            header.generation_seed = generation_seed;
+            header.solution_seed = -1;
+            if(!writer.close(header) || !context.streamed_file.open(streamed_file_path, false))
+                exit(1);
+            context.streamed_file.attach(packed);
+            if(!packed_maze)
+                packed.to_maze(context.maze);
+        } else if(streamed_generation) {
+            // The rows are collected into the packed structure, which is expanded only if the grid is needed
+            packed.resize(size);
+            p_generate_streamed_maze(size, generation_rng, [&packed](int node_row, const std::vector<uint8_t> &open_masks) {
+                packed.store_row(node_row, open_masks);
+            }, context.generator);
+            if(!packed_maze)
+                packed.to_maze(context.maze);
+        } else if(packed_maze)
+            p_generate_packed_maze(packed, size, generation_rng, context.generator);
+        else
+            p_generate_square_maze(context.maze, size, generation_rng, generation_tiles, generation_threads, context.generator);
+    }
+    timings.generation += elapsed_milliseconds_since(generation_start_ts);
+
+    // The aggregate simulation moves the cells' counts, so its work depends on the maze's size
+    if(aggregate_particles)
+        return p_solve_aggregate(context, size, n_particles, solution_rng, show_steps, p_solution_threads(static_cast<long>(size) * size), timings, counters, outcome);
+
+    PhaseThreads threads = p_solution_threads(n_particles);
+
+    if(packed_maze)
+        return p_solve(context, packed, size, n_particles, solution_rng, show_steps, fast_forward, paint_solution, threads, timings, counters, outcome);
+    return p_solve(context, size, n_particles, solution_rng, show_steps, fast_forward, paint_solution, threads, timings, counters, outcome);
+}
+
+
+/**
+ * This function is the parallel version access point used to solve randomly a maze that has already been generated.
+ *
+ * @param context This holds the memory used by the solution.
+ * @param loaded_maze This is the packed structure that represents the maze, usually attached to a maze file.
+ * @param size This value represents each maze's side size.
+ * @param n_particles This allows to specify the number of particles to spawn.
+ * @param solution_rng This is the random number engine to use for the random solution values.
+ * @param show_steps Flag used to determine if each movement step must be shown on screen.
+ * @param fast_forward Flag used to compute the outcome of the backtracking directly, when the steps are not shown.
+ * @param packed_maze Flag used to solve the maze by using its packed representation.
+ * @param paint_solution Flag used to store the solution path into the returned grid. Without it, the packed
+ * representation is solved without ever building the grid.
+ * @param aggregate_particles Flag used to move the number of particles onto each cell, instead of each particle. It
+ * moves them onto the grid's move table, so it can't be used along with the packed representation.
+ * @param timings These are the phases' timings of the current execution, filled by the generation and the solution.
+ * @param counters These are the performance counters of the current execution, collected only if they are enabled.
+ * @param outcome This receives the exited particle's index, the step in which it has exited and the backtracking's steps.
+ * @return the matrix that represents the maze's inner structure along with the solution path, held by the context.
+ */
+Maze &parallel_solution(SolverContext &context, PackedMaze &loaded_maze, int &size, long n_particles, std::mt19937 solution_rng, bool show_steps, bool fast_forward, bool packed_maze, bool paint_solution, bool aggregate_particles, PhaseTimings &timings, PhaseCounters &counters, SolutionOutcome &outcome) {
+    if(packed_maze)
+        return p_solve(context, loaded_maze, size, n_particles, solution_rng, show_steps, fast_forward, paint_solution, p_solution_threads(n_particles), timings, counters, outcome);
+
+    PhaseClock::time_point setup_start_ts = PhaseClock::now();
+    loaded_maze.to_maze(context.maze);
+    timings.setup += elapsed_milliseconds_since(setup_start_ts);
+
+    if(aggregate_particles)
+        return p_solve_aggregate(context, size, n_particles, solution_rng, show_steps, p_solution_threads(static_cast<long>(size) * size), timings, counters, outcome);
+    return p_solve(context, size, n_particles, solution_rng, show_steps, fast_forward, paint_solution, p_solution_threads(n_particles), timings, counters, outcome);
+}
+
+
+/**
+ * Picks the threads of the random walk and of the backtracking, based onto the number of particles.
+ *
+ * The aggregate simulation moves a count for each cell instead of each particle, so its cells are counted instead.
+ * @param n_items This is the number of particles to spawn, or the number of cells of the aggregate simulation.
+ * @return the threads that run each phase of the solution.
+ */
+PhaseThreads p_solution_threads(long n_items) {
+    PhaseThreads threads;
+    threads.random_walk = p_phase_threads(RANDOM_WALK_PHASE, n_items);
+    threads.backtrack = p_phase_threads(BACKTRACK_PHASE, n_items);
+
+    if(threads.random_walk > 1 || threads.backtrack > 1)
+        execution_output() << "Parallelizing the solution onto " << threads.random_walk << " threads for the random walk and "
+                  << threads.backtrack << " for the backtracking!" << std::endl;
 
-    return p_solve(maze, size, n_particles, solution_rng, show_steps, parallelize);
+    return threads;
 }
\ No newline at end of file
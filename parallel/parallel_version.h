@@ -3,6 +3,11 @@
 #ifndef RANDOMMAZESOLVER_PARALLEL_VERSION_H
 #define RANDOMMAZESOLVER_PARALLEL_VERSION_H
 
-std::vector<std::vector<MAZE_PATH>> parallel_solution(std::vector<std::vector<MAZE_PATH>> maze, int &size, int n_particles, std::mt19937 generation_rng, std::mt19937 solution_rng, bool show_steps);
+#include <filesystem>
+
+#include "maze/maze_solving.h"
+
+Maze &parallel_solution(SolverContext &context, int &size, long n_particles, std::mt19937 generation_rng, std::mt19937 solution_rng, bool show_steps, bool fast_forward, bool packed_maze, bool paint_solution, bool aggregate_particles, int generation_tiles, bool streamed_generation, const std::filesystem::path &streamed_file_path, long generation_seed, PhaseTimings &timings, PhaseCounters &counters, SolutionOutcome &outcome);
+Maze &parallel_solution(SolverContext &context, PackedMaze &loaded_maze, int &size, long n_particles, std::mt19937 solution_rng, bool show_steps, bool fast_forward, bool packed_maze, bool paint_solution, bool aggregate_particles, PhaseTimings &timings, PhaseCounters &counters, SolutionOutcome &outcome);
 
 #endif //RANDOMMAZESOLVER_PARALLEL_VERSION_H
@@ -0,0 +1,343 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <json.hpp>
+#include <omp.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+#include "thresholds.h"
+#include "maze/maze_generation.h"
+#include "maze/maze_solving.h"
+
+
+// PROTOTYPES
+std::vector<ThresholdStep> p_calibrate_phase(const std::vector<long> &item_counts, const std::vector<int> &thread_counts, const std::function<float(long, int)> &measure);
+float p_fastest_run(const std::function<float(long, int)> &measure, long n_items, int n_threads);
+std::string host_name();
+
+
+// GLOBAL VARIABLES
+// The thresholds are read or calibrated once, before the executions start
+ParallelThresholds parallel_thresholds;
+// Names of the phases into the cache file, as the report's columns
+constexpr const char *PHASE_NAMES[N_PARALLEL_PHASES] = {"generation", "random_walk", "solution_painting", "backtrack"};
+// Each measure is repeated and only the fastest run is kept, so that the host's noise is filtered out
+constexpr int CALIBRATION_REPETITIONS = 5;
+// A phase is parallelized only when it takes at most this fraction of the sequential run's time
+constexpr float CALIBRATION_MIN_GAIN = 0.9f;
+// Number of steps moved by each measure of the random walk, and before each measure of the backtracking
+constexpr int CALIBRATION_STEPS = 16;
+// Side of the maze the particles are moved into. It is big enough for none of them to exit during the calibration
+constexpr int CALIBRATION_MAZE_SIZE = 101;
+// Side of the maze the solutions are painted onto, whose nodes can hold the longest painted path
+constexpr int CALIBRATION_PAINTING_SIZE = 1025;
+constexpr uint64_t CALIBRATION_SEED = 1;
+
+
+// FUNCTIONS
+
+/**
+ * Stores the thresholds used by the next executions.
+ *
+ * @param thresholds These are the thresholds loaded from the cache or just calibrated.
+ */
+void configure_thresholds(const ParallelThresholds &thresholds) {
+    parallel_thresholds = thresholds;
+}
+
+
+/**
+ * Picks the number of threads that run a phase, based onto its amount of work.
+ *
+ * Without calibrated thresholds, the phase is parallelized onto all the threads when each of them gets more than 100
+ * items. The result never exceeds the threads that are available to the caller, so it is 1 in throughput mode.
+ * @param phase This is the phase that is going to run.
+ * @param n_items This is the amount of work of the phase: cells, particles or the solution's cells.
+ * @return the number of threads that must run the phase, 1 to run it sequentially.
+ */
+int p_phase_threads(PARALLEL_PHASE phase, long n_items) {
+    int max_threads = omp_get_max_threads();
+    if(max_threads <= 1)
+        return 1;
+
+    if(!parallel_thresholds.calibrated)
+        return n_items / max_threads > 100 ? max_threads : 1;
+
+    int n_threads = 1;
+    for(const ThresholdStep &step : parallel_thresholds.steps[phase]) {
+        if(n_items >= step.min_items)
+            n_threads = step.n_threads;
+    }
+    return std::min(n_threads, max_threads);
+}
+
+
+/**
+ * Measures the crossover points of each phase onto the current host.
+ *
+ * Each phase's kernel is timed with growing amounts of work, sequentially and with 2, 4, 8.. threads up to all the
+ * available ones. For each amount the fastest thread count is kept, so the thresholds hold both when a phase starts
+ * being worth parallelizing and how many threads it should use. The mazes and the particles are synthetic, so the
+ * calibration doesn't depend on the configured executions and takes a few seconds at most.
+ * @return the calibrated thresholds.
+ */
+ParallelThresholds calibrate_thresholds() {
+    ParallelThresholds thresholds;
+    thresholds.calibrated = true;
+    thresholds.max_threads = omp_get_max_threads();
+
+    std::cout << "Calibrating the parallelization's thresholds onto " << thresholds.max_threads << " threads.." << std::endl;
+    // A single thread has nothing to compare
+    if(thresholds.max_threads <= 1)
+        return thresholds;
+
+    std::vector<int> thread_counts;
+    for(int n_threads = 2; n_threads < thresholds.max_threads; n_threads *= 2)
+        thread_counts.push_back(n_threads);
+    thread_counts.push_back(thresholds.max_threads);
+
+    std::vector<long> particle_counts = {256, 1024, 4096, 16384, 65536, 262144};
+
+    // GENERATION
+    // The threshold is measured onto the grid's initialization only, which is the one stage parallelized by the single
+    // visit. The tiled carving runs with the same threads: its tiles are independent visits with much more work per
+    // cell than the initialization, so they are worth parallelizing at least as early
+    std::vector<long> cells_counts;
+    for(long size : {51, 101, 201, 401, 801, 1601})
+        cells_counts.push_back(size * size);
+    Maze generated_maze;
+    std::vector<int> exit_coords = {0, 1};
+    thresholds.steps[GENERATION_PHASE] = p_calibrate_phase(cells_counts, thread_counts, [&](long n_cells, int n_threads) {
+        int size = static_cast<int>(std::lround(std::sqrt(static_cast<double>(n_cells))));
+        PhaseClock::time_point start_ts = PhaseClock::now();
+        p_initialize_maze(generated_maze, size, exit_coords, n_threads);
+        return elapsed_milliseconds_since(start_ts);
+    });
+
+    // RANDOM WALK
+    std::mt19937 generation_rng(CALIBRATION_SEED);
+    GeneratorContext generator_context;
+    int walk_size = CALIBRATION_MAZE_SIZE;
+    Maze walk_maze;
+    p_get_exit_coords(walk_size, generation_rng, exit_coords);
+    p_initialize_maze(walk_maze, walk_size, exit_coords, 1);
+    p_generate_paths(walk_maze, walk_size, exit_coords, generation_rng, generator_context);
+    MoveTable move_table(walk_maze);
+    Philox4x32 movement_rng(CALIBRATION_SEED);
+    // Odd coordinates are always walkable
+    Coordinates start(walk_size / 2 | 1, walk_size / 2 | 1);
+
+    MoveStackArena paths_arena;
+    Particles particles(0, paths_arena);
+    WalkBuffers walk_buffers;
+    auto spawn_particles = [&](long n_particles) {
+        paths_arena.reset();
+        particles.reset(static_cast<int>(n_particles), start);
+    };
+    thresholds.steps[RANDOM_WALK_PHASE] = p_calibrate_phase(particle_counts, thread_counts, [&](long n_particles, int n_threads) {
+        spawn_particles(n_particles);
+        PhaseClock::time_point start_ts = PhaseClock::now();
+        p_walk_particles(move_table, particles, movement_rng, CALIBRATION_STEPS, n_threads, walk_buffers, nullptr);
+        return elapsed_milliseconds_since(start_ts);
+    });
+
+    // BACKTRACK
+    // The first particle plays the exited one, the others unwind their paths until they meet its own
+    std::vector<Coordinates> exited_particle_path;
+    std::vector<MOVES> exited_particle_moves;
+    BacktrackBuffers buffers;
+    thresholds.steps[BACKTRACK_PHASE] = p_calibrate_phase(particle_counts, thread_counts, [&](long n_particles, int n_threads) {
+        spawn_particles(n_particles);
+        p_walk_particles(move_table, particles, movement_rng, CALIBRATION_STEPS, thresholds.max_threads, walk_buffers, nullptr);
+        particles.path_coordinates(0, exited_particle_moves, exited_particle_path);
+        PhaseClock::time_point start_ts = PhaseClock::now();
+        p_fast_forward_exited_particle(particles, exited_particle_path, exited_particle_moves, 0, n_threads, buffers);
+        return elapsed_milliseconds_since(start_ts);
+    });
+
+    // SOLUTION PAINTING
+    int painting_size = CALIBRATION_PAINTING_SIZE;
+    int n_nodes_side = painting_size / 2;
+    Maze painted_maze;
+    exit_coords = {0, 1};
+    p_initialize_maze(painted_maze, painting_size, exit_coords, thresholds.max_threads);
+    std::vector<Coordinates> solution_path;
+    thresholds.steps[SOLUTION_PAINTING_PHASE] = p_calibrate_phase(particle_counts, thread_counts, [&](long path_length, int n_threads) {
+        solution_path.clear();
+        for(int node = 0; node < path_length; node++)
+            solution_path.emplace_back(2 * (node / n_nodes_side) + 1, 2 * (node % n_nodes_side) + 1);
+        PhaseClock::time_point start_ts = PhaseClock::now();
+        p_paint_solution(painted_maze, solution_path, n_threads);
+        return elapsed_milliseconds_since(start_ts);
+    });
+
+    return thresholds;
+}
+
+
+/**
+ * Finds the fastest thread count of a phase for each amount of work.
+ *
+ * @param item_counts These are the growing amounts of work to measure.
+ * @param thread_counts These are the thread counts compared with the sequential run.
+ * @param measure This function runs the phase with the given amount of work and threads, and returns its milliseconds.
+ * @return the steps at which the fastest thread count changes.
+ */
+std::vector<ThresholdStep> p_calibrate_phase(const std::vector<long> &item_counts, const std::vector<int> &thread_counts, const std::function<float(long, int)> &measure) {
+    std::vector<ThresholdStep> steps;
+    int previous_threads = 1;
+
+    for(long n_items : item_counts) {
+        // The parallel runs must beat the sequential one by a margin, or the phase stays sequential
+        float best_milliseconds = p_fastest_run(measure, n_items, 1) * CALIBRATION_MIN_GAIN;
+        int best_threads = 1;
+        for(int n_threads : thread_counts) {
+            float milliseconds = p_fastest_run(measure, n_items, n_threads);
+            if(milliseconds < best_milliseconds) {
+                best_milliseconds = milliseconds;
+                best_threads = n_threads;
+            }
+        }
+
+        if(best_threads != previous_threads) {
+            steps.push_back({n_items, best_threads});
+            previous_threads = best_threads;
+        }
+    }
+
+    return steps;
+}
+
+
+/**
+ * Repeats a measure and keeps the fastest run.
+ *
+ * @param measure This function runs the phase with the given amount of work and threads, and returns its milliseconds.
+ * @param n_items This is the amount of work of the phase.
+ * @param n_threads This is the number of threads that run the phase.
+ * @return the milliseconds of the fastest run.
+ */
+float p_fastest_run(const std::function<float(long, int)> &measure, long n_items, int n_threads) {
+    // The first run warms the memory up and is discarded
+    measure(n_items, n_threads);
+    float fastest = measure(n_items, n_threads);
+    for(int repetition = 1; repetition < CALIBRATION_REPETITIONS; repetition++)
+        fastest = std::min(fastest, measure(n_items, n_threads));
+    return fastest;
+}
+
+
+/**
+ * Loads the thresholds calibrated onto the current host.
+ *
+ * The cache holds an entry for each host, so the machines that share the project's folder keep their own thresholds.
+ * An entry is discarded if it has been calibrated with a different number of threads.
+ * @param cache_path This is the path of the thresholds' cache file.
+ * @param thresholds These receive the loaded thresholds.
+ * @return true if the host's thresholds have been loaded.
+ */
+bool load_thresholds(const std::filesystem::path &cache_path, ParallelThresholds &thresholds) {
+    std::ifstream cache_file(cache_path);
+    if(!cache_file.is_open())
+        return false;
+
+    nlohmann::json cache = nlohmann::json::parse(cache_file, nullptr, false);
+    std::string host = host_name();
+    if(cache.is_discarded() || !cache.is_object() || !cache.contains(host)) {
+        std::cout << "The parallelization's thresholds have not been calibrated onto " << host << std::endl;
+        return false;
+    }
+
+    const nlohmann::json &entry = cache.at(host);
+    int max_threads = entry.value("max_threads", 0);
+    if(max_threads != omp_get_max_threads()) {
+        std::cout << "The parallelization's thresholds have been calibrated onto " << max_threads
+                  << " threads, they must be calibrated again" << std::endl;
+        return false;
+    }
+
+    thresholds = ParallelThresholds();
+    thresholds.calibrated = true;
+    thresholds.max_threads = max_threads;
+    for(int phase = 0; phase < N_PARALLEL_PHASES; phase++) {
+        if(!entry.contains(PHASE_NAMES[phase]))
+            continue;
+        for(const nlohmann::json &step : entry.at(PHASE_NAMES[phase]))
+            thresholds.steps[phase].push_back({step.value("min_items", 0L), step.value("n_threads", 1)});
+    }
+
+    return true;
+}
+
+
+/**
+ * Saves the current host's thresholds into the cache, by keeping the other hosts' ones.
+ *
+ * @param cache_path This is the path of the thresholds' cache file.
+ * @param thresholds These are the calibrated thresholds.
+ */
+void save_thresholds(const std::filesystem::path &cache_path, const ParallelThresholds &thresholds) {
+    nlohmann::json cache = nlohmann::json::object();
+    std::ifstream cache_file(cache_path);
+    if(cache_file.is_open()) {
+        nlohmann::json previous_cache = nlohmann::json::parse(cache_file, nullptr, false);
+        if(!previous_cache.is_discarded() && previous_cache.is_object())
+            cache = previous_cache;
+        cache_file.close();
+    }
+
+    nlohmann::json entry;
+    entry["max_threads"] = thresholds.max_threads;
+    for(int phase = 0; phase < N_PARALLEL_PHASES; phase++) {
+        entry[PHASE_NAMES[phase]] = nlohmann::json::array();
+        for(const ThresholdStep &step : thresholds.steps[phase])
+            entry[PHASE_NAMES[phase]].push_back({{"min_items", step.min_items}, {"n_threads", step.n_threads}});
+    }
+    cache[host_name()] = entry;
+
+    std::ofstream output(cache_path);
+    if(!output.is_open()) {
+        std::cout << "Unable to save the parallelization's thresholds into " << cache_path << std::endl;
+        return;
+    }
+    output << cache.dump(2) << std::endl;
+    std::cout << "The parallelization's thresholds have been saved into " << cache_path << std::endl;
+}
+
+
+/**
+ * Prints the threads used by each phase, depending on its amount of work.
+ *
+ * @param thresholds These are the thresholds to print.
+ */
+void print_thresholds(const ParallelThresholds &thresholds) {
+    std::cout << "Parallelization's thresholds:" << std::endl;
+    for(int phase = 0; phase < N_PARALLEL_PHASES; phase++) {
+        std::cout << "  " << PHASE_NAMES[phase] << ": sequential";
+        for(const ThresholdStep &step : thresholds.steps[phase])
+            std::cout << ", " << step.n_threads << (step.n_threads > 1 ? " threads" : " thread") << " from " << step.min_items << " items";
+        std::cout << std::endl;
+    }
+}
+
+
+/**
+ * Retrieves the name of the current host, that identifies its thresholds into the cache.
+ *
+ * @return the host's name, "localhost" if it can't be retrieved.
+ */
+std::string host_name() {
+#if defined(__unix__) || defined(__APPLE__)
+    char name[256] = {};
+    if(gethostname(name, sizeof(name) - 1) == 0 && name[0] != '\0')
+        return name;
+#endif
+    return "localhost";
+}
@@ -0,0 +1,59 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#ifndef RANDOMMAZESOLVER_THRESHOLDS_H
+#define RANDOMMAZESOLVER_THRESHOLDS_H
+
+#include <array>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// ENUMS AND STRUCTS
+
+/// Phases of the parallel version whose parallelization depends on the amount of work.
+enum PARALLEL_PHASE {
+    GENERATION_PHASE = 0,
+    RANDOM_WALK_PHASE = 1,
+    SOLUTION_PAINTING_PHASE = 2,
+    BACKTRACK_PHASE = 3,
+    N_PARALLEL_PHASES = 4,
+};
+
+
+/// Number of threads to use from a given amount of work on.
+struct ThresholdStep {
+    long min_items;
+    int n_threads;
+};
+
+
+/**
+ * Crossover points of each phase, measured on the current host.
+ *
+ * The work is counted in cells for the generation, in particles for the random walk and the backtracking, and in the
+ * solution's cells for its painting. Each phase runs with the threads of the last step that its work reaches, and
+ * sequentially below the first one. Until the thresholds are calibrated, a phase is parallelized onto all the threads
+ * when each of them gets more than 100 items.
+ */
+struct ParallelThresholds {
+    bool calibrated = false;
+    // Threads that were available during the calibration
+    int max_threads = 0;
+    std::array<std::vector<ThresholdStep>, N_PARALLEL_PHASES> steps;
+};
+
+
+/// Threads that run the phases of a solution, 1 when a phase runs sequentially.
+struct PhaseThreads {
+    int random_walk = 1;
+    int backtrack = 1;
+};
+
+void configure_thresholds(const ParallelThresholds &thresholds);
+int p_phase_threads(PARALLEL_PHASE phase, long n_items);
+ParallelThresholds calibrate_thresholds();
+bool load_thresholds(const std::filesystem::path &cache_path, ParallelThresholds &thresholds);
+void save_thresholds(const std::filesystem::path &cache_path, const ParallelThresholds &thresholds);
+void print_thresholds(const ParallelThresholds &thresholds);
+
+#endif //RANDOMMAZESOLVER_THRESHOLDS_H
@@ -1,21 +1,12 @@
 // Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
 
+#include <chrono>
 #include <iostream>
-#include <iterator>
 
 #include "maze_generation.h"
 #include "../../utils/utils.h"
 
 
-// PROTOTYPES
-std::vector<int> get_exit_coords(int &size, std::mt19937 &rng);
-void initialize_maze(std::vector<std::vector<MAZE_PATH>> &maze, int &size, std::vector<int> exit_coords);
-void generate_paths(std::vector<std::vector<MAZE_PATH>> &maze, int &size, std::vector<int> exit_coords, std::mt19937 &rng, bool show_steps);
-void visit_forward(std::vector<std::vector<MAZE_PATH>> &maze, int &size, int &curr_index, std::vector<int> &curr_cell, std::vector<std::vector<int>> &curr_track, std::vector<std::vector<bool>> &visited_cells, std::mt19937 &rng, bool is_exit, bool show_steps);
-std::vector<std::vector<int>> get_unvisited_near_cells(std::vector<std::vector<MAZE_PATH>> &maze, std::vector<int> &curr_cell, int &size, std::vector<std::vector<bool>> &visited_cells, int &n_cells, bool is_exit);
-void backtrack(std::vector<std::vector<MAZE_PATH>> &maze, int &size, int &curr_index, std::vector<int> &curr_cell, std::vector<std::vector<int>> &curr_track, std::vector<std::vector<bool>> &visited_cells, std::mt19937 &rng, bool show_steps);
-
-
 // FUNCTIONS
 
 /**
@@ -29,9 +20,10 @@ void backtrack(std::vector<std::vector<MAZE_PATH>> &maze, int &size, int &curr_i
  *  @param size Represents the length of each maze's side.
  *  @param generation_rng This is the random number engine to use in order to generate random values.
  *  @param show_steps Flag used to determine if each change step must be shown on screen.
+ *  @return the coordinates of the maze's exit.
  */
-void generate_square_maze(std::vector<std::vector<MAZE_PATH>> &maze, int &size, std::mt19937 generation_rng, bool show_steps) {
-    std::cout << "Generating the maze.." << std::endl;
+std::vector<int> generate_square_maze(Maze &maze, int &size, std::mt19937 generation_rng, bool show_steps) {
+    execution_output() << "Generating the maze.." << std::endl;
 
     // Selects the exit's coordinates randomly
     std::vector<int> exit_coords = get_exit_coords(size, generation_rng);
@@ -40,7 +32,11 @@ void generate_square_maze(std::vector<std::vector<MAZE_PATH>> &maze, int &size,
     initialize_maze(maze, size, exit_coords);
 
     // Generates the maze's paths
+    std::chrono::steady_clock::time_point start_ts = std::chrono::steady_clock::now();
     generate_paths(maze, size, exit_coords, generation_rng, show_steps);
+    print_carving_rate(static_cast<long>(size / 2) * (size / 2), start_ts);
+
+    return exit_coords;
 }
 
 
@@ -89,69 +85,17 @@ std::vector<int> get_exit_coords(int &size, std::mt19937 &rng) {
  *  @param size Represents the length of each maze's side.
  *  @param exit_coords This is the random number engine to use in order to generate random values.
  */
-void initialize_maze(std::vector<std::vector<MAZE_PATH>> &maze, int &size, std::vector<int> exit_coords) {
+void initialize_maze(Maze &maze, int &size, std::vector<int> exit_coords) {
     // Initializes the maze's structure.
-    for(int row = 0; row < size; row++) {
-        std::vector<MAZE_PATH> curr_col;
-        curr_col.resize(size);
-        curr_col.reserve(size);
-        for(int col = 0; col < size; col++)
-            // Place walls on even rows and columns in order to create the grid
-            if(row % 2 == 0 || col % 2 == 0)
-                curr_col[col] = MAZE_PATH::WALL;
+    // The grid is filled with walls, the sentinel border included
+    maze.resize(size);
+    for(int row = 1; row < size; row += 2)
+        for(int col = 1; col < size; col += 2)
+            // Walls are kept on even rows and columns in order to create the grid
             // Here the walkable path is set
-            else
-                curr_col[col] = MAZE_PATH::EMPTY;
-        maze[row] = curr_col;
-    }
+            maze(row, col) = MAZE_PATH::EMPTY;
     // Placing the exit in the maze
-    maze[exit_coords[0]][exit_coords[1]] = MAZE_PATH::EXIT;
-}
-
-
-/**
- * Initializes the maze's inner structure generation.
- *
- * This function creates the visited cells matrix to keep track of which cell in the maze has been visited during
- * the actual generation. Then it starts the generation of the structure.
- *
- *  @param maze It's the matrix representing the maze that is being generated.
- *  @param size Represents the length of each maze's side.
- *  @param exit_coords This is the random number engine to use in order to generate random values.
- *  @param rng This is the random number engine to use in order to generate random values.
- *  @param show_steps Flag used to determine if each change step must be shown on screen.
- */
-void generate_paths(std::vector<std::vector<MAZE_PATH>> &maze, int &size, std::vector<int> exit_coords, std::mt19937 &rng, bool show_steps) {
-    std::vector<std::vector<bool>> visited_cells;
-    visited_cells.reserve(size);
-    std::vector<std::vector<int>> curr_track;
-
-    // Initializes the current path tracking and sets the relative index to 0
-    int curr_index = 0;
-    curr_track.push_back(exit_coords);
-
-    // Initializes the visited_cells array to false as no cell has been visited yet
-    for(int row = 0; row < size; row++) {
-        std::vector<bool> curr_col;
-        curr_col.reserve(size);
-        for(int col = 0; col < size; col++)
-        {
-            curr_col.push_back(false);
-        }
-        visited_cells.push_back(curr_col);
-    }
-
-    // Sets the exit cell as first visited cell
-    visited_cells[exit_coords[0]][exit_coords[1]] = true;
-
-    // Selects the exit as starting cell for the path generation
-    std::vector<int> curr_cell = exit_coords;
-
-    // Retrieves the nearest cells if there is any
-    // Then randomly select one of them and proceeds visiting it
-    // If a dead end is found, it backtracks all steps until it finds a new unvisited cell
-    // If by backtracking all cells have been visited, the maze has been completely generated
-    visit_forward(maze, size, curr_index, curr_cell, curr_track, visited_cells, rng, true, show_steps);
+    maze(exit_coords[0], exit_coords[1]) = MAZE_PATH::EXIT;
 }
 
 
@@ -164,107 +108,79 @@ void generate_paths(std::vector<std::vector<MAZE_PATH>> &maze, int &size, std::v
  *  considered is found and connects the current cell with it. If by backtracking the initial cell is reached, it means
  *  that there is no remaining cell to consider and the generation stops.
  *
+ *  The depth first visit is performed iteratively: the current track is an explicit stack of flat cell indices that is
+ *  reserved once, so no heap allocation happens while carving and the maze's size is not limited by the call stack.
+ *  The random values are drawn in the same order as the original recursive visit, so the same seed always produces
+ *  the same maze.
+ *
  *  @param maze It's the matrix representing the maze that is being generated.
  *  @param size Represents the length of each maze's side.
- *  @param curr_index Represents the current index related to the visited cells tracking in the actual path. This will
- *  be used later in order to follow the steps back and find new unvisited cells (backtracking).
- *  @param curr_cell This is the current cell for which the near unvisited cells are being checked. If there is any,
- *  a connection between the 2 is performed by removing the wall in between.
- *  @param curr_track Contains all the coordinates of the visited cells in the current path, and keeps track
- *  of their traversal order.
- *  @param visited_cells This is the matrix used to keep track of all the cells that have been visited.
+ *  @param exit_coords These are the coordinates of the maze's exit, from which the generation starts.
  *  @param rng This is the random number engine to use in order to generate random values.
- *  @param is_exit This flag is used to determine if the current cell corresponds to the exit. If so there is surely only
  *  @param show_steps Flag used to determine if each change step must be shown on screen.
- *  one nearby unvisited cell, but no wall in between. So the wall removal is unneeded.
  */
-void visit_forward(std::vector<std::vector<MAZE_PATH>> &maze, int &size, int &curr_index, std::vector<int> &curr_cell, std::vector<std::vector<int>> &curr_track, std::vector<std::vector<bool>> &visited_cells, std::mt19937 &rng, bool is_exit, bool show_steps) {
+void generate_paths(Maze &maze, int &size, std::vector<int> exit_coords, std::mt19937 &rng, bool show_steps) {
+    // Initializes the visited_cells array to false as no cell has been visited yet
+    // It shares the maze's layout, so cells are addressed by their flat index
+    std::vector<bool> visited_cells(static_cast<size_t>(maze.stride()) * maze.stride(), false);
+
+    // The track can't be longer than the number of walkable cells plus the exit
+    std::vector<int> curr_track;
+    curr_track.reserve(static_cast<size_t>(size / 2) * (size / 2) + 1);
+
+    // Sets the exit cell as first visited cell and selects it as starting cell for the path generation
+    int curr_cell = maze.index(exit_coords[0], exit_coords[1]);
+    visited_cells[curr_cell] = true;
+    curr_track.push_back(curr_cell);
+
+    // The exit cell has a near unvisited cell without the wall in between, while all the other cells
+    // have near unvisited cells separated by walls
+    bool is_exit = true;
+    int near_cells[4];
+
     // Retrieves the nearest cells if there is any
     // Then randomly select one of them and proceeds visiting it
     // If a dead end is found, it backtracks all steps until it finds a new unvisited cell
     // If by backtracking all cells have been visited, the maze has been completely generated
-    int n_cells = 0;
-    std::vector<std::vector<int>> near_cells = get_unvisited_near_cells(maze, curr_cell, size, visited_cells, n_cells, is_exit);
-    // n_cells is updated by the function call above
-    while(n_cells > 0) {
-        curr_index += 1;
-        // Creates the uniform_distributor that will select a random unvisited cell
-        std::uniform_int_distribution<int> uniform_cell_idx(0, n_cells - 1);
-
-        // Uses the distribution above to select the new cell to connect with
-        int new_cell_index = uniform_cell_idx(rng);
-        if(new_cell_index > n_cells - 1) {
-            std::cout << "Wrong index found";
-            exit(1);
-        }
-        std::vector<int> new_cell = near_cells[new_cell_index];
+    // IMPORTANT:
+    // The following loop can't be parallelized as the algorithm to generate the path follows a sequential movement logic
+    while(true) {
+        int n_cells = get_unvisited_near_cells(maze, curr_cell, visited_cells, near_cells, is_exit);
 
-        // Removes the walls only if the current cell is not the exit as the exit cell has a near unvisited cell without
-        // the wall in between.
-        // Non exit cells have near unvisited cells separated by walls
-        if(!is_exit) {
-            int row_to_del = -1;
-            int col_to_del = -1;
-
-            // Removing the wall in between new_cell and curr_cell
+        if(n_cells > 0) {
+            // Creates the uniform_distributor that will select a random unvisited cell
+            std::uniform_int_distribution<int> uniform_cell_idx(0, n_cells - 1);
 
-            // Case in which the 2 cells are located onto the same column
-            if(new_cell[1] == curr_cell[1])
-            {
-                // The wall's cell X coordinate is smaller than new_cell's one and bigger than curr_cell's
-                if(new_cell[0] > curr_cell[0]) {
-                    row_to_del = new_cell[0] - 1;
-                    col_to_del = new_cell[1];
-                }
-                // The wall's cell X coordinate is bigger than new_cell's one and smaller than curr_cell's
-                else {
-                    row_to_del = new_cell[0] + 1;
-                    col_to_del = new_cell[1];
-                }
-            // Case in which the 2 cells are located onto the same row
-            } else if (new_cell[0] == curr_cell[0])
-            {
-                // The wall's cell Y coordinate is smaller than new_cell's one and bigger than curr_cell's
-                if(new_cell[1] > curr_cell[1]) {
-                    row_to_del = new_cell[0];
-                    col_to_del = new_cell[1] - 1;
-                }
-                // The wall's cell Y coordinate is bigger than new_cell's one and smaller than curr_cell's
-                else {
-                    row_to_del = new_cell[0];
-                    col_to_del = new_cell[1] + 1;
-                }
-            }
+            // Uses the distribution above to select the new cell to connect with
+            int new_cell = near_cells[uniform_cell_idx(rng)];
 
-            // Deletes the wall in between the 2 cells
-            if(row_to_del > -1 && col_to_del > -1) {
-                maze[row_to_del][col_to_del] = MAZE_PATH::EMPTY;
+            // Removes the wall in between the 2 cells, which is always located halfway between their flat indexes.
+            // The exit cell is skipped as it has no wall in between
+            if(!is_exit) {
+                maze[(curr_cell + new_cell) / 2] = MAZE_PATH::EMPTY;
                 if(show_steps)
                     display_ascii_maze(maze, size, show_steps);
+            } else {
+                // We are moving from the exit cell to the near unvisited cell
+                is_exit = false;
             }
-            else {
-                std::cout << "Unexpected error while generating the maze path." << std::endl;
-                std::cout << "The selected unvisited cell is not located beside the current one!\nExiting..";
-                exit(1);
-            }
-        // We are moving from the exit cell to the near unvisited cell
+
+            // Sets the new cell as current one to consider
+            curr_cell = new_cell;
+            // Updates the matrix of all the visited cells so far
+            visited_cells[curr_cell] = true;
+            // Updates the current path for the eventual backtracking
+            curr_track.push_back(curr_cell);
         } else {
-            is_exit = false;
+            // Follows the path's steps back until a new unvisited cell is found
+            curr_track.pop_back();
+            // If we reached the exit again it means we visited all maze cells available,
+            // so we can safely stop backtracking
+            if(curr_track.size() <= 1)
+                break;
+            curr_cell = curr_track.back();
         }
-
-        // Sets the new cell as current one to consider
-        curr_cell = new_cell;
-        // Updates the matrix of all the visited cells so far
-        visited_cells[curr_cell[0]][curr_cell[1]] = true;
-        // Updates the current path for the eventual backtracking
-        curr_track.push_back(curr_cell);
-        // Gets the new unvisited cells nearby the current cell if there is any
-        // n_cells is updated by the function call below
-        near_cells = get_unvisited_near_cells(maze, curr_cell, size, visited_cells, n_cells, is_exit);
     }
-    // Follows the path's steps back until a new unvisited cell is found, and then it resumes the path generation
-    // process from there
-    backtrack(maze, size, curr_index, curr_cell, curr_track, visited_cells, rng, show_steps);
 }
 
 
@@ -275,115 +191,29 @@ void visit_forward(std::vector<std::vector<MAZE_PATH>> &maze, int &size, int &cu
  * possible path joining targets.
  *
  *  @param maze It's the matrix representing the maze that is being generated.
- *  @param curr_cell This is the current cell for which the near unvisited cells are being checked.
- *  @param size Represents the length of each maze's side.
+ *  @param curr_cell This is the flat index of the current cell for which the near unvisited cells are being checked.
  *  @param visited_cells This is the matrix used to keep track of all the cells that have been visited.
- *  @param n_cells This is a reference to a variable representing the total count of nearby unvisited cells.
+ *  @param near_cells This array is filled with the flat indexes of the available cells for joining paths.
  *  @param is_exit This flag is used to determine if the current cell corresponds to the exit. If so there is surely only
  *  one nearby unvisited cell, but no wall in between. So the wall removal is unneeded.
  *
- *  @return the matrix containing all the available cells' coordinates for joining paths.
+ *  @return the total count of nearby unvisited cells.
  */
-std::vector<std::vector<int>> get_unvisited_near_cells(std::vector<std::vector<MAZE_PATH>> &maze, std::vector<int> &curr_cell, int &size, std::vector<std::vector<bool>> &visited_cells, int &n_cells, bool is_exit) {
-    // Initialize the matrix to -1 pairs
-    std::vector<std::vector<int>> near_cells;
-    near_cells.reserve(4);
-    n_cells = 0;
+int get_unvisited_near_cells(Maze &maze, int curr_cell, std::vector<bool> &visited_cells, int (&near_cells)[4], bool is_exit) {
+    int n_cells = 0;
     // If the current cell corresponds to the exit, we check for unvisited cells immediately near to it
     // otherwise we look for cells behind walls
     int index_offset = is_exit ? 1 : 2;
-    std::vector<int> curr_pos;
-    curr_pos.reserve(2);
-
-    // Getting the indexes of the cells behind the walls
+    // Getting the indexes of the cells behind the walls, in the east, north, west and south order,
     // and checking if they have been visited already
+    // Cells outside the maze belong to its sentinel border, so they are always seen as walls
+    const int offsets[4] = {index_offset * maze.stride(), index_offset, -index_offset * maze.stride(), -index_offset};
 
-    // Looking for an unvisited cell located at east in relation to the current cell
-    int index = curr_cell[0] + index_offset;
-    if(index >= 0 && index < size && !visited_cells[index][curr_cell[1]] && maze[index][curr_cell[1]] != MAZE_PATH::WALL)
-    {
-        curr_pos.push_back(index);
-        curr_pos.push_back(curr_cell[1]);
-        near_cells.push_back(curr_pos);
-        n_cells += 1;
-    }
-
-    curr_pos.clear();
-
-    // Looking for an unvisited cell located at north in relation to the current cell
-    index = curr_cell[1] + index_offset;
-    if(index >= 0 && index < size && !visited_cells[curr_cell[0]][index] && maze[curr_cell[0]][index] != MAZE_PATH::WALL) {
-        curr_pos.push_back(curr_cell[0]);
-        curr_pos.push_back(index);
-        near_cells.push_back(curr_pos);
-        n_cells += 1;
+    for(int offset : offsets) {
+        int index = curr_cell + offset;
+        if(maze[index] != MAZE_PATH::WALL && !visited_cells[index])
+            near_cells[n_cells++] = index;
     }
 
-    curr_pos.clear();
-
-    // Looking for an unvisited cell located at west in relation to the current cell
-    index = curr_cell[0] - index_offset;
-    if(index >= 0 && index < size && !visited_cells[index][curr_cell[1]] && maze[index][curr_cell[1]] != MAZE_PATH::WALL)
-    {
-        curr_pos.push_back(index);
-        curr_pos.push_back(curr_cell[1]);
-        near_cells.push_back(curr_pos);
-        n_cells += 1;
-    }
-
-    curr_pos.clear();
-
-    // Looking for an unvisited cell located at south in relation to the current cell
-    index = curr_cell[1] - index_offset;
-    if(index >= 0 && index < size && !visited_cells[curr_cell[0]][index] && maze[curr_cell[0]][index] != MAZE_PATH::WALL) {
-        curr_pos.push_back(curr_cell[0]);
-        curr_pos.push_back(index);
-        near_cells.push_back(curr_pos);
-        n_cells += 1;
-    }
-
-    return near_cells;
+    return n_cells;
 }
-
-
-/**
- * Follows the current path back until a new unvisited cell is found nearby.
- *
- *  This function is responsible for following the current path's steps back in order to find new possible routes to
- *  generate the other maze's paths. If by backtracking a cell with at least on nearby unvisited cell is found,
- *  the current track resumes from it and the path generation process can continue.
- *  If the starting cell is reached it means that all the cells in the maze have already been considered and the
- *  generation stops.
- *
- *  @param maze It's the matrix representing the maze that is being generated.
- *  @param size Represents the length of each maze's side.
- *  @param curr_index Represents the current index related to the visited cells tracking in the actual path. This will
- *  be used later in order to follow the steps back and find new unvisited cells (backtracking).
- *  @param curr_cell This is the current cell for which the near unvisited cells are being checked. If there is any,
- *  a connection between the 2 is performed by removing the wall in between.
- *  @param curr_track Contains all the coordinates of the visited cells in the current path, and keeps track
- *  of their traversal order.
- *  @param visited_cells This is the matrix used to keep track of all the cells that have been visited.
- *  @param rng This is the random number engine to use in order to generate random values.
- *  @param show_steps Flag used to determine if each change step must be shown on screen.
- */
-void backtrack(std::vector<std::vector<MAZE_PATH>> &maze, int &size, int &curr_index, std::vector<int> &curr_cell, std::vector<std::vector<int>> &curr_track, std::vector<std::vector<bool>> &visited_cells,  std::mt19937 &rng, bool show_steps) {
-    // Follows the steps back until a new unvisited cell is found or
-    // the maze has been completely visited
-    // Starts from -2 since the latest element in the track corresponds to the latest visited cell (no near unvisited ones)
-    int n_cells = 0;
-
-    // If the track index is 0 we reached the exit again it means we visited all maze cells available,
-    // so we can safely stop backtracking
-    for(int index = curr_index - 1; index > 0; index--) {
-        curr_cell = curr_track[index];
-        curr_track.pop_back();
-        curr_index = index;
-        // n_cells is updated by the function call below
-        get_unvisited_near_cells(maze, curr_cell, size, visited_cells, n_cells, false);
-        if(n_cells > 0) {
-            visit_forward(maze, size, curr_index, curr_cell, curr_track, visited_cells, rng, false, show_steps);
-            break;
-        }
-    }
-}
\ No newline at end of file
@@ -6,21 +6,14 @@
 #include <vector>
 #include <random>
 
-// ENUMS AND STRUCTS
+#include "../../utils/maze/maze.h"
 
-/** This structure is used in order to determine the maze's inner structure and
- * the available cells for the particles' movement.
- */
-enum MAZE_PATH
-{
-    EMPTY = 0x0,
-    WALL = 0x1,
-    EXIT = 0x2,
-    SOLUTION = 0x3,
-    START = 0x4,
-    PARTICLE = 0x5,
-};
+std::vector<int> generate_square_maze(Maze &maze, int &size, std::mt19937 generation_rng, bool show_steps);
 
-void generate_square_maze(std::vector<std::vector<MAZE_PATH>> &maze, int &size, std::mt19937 generation_rng, bool show_steps);
+// Stages of the generation, exported in order to be benchmarked one at a time
+std::vector<int> get_exit_coords(int &size, std::mt19937 &rng);
+void initialize_maze(Maze &maze, int &size, std::vector<int> exit_coords);
+void generate_paths(Maze &maze, int &size, std::vector<int> exit_coords, std::mt19937 &rng, bool show_steps);
+int get_unvisited_near_cells(Maze &maze, int curr_cell, std::vector<bool> &visited_cells, int (&near_cells)[4], bool is_exit);
 
 #endif //RANDOMMAZESOLVER_MAZE_GENERATION_H
\ No newline at end of file
@@ -1,93 +1,18 @@
 // Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
 
 #include <random>
+#include <algorithm>
 #include <iostream>
 #include "maze_solving.h"
 #include "../../utils/utils.h"
-
-
-// ENUM AND STRUCTS
-
-/// Supported movements system for particles' shifting.
-enum MOVES {
-    F = 0, // Used just for particles' initializations (frozen)
-    N = 1,
-    E = 2,
-    S = 3,
-    W = 4,
-};
-
-/// Supported coordinates system for particles' positioning and movements.
-struct Coordinates {
-    Coordinates(int c_x, int c_y) : row(c_x), col(c_y) {}
-
-    int row;
-    int col;
-};
-
-
-/// Struct used to represent a particle and handle it's movements inside the maze
-struct Particle {
-    // F is used just for particles' initializations (frozen)
-    explicit Particle(Coordinates coords) : pos(coords), move(MOVES::F) {
-        this->path.push_back(coords);
-    }
-
-    /**
-     * This function is used to move the particle.
-     *
-     * It allows to update the particle's coordinates and path while it moves randomly and also when backtracking
-     * it's previous movements.
-     * Backtracking is also applied when the particle needs to follow the first particle that exited the maze.
-     * @see backtrack_exited_particle.
-     *
-     * @param new_move This represents the next particle move to implement.
-     * @param backtracking This variable indicates if the particle is going forward or backtracking the previous
-     * movements contained in the track vector.
-     */
-    void update_coordinates(MOVES new_move, bool backtracking=false) {
-        switch (new_move) {
-            case MOVES::N:
-                this->pos = Coordinates(this->pos.row - 1, this->pos.col);
-                break;
-            case MOVES::S:
-                this->pos = Coordinates(this->pos.row + 1, this->pos.col);
-                break;
-            case MOVES::E:
-                this->pos = Coordinates(this->pos.row, this->pos.col + 1);
-                break;
-            case MOVES::W:
-                this->pos = Coordinates(this->pos.row, this->pos.col - 1);
-                break;
-            case MOVES::F:
-                std::cout<< "Unexpected error: the F move is meant only for particles' initialization!" << std::endl;
-                exit(1);
-        }
-
-        int path_size = static_cast<int>(this->path.size());
-        // The first position is always kept
-        // Case in which the particle is backtracking or the new set position is the last but one in the track!
-        // (eventual random backtrack)
-        // This is extremely useful as it frees up memory that would be wasted as some of the contained coordinates are
-        // not relevant for the maze's solution
-        if((backtracking || path_size > 1 && this->pos.row == this->path[path_size - 2].row && this->pos.col == this->path[path_size - 2].col))
-            this->path.pop_back();
-        // Case in which the particle has moved onto a new cell
-        else
-            this->path.push_back(this->pos);
-        this->move = new_move;
-    }
-
-    Coordinates pos;
-    std::vector<Coordinates> path;
-    MOVES move;
-};
+#include "../../utils/philox.h"
+#include "../../utils/maze/move_table.h"
+#include "../../utils/profiler.h"
 
 
 // PROTOTYPES
-std::vector<std::vector<MAZE_PATH>> reach_exit_randomly(std::vector<std::vector<MAZE_PATH>> &maze, int &size, Coordinates &initial_position, std::vector<Particle> &particles, std::mt19937 &rng, bool show_steps);
-std::vector<MOVES> get_possible_moves(std::vector<std::vector<MAZE_PATH>> &maze, int &size, Particle &curr_particle);
-void backtrack_exited_particle(std::vector<std::vector<MAZE_PATH>> &maze, std::vector<std::vector<MAZE_PATH>> &maze_copy, Coordinates &initial_position, int &size, std::vector<Particle> &particles, const std::vector<Coordinates>& exited_particle_path, int exited_particle_index, bool show_steps);
+Maze reach_exit_randomly(Maze &maze, const MoveTable &move_table, int &size, Coordinates &initial_position, std::vector<Particle> &particles, const Philox4x32 &movement_rng, bool show_steps, bool fast_forward, PhaseTimings &timings, SolutionOutcome &outcome);
+uint8_t get_possible_moves(const MoveTable &move_table, Particle &curr_particle);
 MOVES get_next_move_from_path(Particle &particle, Coordinates &next_coords);
 
 
@@ -103,15 +28,21 @@ MOVES get_next_move_from_path(Particle &particle, Coordinates &next_coords);
  * @param n_particles This allows to specify the number of particles to spawn.
  * @param solution_rng This is the random number engine to use in order to generate random values.
  * @param show_steps Flag used to determine if each movement step must be shown on screen.
+ * @param fast_forward Flag used to compute the outcome of the backtracking directly, when the steps are not shown.
+ * @param timings These are the phases' timings of the current execution, the solution's ones are added to them.
+ * @param outcome This receives the exited particle's index, the step in which it has exited and the backtracking's steps.
  * @return the matrix that represents the maze's inner structure along with the solution path.
  */
-std::vector<std::vector<MAZE_PATH>> solve(std::vector<std::vector<MAZE_PATH>> maze, int size, int n_particles, std::mt19937 solution_rng, bool show_steps) {
+Maze solve(Maze maze, int size, int n_particles, std::mt19937 solution_rng, bool show_steps, bool fast_forward, PhaseTimings &timings, SolutionOutcome &outcome) {
+    PhaseClock::time_point setup_start_ts = PhaseClock::now();
+    float setup_start_display = timings.display;
+
     // Choosing a random starting position
     std::uniform_int_distribution<int> uniform_dist(size / 6, 5 * size / 6); // Guaranteed unbiased
 
     // Selects an initial position
     Coordinates initial_position = Coordinates(uniform_dist(solution_rng), uniform_dist(solution_rng));
-    while(maze[initial_position.row][initial_position.col] != MAZE_PATH::EMPTY)
+    while(maze(initial_position.row, initial_position.col) != MAZE_PATH::EMPTY)
         initial_position = Coordinates(uniform_dist(solution_rng), uniform_dist(solution_rng));
 
     // AoS
@@ -125,14 +56,26 @@ std::vector<std::vector<MAZE_PATH>> solve(std::vector<std::vector<MAZE_PATH>> ma
 
     // Initial point always shown
     // Adds the particles to the maze copy in order to show them
-    std::vector<std::vector<MAZE_PATH>> maze_copy = maze;
-    maze_copy[initial_position.row][initial_position.col] = MAZE_PATH::START;
-    display_ascii_maze(maze_copy, size, show_steps);
+    Maze maze_copy = maze;
+    maze_copy(initial_position.row, initial_position.col) = MAZE_PATH::START;
+    display_ascii_maze(maze_copy, size, show_steps, timings);
+
+    // The particles' movements are driven by a counter-based generator, whose key is the next value of the solution's
+    // random sequence. The two halves are drawn in separate statements in order to keep their order well-defined
+    uint64_t movement_seed = static_cast<uint64_t>(solution_rng()) << 32;
+    movement_seed |= solution_rng();
+    Philox4x32 movement_rng(movement_seed);
+
+    // The moves of every cell are computed just once, instead of looking at the cells nearby at each step
+    MoveTable move_table(maze);
 
-    std::cout << "Solving the maze.." << std::endl;
+    // The initial maze's print is already part of the display's phase
+    timings.setup += elapsed_milliseconds_since(setup_start_ts) - (timings.display - setup_start_display);
+
+    execution_output() << "Solving the maze.." << std::endl;
 
     // Starts the solving procedure
-    return reach_exit_randomly(maze, size, initial_position, particles, solution_rng, show_steps);
+    return reach_exit_randomly(maze, move_table, size, initial_position, particles, movement_rng, show_steps, fast_forward, timings, outcome);
 }
 
 /**
@@ -141,119 +84,149 @@ std::vector<std::vector<MAZE_PATH>> solve(std::vector<std::vector<MAZE_PATH>> ma
  * All the particles move around randomly until one of them reaches the maze's exit.
  * Once this happen all the remaining particles start backtracking their own steps.
  * @param maze This is the matrix that represents the maze's structure.
+ * @param move_table This is the table that holds the moves available onto each cell of the maze.
  * @param size This value represents each maze's side size.
  * @param initial_position These are the coordinates that represents the spawn position of all the particles.
  * @param particles This is the vector that contains all the particles.
- * @param rng This is the random number engine to use in order to generate random values.
+ * @param movement_rng This is the counter-based generator used in order to generate the particles' random values.
+ * Each particle draws the value bound to its index and to the current step, so the parallel version reproduces the
+ * same movements.
  * @param show_steps Flag used to determine if each movement step must be shown on screen.
+ * @param fast_forward Flag used to compute the outcome of the backtracking directly, when the steps are not shown.
+ * @param timings These are the phases' timings of the current execution. The time spent printing the steps is
+ * subtracted from the phase that printed them.
+ * @param outcome This receives the exited particle's index, the step in which it has exited and the backtracking's steps.
  * @return the matrix that represents the maze's inner structure along with the solution path.
  */
-std::vector<std::vector<MAZE_PATH>> reach_exit_randomly(std::vector<std::vector<MAZE_PATH>> &maze, int &size, Coordinates &initial_position, std::vector<Particle> &particles, std::mt19937 &rng, bool show_steps) {
-    bool exit_reached = false;
+Maze reach_exit_randomly(Maze &maze, const MoveTable &move_table, int &size, Coordinates &initial_position, std::vector<Particle> &particles, const Philox4x32 &movement_rng, bool show_steps, bool fast_forward, PhaseTimings &timings, SolutionOutcome &outcome) {
     int exited_particle_index = -1;
-    std::vector<std::vector<MAZE_PATH>> maze_copy;
+    uint32_t step = 0;
+    Maze maze_copy;
 
-    while(!exit_reached) {
-        if(show_steps)
-            // Copies the maze to show the particles positions
-            maze_copy = maze;
+    PhaseClock::time_point phase_start_ts = PhaseClock::now();
+    float phase_start_display = timings.display;
 
-        for(int index = 0; index < particles.size(); index++) {
-            Particle curr_particle = particles[index];
-
-            std::vector<MOVES> moves = get_possible_moves(maze, size, curr_particle);
-            bool same_move_allowed = false;
-            for(MOVES move : moves) {
-                // Keeps going on if it can go only on opposite directions
-                if(moves.size() == 2 && curr_particle.move == move) {
-                    same_move_allowed = true;
-                    curr_particle.update_coordinates(move);
-                    break;
-                }
-            }
-            // The same move wasn't available because of the walls nearby
-            if(!same_move_allowed) {
-                // Choosing a random move
-                std::uniform_int_distribution<int> uniform_dist(0, static_cast<int>(moves.size()) - 1); // Guaranteed unbiased
-                MOVES new_move = moves[uniform_dist(rng)];
-                curr_particle.update_coordinates(new_move);
-            }
+    {
+        ProfileScope random_walk_profile("random_walk");
+        while(exited_particle_index < 0) {
+            if(show_steps)
+                // Copies the maze to show the particles positions
+                maze_copy = maze;
 
-            // Updates the particle in the vector
-            particles[index] = curr_particle;
+            exited_particle_index = move_particles(maze, move_table, initial_position, particles, movement_rng, step, maze_copy, show_steps);
+            step++;
 
-            if(show_steps) {
-                // Add the particles to the maze_copy
-                maze_copy[curr_particle.pos.row][curr_particle.pos.col] = MAZE_PATH::PARTICLE;
-                // Shows the start everytime
-                maze_copy[initial_position.row][initial_position.col] = MAZE_PATH::START;
-            }
+            if(show_steps && !maze_copy.empty())
+                // Displays the particles in the maze
+                display_ascii_maze(maze_copy, size, show_steps, timings);
 
-            // The particle has reached the exit
-            if(maze[curr_particle.pos.row][curr_particle.pos.col] == MAZE_PATH::EXIT) {
-                exited_particle_index = index;
-                exit_reached = true;
-                break;
-            }
         }
-
-        if(show_steps && !maze_copy.empty())
-            // Displays the particles in the maze
-            display_ascii_maze(maze_copy, size, show_steps);
-
     }
+    timings.random_walk += elapsed_milliseconds_since(phase_start_ts) - (timings.display - phase_start_display);
+    outcome.exited_particle_index = exited_particle_index;
+    outcome.exit_step = step - 1;
 
+    phase_start_ts = PhaseClock::now();
     std::vector<Coordinates> exited_particle_path = particles[exited_particle_index].path;
 
     // Shows the maze's path that lead to the solution
     for(Coordinates coord : exited_particle_path) {
-        maze[coord.row][coord.col] = MAZE_PATH::SOLUTION;
+        maze(coord.row, coord.col) = MAZE_PATH::SOLUTION;
     }
-    maze[initial_position.row][initial_position.col] = MAZE_PATH::START;
+    maze(initial_position.row, initial_position.col) = MAZE_PATH::START;
+    timings.solution_painting += elapsed_milliseconds_since(phase_start_ts);
 
     // Shows the maze with the solution path
-    display_ascii_maze(maze, size, show_steps);
+    display_ascii_maze(maze, size, show_steps, timings);
 
-    std::cout << "Exit reached!" << std::endl;
-    std::cout << "Backtracking the exited particle.." << std::endl;
+    execution_output() << "Exit reached!" << std::endl;
+    execution_output() << "Backtracking the exited particle.." << std::endl;
 
     // Backtracking the first particle that went out
-    backtrack_exited_particle(maze, maze_copy, initial_position, size, particles, exited_particle_path, exited_particle_index, show_steps);
-
+    // When the steps are not shown, the outcome of the backtracking is known in advance and can be computed directly
+    phase_start_ts = PhaseClock::now();
+    phase_start_display = timings.display;
+    int backtrack_steps;
+    {
+        ProfileScope backtrack_profile("backtrack");
+        if(fast_forward && !show_steps)
+            backtrack_steps = fast_forward_exited_particle(maze, particles, exited_particle_path, exited_particle_index);
+        else
+            backtrack_steps = backtrack_exited_particle(maze, maze_copy, initial_position, size, particles, exited_particle_path, exited_particle_index, show_steps, timings);
+    }
+    timings.backtrack += elapsed_milliseconds_since(phase_start_ts) - (timings.display - phase_start_display);
+    outcome.backtrack_steps = backtrack_steps;
 
-    std::cout << "All particles have reached the exit!" << std::endl;
+    execution_output() << "All particles have reached the exit in " << backtrack_steps << " steps!" << std::endl;
 
     return maze;
 }
 
 
 /**
- * This function is used to determine the available moves for the current particle.
+ * Moves all the particles by one step.
  *
- * The moves are selected based onto the state of the cells nearby in the maze.
- * If a near cell does not contain a wall, then it represent a possible move.
+ * The particles are moved in order, and the step stops as soon as one of them reaches the exit: the particles after it
+ * keep their positions of the previous step. The parallel version follows the same rule, so both the versions start
+ * backtracking from the same particles' positions.
  * @param maze This is the matrix that represents the maze's structure.
- * @param size This value represents each maze's side size.
- * @param curr_particle This is the particle for which the moves are being evaluated.
- * @return A vector of moves representing the next possible shifts of the current particle.
+ * @param move_table This is the table that holds the moves available onto each cell of the maze.
+ * @param initial_position These are the coordinates that represents the spawn position of all the particles.
+ * @param particles This is the vector that contains all the particles.
+ * @param movement_rng This is the counter-based generator used in order to generate the particles' random values.
+ * @param step This is the current step of the movements.
+ * @param maze_copy This matrix is used only for printing purposes to not alter the maze itself.
+ * @param show_steps Flag used to determine if each movement step must be shown on screen.
+ * @return the index of the particle that has reached the exit, -1 if there is none.
  */
-std::vector<MOVES> get_possible_moves(std::vector<std::vector<MAZE_PATH>> &maze, int &size, Particle &curr_particle) {
-    std::vector<MOVES> moves;
-    moves.reserve(4);
+int move_particles(Maze &maze, const MoveTable &move_table, Coordinates &initial_position, std::vector<Particle> &particles, const Philox4x32 &movement_rng, uint32_t step, Maze &maze_copy, bool show_steps) {
+    for(int index = 0; index < particles.size(); index++) {
+        Particle curr_particle = particles[index];
+
+        uint8_t moves = get_possible_moves(move_table, curr_particle);
+        int n_moves = moves_count(moves);
+        MOVES new_move;
+        // Keeps going on if it can go only on opposite directions
+        if(n_moves == 2 && moves_mask(moves) & MOVE_BIT[curr_particle.move]) {
+            new_move = curr_particle.move;
+        }
+        // The same move wasn't available because of the walls nearby
+        else {
+            // Choosing a random move
+            uint32_t random_value = movement_rng.particle_value(static_cast<uint32_t>(index), step);
+            new_move = MOVES_DECODE[moves_mask(moves)][bounded_index(random_value, n_moves)];
+        }
+        curr_particle.update_coordinates(new_move);
 
-    if(-1 < curr_particle.pos.row - 1 < size && maze[curr_particle.pos.row - 1][curr_particle.pos.col] != MAZE_PATH::WALL)
-        moves.push_back(MOVES::N);
+        // Updates the particle in the vector
+        particles[index] = curr_particle;
+
+        if(show_steps) {
+            // Add the particles to the maze_copy
+            maze_copy(curr_particle.pos.row, curr_particle.pos.col) = MAZE_PATH::PARTICLE;
+            // Shows the start everytime
+            maze_copy(initial_position.row, initial_position.col) = MAZE_PATH::START;
+        }
 
-    if(-1 < curr_particle.pos.row + 1 < size && maze[curr_particle.pos.row + 1][curr_particle.pos.col] != MAZE_PATH::WALL)
-        moves.push_back(MOVES::S);
+        // The particle has reached the exit
+        if(maze(curr_particle.pos.row, curr_particle.pos.col) == MAZE_PATH::EXIT)
+            return index;
+    }
 
-    if(-1 < curr_particle.pos.col - 1 < size && maze[curr_particle.pos.row][curr_particle.pos.col - 1] != MAZE_PATH::WALL)
-        moves.push_back(MOVES::W);
+    return -1;
+}
 
-    if(-1 < curr_particle.pos.col + 1 < size && maze[curr_particle.pos.row][curr_particle.pos.col + 1] != MAZE_PATH::WALL)
-        moves.push_back(MOVES::E);
 
-    return moves;
+/**
+ * This function is used to determine the available moves for the current particle.
+ *
+ * The moves have been computed once after the generation, so this is just a lookup into the table.
+ * @param move_table This is the table that holds the moves available onto each cell of the maze.
+ * @param curr_particle This is the particle for which the moves are being evaluated.
+ * @return the encoded moves of the cell, to be decoded with moves_mask, moves_count and MOVES_DECODE.
+ */
+uint8_t get_possible_moves(const MoveTable &move_table, Particle &curr_particle) {
+    return move_table(curr_particle.pos.row, curr_particle.pos.col);
 }
 
 /**
@@ -270,8 +243,10 @@ std::vector<MOVES> get_possible_moves(std::vector<std::vector<MAZE_PATH>> &maze,
  * @param exited_particle_path This vector contains the steps required to reach the exit starting from the initial position.
  * @param exited_particle_index This integer number represents the exited particle's index related to the particles' vector.
  * @param show_steps Flag used to determine if each movement step must be shown on screen.
+ * @param timings These are the phases' timings of the current execution, the steps' prints are added to them.
+ * @return the number of steps required for all the particles to exit.
  */
-void backtrack_exited_particle(std::vector<std::vector<MAZE_PATH>> &maze, std::vector<std::vector<MAZE_PATH>> &maze_copy, Coordinates &initial_position, int &size, std::vector<Particle> &particles, const std::vector<Coordinates>& exited_particle_path, int exited_particle_index, bool show_steps) {
+int backtrack_exited_particle(Maze &maze, Maze &maze_copy, Coordinates &initial_position, int &size, std::vector<Particle> &particles, const std::vector<Coordinates>& exited_particle_path, int exited_particle_index, bool show_steps, PhaseTimings &timings) {
     int n_particles = static_cast<int>(particles.size());
     std::vector<bool> particles_on_track_map;
     particles_on_track_map.reserve(n_particles);
@@ -288,13 +263,15 @@ void backtrack_exited_particle(std::vector<std::vector<MAZE_PATH>> &maze, std::v
     exited_particles_map[exited_particle_index] = true;
 
     int n_exited_particles = 1;
+    int steps = 0;
     maze_copy.clear();
 
     while(n_exited_particles < particles.size()) {
+        steps++;
         if(show_steps) {
             // Resets the maze to show the steps
             maze_copy = maze;
-            maze_copy[initial_position.row][initial_position.col] = MAZE_PATH::START;
+            maze_copy(initial_position.row, initial_position.col) = MAZE_PATH::START;
         }
 
         // Backtracking the particles movements until they are on the solution path
@@ -339,7 +316,7 @@ void backtrack_exited_particle(std::vector<std::vector<MAZE_PATH>> &maze, std::v
 
                     // Displays the particle's position
                     if(show_steps) {
-                        maze_copy[particle.pos.row][particle.pos.col] = MAZE_PATH::PARTICLE;
+                        maze_copy(particle.pos.row, particle.pos.col) = MAZE_PATH::PARTICLE;
                     }
                 } else if (!exited_particles_map[particle_index]){
                     n_exited_particles += 1;
@@ -348,21 +325,70 @@ void backtrack_exited_particle(std::vector<std::vector<MAZE_PATH>> &maze, std::v
             } else {
                 // Displays the particle's position
                 if(show_steps) {
-                    maze_copy[particles[particle_index].pos.row][particles[particle_index].pos.col] = MAZE_PATH::PARTICLE;
+                    maze_copy(particles[particle_index].pos.row, particles[particle_index].pos.col) = MAZE_PATH::PARTICLE;
                 }
             }
         }
 
         if(show_steps)
-            display_ascii_maze(maze_copy, size, show_steps);
+            display_ascii_maze(maze_copy, size, show_steps, timings);
     }
-//    for(Particle particle : particles) {
-//        std::cout << particle.pos.row << " nn " << particle.pos.col << std::endl;
-//        if(particle.pos.row != exited_particle_path.back().row || particle.pos.col != exited_particle_path.back().col) {
-//            std::cout << "Wrong" << std::endl;
-//            exit(0);
-//        }
-//    }
+    return steps;
+}
+
+
+/**
+ * This function computes the outcome of the backtracking without moving the particles step by step.
+ *
+ * Each particle would walk back its own path until it reaches the solution's path, and then it would follow it until
+ * the exit. So its exit step is known from the position of the last cell of its path that is part of the solution.
+ * The particles are left onto the exit, as they would be by backtrack_exited_particle.
+ * @param maze This is the matrix that represents the maze's structure.
+ * @param particles This is the vector that contains all the particles.
+ * @param exited_particle_path This vector contains the steps required to reach the exit starting from the initial position.
+ * @param exited_particle_index This integer number represents the exited particle's index related to the particles' vector.
+ * @return the number of steps required for all the particles to exit.
+ */
+int fast_forward_exited_particle(Maze &maze, std::vector<Particle> &particles, const std::vector<Coordinates>& exited_particle_path, int exited_particle_index) {
+    int solution_length = static_cast<int>(exited_particle_path.size()) - 1;
+    Coordinates exit_coords = exited_particle_path.back();
+
+    // Position of each cell onto the solution's path, -1 for the cells that are not part of it
+    std::vector<int> solution_index(static_cast<size_t>(maze.stride()) * static_cast<size_t>(maze.stride()), -1);
+    for(int path_index = 0; path_index <= solution_length; path_index++) {
+        solution_index[maze.index(exited_particle_path[path_index].row, exited_particle_path[path_index].col)] = path_index;
+    }
+
+    int steps = 0;
+    for(int particle_index = 0; particle_index < particles.size(); particle_index++) {
+        if(particle_index == exited_particle_index)
+            continue;
+
+        Particle particle = particles[particle_index];
+        // The first position of the path is the initial one, that is always part of the solution
+        int track_index = static_cast<int>(particle.path.size()) - 1;
+        while(solution_index[maze.index(particle.path[track_index].row, particle.path[track_index].col)] < 0)
+            track_index--;
+        int steps_back = static_cast<int>(particle.path.size()) - 1 - track_index;
+        int path_index = solution_index[maze.index(particle.path[track_index].row, particle.path[track_index].col)];
+
+        // The last move is the one that led to the exit, or the last step back if the particle joined the solution's
+        // path onto the exit itself
+        if(path_index < solution_length) {
+            particle.pos = exited_particle_path[solution_length - 1];
+            particle.move = get_next_move_from_path(particle, exit_coords);
+        } else if(steps_back > 0) {
+            particle.pos = particle.path[track_index + 1];
+            particle.move = get_next_move_from_path(particle, particle.path[track_index]);
+        }
+        particle.pos = exit_coords;
+        particle.path.clear();
+        particles[particle_index] = particle;
+
+        steps = std::max(steps, steps_back + solution_length - path_index + 1);
+    }
+
+    return steps;
 }
 
 
@@ -5,7 +5,16 @@
 
 #include <vector>
 #include "maze_generation.h"
+#include "particle.h"
+#include "../../utils/philox.h"
+#include "../../utils/phase_timings.h"
+#include "../../utils/solution_outcome.h"
 
-std::vector<std::vector<MAZE_PATH>> solve(std::vector<std::vector<MAZE_PATH>> maze, int size, int n_particles, std::mt19937 solution_rng, bool show_steps);
+Maze solve(Maze maze, int size, int n_particles, std::mt19937 solution_rng, bool show_steps, bool fast_forward, PhaseTimings &timings, SolutionOutcome &outcome);
+
+// Stages of the solution, exported in order to be benchmarked one at a time
+int move_particles(Maze &maze, const MoveTable &move_table, Coordinates &initial_position, std::vector<Particle> &particles, const Philox4x32 &movement_rng, uint32_t step, Maze &maze_copy, bool show_steps);
+int backtrack_exited_particle(Maze &maze, Maze &maze_copy, Coordinates &initial_position, int &size, std::vector<Particle> &particles, const std::vector<Coordinates>& exited_particle_path, int exited_particle_index, bool show_steps, PhaseTimings &timings);
+int fast_forward_exited_particle(Maze &maze, std::vector<Particle> &particles, const std::vector<Coordinates>& exited_particle_path, int exited_particle_index);
 
 #endif //RANDOMMAZESOLVER_MAZE_SOLVING_H
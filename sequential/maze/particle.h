@@ -0,0 +1,71 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#ifndef RANDOMMAZESOLVER_PARTICLE_H
+#define RANDOMMAZESOLVER_PARTICLE_H
+
+#include <iostream>
+#include <vector>
+
+#include "../../utils/maze/coordinates.h"
+#include "../../utils/maze/move_table.h"
+
+// ENUMS AND STRUCTS
+
+/// Struct used to represent a particle and handle it's movements inside the maze
+struct Particle {
+    // F is used just for particles' initializations (frozen)
+    explicit Particle(Coordinates coords) : pos(coords), move(MOVES::F) {
+        this->path.push_back(coords);
+    }
+
+    /**
+     * This function is used to move the particle.
+     *
+     * It allows to update the particle's coordinates and path while it moves randomly and also when backtracking
+     * it's previous movements.
+     * Backtracking is also applied when the particle needs to follow the first particle that exited the maze.
+     * @see backtrack_exited_particle.
+     *
+     * @param new_move This represents the next particle move to implement.
+     * @param backtracking This variable indicates if the particle is going forward or backtracking the previous
+     * movements contained in the track vector.
+     */
+    void update_coordinates(MOVES new_move, bool backtracking=false) {
+        switch (new_move) {
+            case MOVES::N:
+                this->pos = Coordinates(this->pos.row - 1, this->pos.col);
+                break;
+            case MOVES::S:
+                this->pos = Coordinates(this->pos.row + 1, this->pos.col);
+                break;
+            case MOVES::E:
+                this->pos = Coordinates(this->pos.row, this->pos.col + 1);
+                break;
+            case MOVES::W:
+                this->pos = Coordinates(this->pos.row, this->pos.col - 1);
+                break;
+            case MOVES::F:
+                std::cout<< "Unexpected error: the F move is meant only for particles' initialization!" << std::endl;
+                exit(1);
+        }
+
+        int path_size = static_cast<int>(this->path.size());
+        // The first position is always kept
+        // Case in which the particle is backtracking or the new set position is the last but one in the track!
+        // (eventual random backtrack)
+        // This is extremely useful as it frees up memory that would be wasted as some of the contained coordinates are
+        // not relevant for the maze's solution
+        if(backtracking || (path_size > 1 && this->pos.row == this->path[path_size - 2].row && this->pos.col == this->path[path_size - 2].col))
+            this->path.pop_back();
+        // Case in which the particle has moved onto a new cell
+        else
+            this->path.push_back(this->pos);
+        this->move = new_move;
+    }
+
+    Coordinates pos;
+    std::vector<Coordinates> path;
+    MOVES move;
+};
+
+#endif //RANDOMMAZESOLVER_PARTICLE_H
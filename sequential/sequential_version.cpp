@@ -4,6 +4,8 @@
 #include <random>
 
 #include "maze/maze_solving.h"
+#include "../utils/maze/packed_maze.h"
+#include "../utils/profiler.h"
 
 
 /**
@@ -15,12 +17,47 @@
  * @param generation_rng This is the random number engine to use for the random generation values.
  * @param solution_rng This is the random number engine to use for the random solution values.
  * @param show_steps Flag used to determine if each movement step must be shown on screen.
+ * @param fast_forward Flag used to compute the outcome of the backtracking directly, when the steps are not shown.
+ * @param timings These are the phases' timings of the current execution, filled by the generation and the solution.
+ * @param outcome This receives the exited particle's index, the step in which it has exited and the backtracking's steps.
+ * @param exit_coords This receives the coordinates of the generated maze's exit.
  * @return This is the matrix that represents the maze's inner structure along with the solution path.
  */
-std::vector<std::vector<MAZE_PATH>> sequential_solution(std::vector<std::vector<MAZE_PATH>> maze, int &size, int n_particles, std::mt19937 generation_rng, std::mt19937 solution_rng, bool show_steps) {
+Maze sequential_solution(Maze maze, int &size, int n_particles, std::mt19937 generation_rng, std::mt19937 solution_rng, bool show_steps, bool fast_forward, PhaseTimings &timings, SolutionOutcome &outcome, std::vector<int> &exit_coords) {
+    PhaseClock::time_point generation_start_ts = PhaseClock::now();
+
     // Generates a square maze with the specified width and height if given
     // Otherwise a random maze is generated
-    generate_square_maze(maze, size, generation_rng, show_steps);
+    {
+        ProfileScope generation_profile("generation");
+        exit_coords = generate_square_maze(maze, size, generation_rng, show_steps);
+    }
+    timings.generation += elapsed_milliseconds_since(generation_start_ts);
+
+    return solve(maze, size, n_particles, solution_rng, show_steps, fast_forward, timings, outcome);
+}
+
+
+/**
+ * This function is the sequential access point used to solve randomly a maze that has already been generated.
+ *
+ * @param loaded_maze This is the packed structure that represents the maze, usually attached to a maze file.
+ * @param size This value represents each maze's side size.
+ * @param n_particles This allows to specify the number of particles to spawn.
+ * @param solution_rng This is the random number engine to use for the random solution values.
+ * @param show_steps Flag used to determine if each movement step must be shown on screen.
+ * @param fast_forward Flag used to compute the outcome of the backtracking directly, when the steps are not shown.
+ * @param timings These are the phases' timings of the current execution, filled by the generation and the solution.
+ * @param outcome This receives the exited particle's index, the step in which it has exited and the backtracking's steps.
+ * @return This is the matrix that represents the maze's inner structure along with the solution path.
+ */
+Maze sequential_solution(const PackedMaze &loaded_maze, int &size, int n_particles, std::mt19937 solution_rng, bool show_steps, bool fast_forward, PhaseTimings &timings, SolutionOutcome &outcome) {
+    PhaseClock::time_point setup_start_ts = PhaseClock::now();
+
+    // The sequential solver works onto the MAZE_PATH grid only
+    Maze maze;
+    loaded_maze.to_maze(maze);
+    timings.setup += elapsed_milliseconds_since(setup_start_ts);
 
-    return solve(maze, size, n_particles, solution_rng, show_steps);
+    return solve(maze, size, n_particles, solution_rng, show_steps, fast_forward, timings, outcome);
 }
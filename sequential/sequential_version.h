@@ -4,7 +4,11 @@
 #define RANDOMMAZESOLVER_SEQUENTIAL_VERSION_H
 
 #include "maze/maze_generation.h"
+#include "../utils/phase_timings.h"
+#include "../utils/maze/packed_maze.h"
+#include "../utils/solution_outcome.h"
 
-std::vector<std::vector<MAZE_PATH>> sequential_solution(std::vector<std::vector<MAZE_PATH>> maze, int &size, int n_particles, std::mt19937 generation_rng, std::mt19937 solution_rng, bool show_steps);
+Maze sequential_solution(Maze maze, int &size, int n_particles, std::mt19937 generation_rng, std::mt19937 solution_rng, bool show_steps, bool fast_forward, PhaseTimings &timings, SolutionOutcome &outcome, std::vector<int> &exit_coords);
+Maze sequential_solution(const PackedMaze &loaded_maze, int &size, int n_particles, std::mt19937 solution_rng, bool show_steps, bool fast_forward, PhaseTimings &timings, SolutionOutcome &outcome);
 
 #endif //RANDOMMAZESOLVER_SEQUENTIAL_VERSION_H
@@ -0,0 +1,64 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <string>
+
+#include "tests.h"
+#include "../parallel/maze/maze_solving.h"
+
+
+// FUNCTIONS
+
+/**
+ * Checks the moments of the binomial draws of the aggregate simulation, and that splitting a cell's count never
+ * loses or creates particles.
+ *
+ * Both the geometric inversion, used when few successes are expected, and the BTRS are covered. The sample mean must
+ * be within 5 standard errors of the expected one, and the sample variance within 5% of the expected one.
+ */
+void test_binomial_draws() {
+    struct BinomialCase {
+        uint64_t count;
+        double probability;
+    };
+    const BinomialCase cases[] = {{20, 0.25}, {30, 0.3}, {100, 0.5}, {1000, 1.0 / 3}, {1000000, 0.25}};
+    const int n_samples = 40000;
+    Philox4x32 rng(7);
+
+    for(uint32_t item = 0; item < std::size(cases); item++) {
+        const BinomialCase &binomial = cases[item];
+        std::string description = std::to_string(binomial.count) + " trials with probability " + std::to_string(binomial.probability);
+        PhiloxStream stream(rng, item, 0);
+
+        double sum = 0;
+        double squares_sum = 0;
+        bool within_count = true;
+        for(int sample = 0; sample < n_samples; sample++) {
+            uint64_t successes = p_draw_binomial(binomial.count, binomial.probability, stream);
+            within_count &= successes <= binomial.count;
+            sum += static_cast<double>(successes);
+            squares_sum += static_cast<double>(successes) * static_cast<double>(successes);
+        }
+        double mean = sum / n_samples;
+        double variance = (squares_sum - sum * mean) / (n_samples - 1);
+
+        double expected_mean = static_cast<double>(binomial.count) * binomial.probability;
+        double expected_variance = expected_mean * (1 - binomial.probability);
+        check(within_count, "successes within the trials, " + description);
+        check(std::abs(mean - expected_mean) <= 5 * std::sqrt(expected_variance / n_samples), "binomial mean, " + description);
+        check(std::abs(variance - expected_variance) <= 0.05 * expected_variance, "binomial variance, " + description);
+    }
+
+    // A cell open in every direction splits its count among 4 moves
+    PhiloxStream stream(rng, 0, 1);
+    uint8_t cell_moves = encode_moves(OPEN_N | OPEN_E | OPEN_S | OPEN_W);
+    bool conserved = true;
+    for(uint64_t count : {1ULL, 7ULL, 40ULL, 1000ULL, 123456789ULL}) {
+        std::array<uint64_t, 5> cell_outgoing {};
+        p_split_count(count, cell_moves, stream, cell_outgoing.data());
+        conserved &= std::accumulate(cell_outgoing.begin(), cell_outgoing.end(), 0ULL) == count && cell_outgoing[MOVES::F] == 0;
+    }
+    check(conserved, "split counts conserve the particles");
+}
@@ -0,0 +1,218 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "tests.h"
+#include "../sequential/maze/maze_generation.h"
+#include "../parallel/maze/maze_generation.h"
+#include "../sequential/sequential_version.h"
+#include "../parallel/parallel_version.h"
+#include "../utils/maze/maze_file.h"
+#include "../utils/results_writer.h"
+
+
+// FUNCTIONS
+
+/**
+ * Checks that a maze saved into a binary maze file is loaded back unchanged, along with its header, that a corrupted
+ * payload is detected by the checksum and that the sizes outside of the allowed range are rejected.
+ */
+void test_maze_file_round_trip() {
+    // The process' id keeps concurrent runs of the tests apart
+    std::filesystem::path maze_path = std::filesystem::temp_directory_path() / ("maze_file_test_" + std::to_string(getpid()) + ".rmz");
+
+    for(int size : {51, 53, 101}) {
+        std::string description = "size " + std::to_string(size);
+
+        Maze maze;
+        int generated_size = size;
+        std::vector<int> exit_coords = generate_square_maze(maze, generated_size, std::mt19937(size), false);
+        PackedMaze packed;
+        packed.from_maze(maze);
+
+        MazeFileHeader header {};
+        header.exit_row = exit_coords[0];
+        header.exit_col = exit_coords[1];
+        header.algorithm = GENERATION_ALGORITHM::DEPTH_FIRST;
+        header.generation_seed = size;
+        header.solution_seed = -1;
+        if(!check(save_maze_file(maze_path, header, packed), "maze file saved, " + description))
+            continue;
+
+        {
+            MappedMazeFile maze_file;
+            if(check(maze_file.open(maze_path, true), "maze file loaded, " + description)) {
+                const MazeFileHeader &loaded_header = maze_file.header();
+                check(loaded_header.size == size, "loaded size, " + description);
+                check(loaded_header.exit_row == header.exit_row && loaded_header.exit_col == header.exit_col, "loaded exit, " + description);
+                check(loaded_header.algorithm == header.algorithm, "loaded algorithm, " + description);
+                check(loaded_header.generation_seed == header.generation_seed && loaded_header.solution_seed == header.solution_seed, "loaded seeds, " + description);
+
+                PackedMaze loaded_packed;
+                maze_file.attach(loaded_packed);
+                Maze loaded_maze;
+                loaded_packed.to_maze(loaded_maze);
+                check(loaded_maze == maze, "loaded maze, " + description);
+            }
+        }
+
+        // Flips a bit of the payload's last byte
+        {
+            std::fstream maze_stream(maze_path, std::ios::in | std::ios::out | std::ios::binary);
+            maze_stream.seekg(-1, std::ios::end);
+            char last_byte = static_cast<char>(maze_stream.get());
+            maze_stream.seekp(-1, std::ios::end);
+            maze_stream.put(static_cast<char>(last_byte ^ 0x1));
+        }
+        MappedMazeFile corrupted_file;
+        check(!corrupted_file.open(maze_path, true), "corrupted maze file rejected, " + description);
+    }
+
+    // The sizes outside of the allowed range are rejected even when the rest of the file is valid. The payload of the
+    // largest one is left sparse, apart from the exit
+    for(int size : {SIDE_MIN - 2, SIDE_MAX + 2, 46341}) {
+        std::string description = "size " + std::to_string(size);
+
+        size_t n_nodes_side = static_cast<size_t>(size - 1) / 2;
+        MazeFileHeader header {};
+        header.exit_row = 0;
+        header.exit_col = 1;
+        header.algorithm = GENERATION_ALGORITHM::DEPTH_FIRST;
+        PackedMaze packed(size < SIDE_MIN ? size : 3);
+        packed.open(0, OPEN_DIRECTION::OPEN_N);
+        if(!check(save_maze_file(maze_path, header, packed), "maze file saved, " + description))
+            continue;
+        {
+            // Rewrites the header's size and the payload's length
+            std::fstream maze_stream(maze_path, std::ios::in | std::ios::out | std::ios::binary);
+            maze_stream.read(reinterpret_cast<char *>(&header), sizeof(MazeFileHeader));
+            header.size = size;
+            header.payload_bytes = (n_nodes_side * n_nodes_side + 1) / 2;
+            maze_stream.seekp(0);
+            maze_stream.write(reinterpret_cast<const char *>(&header), sizeof(MazeFileHeader));
+        }
+        std::filesystem::resize_file(maze_path, sizeof(MazeFileHeader) + header.payload_bytes);
+
+        MappedMazeFile out_of_range_file;
+        check(!out_of_range_file.open(maze_path, false), "maze file's size out of range rejected, " + description);
+    }
+
+    std::filesystem::remove(maze_path);
+}
+
+
+/**
+ * Checks that a solved maze is saved with the exit chosen by its generation, even though the solution's path has been
+ * painted over it, and that a file whose exit doesn't match its maze is rejected.
+ */
+void test_solved_maze_file() {
+    std::filesystem::path maze_path = std::filesystem::temp_directory_path() / ("solved_maze_file_test_" + std::to_string(getpid()) + ".rmz");
+
+    for(long seed = 1; seed <= 3; seed++) {
+        std::string description = "seed " + std::to_string(seed);
+
+        int size = 51;
+        PhaseTimings timings;
+        SolutionOutcome outcome;
+        std::vector<int> exit_coords;
+        Maze solved_maze = sequential_solution(Maze(), size, 64, std::mt19937(seed), std::mt19937(seed), false, true, timings, outcome, exit_coords);
+        if(!check(outcome.exited_particle_index >= 0, "a particle exits, " + description))
+            continue;
+        check(solved_maze(exit_coords[0], exit_coords[1]) == MAZE_PATH::SOLUTION, "exit painted by the solution, " + description);
+
+        save_binary_maze(maze_path, solved_maze, Coordinates(exit_coords[0], exit_coords[1]), GENERATION_ALGORITHM::DEPTH_FIRST, seed, seed);
+        {
+            MappedMazeFile maze_file;
+            if(check(maze_file.open(maze_path, true), "solved maze file loaded, " + description)) {
+                const MazeFileHeader &header = maze_file.header();
+                check(header.exit_row == exit_coords[0] && header.exit_col == exit_coords[1], "saved exit, " + description);
+
+                PackedMaze loaded_packed;
+                maze_file.attach(loaded_packed);
+                check(loaded_packed.cell(exit_coords[0], exit_coords[1]) == MAZE_PATH::EXIT, "exit of the loaded maze, " + description);
+            }
+        }
+
+        // Moves the exit onto the other border, where the maze is closed
+        save_binary_maze(maze_path, solved_maze, Coordinates(exit_coords[1], exit_coords[0]), GENERATION_ALGORITHM::DEPTH_FIRST, seed, seed);
+        MappedMazeFile mismatching_file;
+        check(!mismatching_file.open(maze_path, true), "mismatching exit rejected, " + description);
+    }
+
+    std::filesystem::remove(maze_path);
+}
+
+
+/**
+ * Checks that a maze streamed into a binary maze file is perfect, with a single exit, and that it is the same maze
+ * collected into memory by the streamed generation. The file must be solved by attaching to its mapping.
+ */
+void test_streamed_maze_file() {
+    std::filesystem::path maze_path = std::filesystem::temp_directory_path() / ("streamed_maze_file_test_" + std::to_string(getpid()) + ".rmz");
+    GeneratorContext context;
+
+    // Both odd and even numbers of nodes per side, so that some rows end in the middle of a byte
+    for(int size : {51, 53, 101}) {
+        for(long seed = 1; seed <= 3; seed++) {
+            std::string description = "size " + std::to_string(size) + ", seed " + std::to_string(seed);
+
+            MazeFileWriter writer;
+            int generated_size = size;
+            if(!check(writer.open(maze_path, size), "streamed maze file created, " + description))
+                continue;
+            p_generate_streamed_maze(generated_size, std::mt19937(seed), [&writer](int, const std::vector<uint8_t> &open_masks) {
+                writer.write_row(open_masks);
+            }, context);
+            MazeFileHeader header {};
+            header.exit_row = context.exit_coords[0];
+            header.exit_col = context.exit_coords[1];
+            header.algorithm = GENERATION_ALGORITHM::ELLER;
+            header.generation_seed = seed;
+            header.solution_seed = -1;
+            if(!check(writer.close(header), "streamed maze file written, " + description))
+                continue;
+
+            PackedMaze collected_packed(size);
+            generated_size = size;
+            p_generate_streamed_maze(generated_size, std::mt19937(seed), [&collected_packed](int node_row, const std::vector<uint8_t> &open_masks) {
+                collected_packed.store_row(node_row, open_masks);
+            }, context);
+
+            MappedMazeFile maze_file;
+            if(!check(maze_file.open(maze_path, true), "streamed maze file loaded, " + description))
+                continue;
+            PackedMaze loaded_packed;
+            maze_file.attach(loaded_packed);
+            check(loaded_packed.bytes() == collected_packed.bytes() &&
+                  std::equal(loaded_packed.data(), loaded_packed.data() + loaded_packed.bytes(), collected_packed.data()),
+                  "streamed maze file matches the collected maze, " + description);
+
+            Maze loaded_maze;
+            loaded_packed.to_maze(loaded_maze);
+            check_perfect_maze(loaded_maze, description);
+        }
+    }
+
+    // The parallel version solves the streamed maze from the file, without building the grid
+    for(long seed = 1; seed <= 3; seed++) {
+        std::string description = "parallel version, seed " + std::to_string(seed);
+
+        SolverContext solver_context;
+        int size = 51;
+        PhaseTimings timings;
+        PhaseCounters counters;
+        SolutionOutcome outcome;
+        Maze &solved_maze = parallel_solution(solver_context, size, 64, std::mt19937(seed), std::mt19937(seed), false, true, true, false, false, 1, true, maze_path, seed, timings, counters, outcome);
+        check(outcome.exited_particle_index >= 0, "a particle exits the streamed maze, " + description);
+        check(solved_maze.empty() && solver_context.maze.empty(), "grid never built, " + description);
+        check(solver_context.packed.bytes() == static_cast<size_t>(25 * 25 + 1) / 2, "packed maze attached to the file, " + description);
+    }
+
+    std::filesystem::remove(maze_path);
+}
@@ -0,0 +1,115 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#include <array>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "tests.h"
+#include "../utils/maze/move_stack.h"
+
+
+// PROTOTYPES
+MOVES random_move(std::mt19937 &rng);
+bool same_moves(const MoveStackArena &arena, const MoveStack &stack, const std::vector<MOVES> &expected);
+
+
+// FUNCTIONS
+
+/**
+ * Checks the stacks of moves against plain vectors, while their tops cross the chunks' boundaries.
+ *
+ * The stacks are interleaved, so their chunks are mixed into the arena, and one of them grows past the first block of
+ * chunks. Then the tops move back and forth across a boundary, which goes through the spare chunks.
+ */
+void test_move_stack_arena() {
+    const uint32_t chunk_moves = MoveStackArena::CHUNK_MOVES;
+    MoveStackArena arena;
+    std::array<MoveStack, 3> stacks {};
+    std::array<std::vector<MOVES>, 3> expected_stacks;
+    std::mt19937 rng(1);
+
+    for(uint32_t move = 0; move < 3 * chunk_moves + 17; move++) {
+        for(size_t stack = 0; stack < stacks.size(); stack++) {
+            MOVES new_move = random_move(rng);
+            arena.push(stacks[stack], new_move);
+            expected_stacks[stack].push_back(new_move);
+        }
+    }
+    for(size_t stack = 0; stack < stacks.size(); stack++) {
+        check(stacks[stack].length == expected_stacks[stack].size(), "length after the pushes, stack " + std::to_string(stack));
+        check(same_moves(arena, stacks[stack], expected_stacks[stack]), "moves after the pushes, stack " + std::to_string(stack));
+    }
+
+    // Moves the first stack's top back and forth across the boundary of its second chunk
+    MoveStack &stack = stacks[0];
+    std::vector<MOVES> &expected = expected_stacks[0];
+    for(int crossing = 0; crossing < 4; crossing++) {
+        while(expected.size() > chunk_moves - 3) {
+            bool same_top = arena.top(stack) == expected.back();
+            bool same_pop = arena.pop(stack) == expected.back();
+            expected.pop_back();
+            if(!check(same_top && same_pop, "popped moves, crossing " + std::to_string(crossing)))
+                return;
+        }
+        while(expected.size() < chunk_moves + 3) {
+            MOVES new_move = random_move(rng);
+            arena.push(stack, new_move);
+            expected.push_back(new_move);
+        }
+        check(same_moves(arena, stack, expected), "moves after crossing " + std::to_string(crossing));
+    }
+
+    // The other stacks are not affected by the first one
+    check(same_moves(arena, stacks[1], expected_stacks[1]) && same_moves(arena, stacks[2], expected_stacks[2]), "untouched stacks");
+
+    // A cleared stack starts over
+    arena.clear(stacks[1]);
+    expected_stacks[1].clear();
+    check(stacks[1].empty(), "cleared stack is empty");
+    for(uint32_t move = 0; move < chunk_moves + 1; move++) {
+        arena.push(stacks[1], static_cast<MOVES>(MOVES::N + move % 4));
+        expected_stacks[1].push_back(static_cast<MOVES>(MOVES::N + move % 4));
+    }
+    check(same_moves(arena, stacks[1], expected_stacks[1]), "moves after clearing");
+
+    // Grows the last stack past the arena's first block of chunks
+    for(uint32_t move = 0; move < 1100 * chunk_moves; move++) {
+        MOVES new_move = random_move(rng);
+        arena.push(stacks[2], new_move);
+        expected_stacks[2].push_back(new_move);
+    }
+    check(same_moves(arena, stacks[2], expected_stacks[2]), "moves past the first block");
+
+    bool same_pops = true;
+    while(!expected_stacks[2].empty()) {
+        same_pops &= arena.pop(stacks[2]) == expected_stacks[2].back();
+        expected_stacks[2].pop_back();
+    }
+    check(same_pops && stacks[2].empty(), "stack popped down to its bottom");
+}
+
+
+/**
+ * Compares the moves of a stack with the expected ones.
+ *
+ * @param arena This is the arena that holds the stack.
+ * @param stack This is the stack to check.
+ * @param expected These are the expected moves, from the bottom to the top of the stack.
+ * @return true if the stack holds exactly the expected moves.
+ */
+bool same_moves(const MoveStackArena &arena, const MoveStack &stack, const std::vector<MOVES> &expected) {
+    return stack.length == expected.size() && arena.moves(stack) == expected &&
+           (expected.empty() || arena.top(stack) == expected.back());
+}
+
+
+/**
+ * Draws one of the moves that can be stored into a stack.
+ *
+ * @param rng This is the random number engine to use in order to generate random values.
+ * @return a move other than F.
+ */
+MOVES random_move(std::mt19937 &rng) {
+    return static_cast<MOVES>(MOVES::N + rng() % 4);
+}
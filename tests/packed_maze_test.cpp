@@ -0,0 +1,52 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#include <random>
+#include <string>
+
+#include "tests.h"
+#include "../sequential/maze/maze_generation.h"
+#include "../parallel/maze/maze_generation.h"
+#include "../utils/maze/packed_maze.h"
+
+
+// FUNCTIONS
+
+/**
+ * Checks that packing a maze and expanding it back gives the same maze, and that the packed generation carves the
+ * same maze as the single visit onto the grid.
+ */
+void test_packed_maze_round_trip() {
+    GeneratorContext context;
+
+    for(int size : {3, 25, 51}) {
+        for(long seed = 1; seed <= 3; seed++) {
+            std::string description = "size " + std::to_string(size) + ", seed " + std::to_string(seed);
+
+            Maze maze;
+            int generated_size = size;
+            generate_square_maze(maze, generated_size, std::mt19937(seed), false);
+
+            PackedMaze packed;
+            packed.from_maze(maze);
+            check(packed.size() == size, "packed maze's size, " + description);
+
+            bool same_cells = true;
+            for(int row = 0; row < size; row++) {
+                for(int col = 0; col < size; col++)
+                    same_cells &= packed.cell(row, col) == maze(row, col);
+            }
+            check(same_cells, "packed maze's cells, " + description);
+
+            Maze expanded_maze;
+            packed.to_maze(expanded_maze);
+            check(expanded_maze == maze, "expanded packed maze, " + description);
+
+            PackedMaze generated_packed;
+            generated_size = size;
+            p_generate_packed_maze(generated_packed, generated_size, std::mt19937(seed), context);
+            Maze generated_maze;
+            generated_packed.to_maze(generated_maze);
+            check(generated_maze == maze, "packed generation, " + description);
+        }
+    }
+}
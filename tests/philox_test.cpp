@@ -0,0 +1,40 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#include <array>
+#include <cstdint>
+
+#include "tests.h"
+#include "../utils/philox.h"
+
+
+// FUNCTIONS
+
+/**
+ * Checks the generator against the known answers of the reference Random123 implementation of Philox4x32-10.
+ *
+ * The particles' values are bound to their counters, so they are checked to be the first word of the same output.
+ */
+void test_philox_known_answers() {
+    struct KnownAnswer {
+        uint64_t seed;
+        std::array<uint32_t, 4> counter;
+        std::array<uint32_t, 4> output;
+    };
+    // The key's first word is the seed's lower half
+    const KnownAnswer known_answers[] = {
+        {0, {0, 0, 0, 0}, {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}},
+        {UINT64_MAX, {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}},
+        {0x299f31d0a4093822, {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}},
+    };
+
+    for(const KnownAnswer &known_answer : known_answers) {
+        Philox4x32 rng(known_answer.seed);
+        check(rng(known_answer.counter) == known_answer.output, "Philox4x32-10 known answer");
+    }
+
+    Philox4x32 rng(0x299f31d0a4093822);
+    for(uint32_t particle = 0; particle < 4; particle++) {
+        for(uint32_t step = 0; step < 4; step++)
+            check(rng.particle_value(particle, step) == rng({step, particle, 0, 0})[0], "particle's value bound to its counter");
+    }
+}
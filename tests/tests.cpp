@@ -0,0 +1,145 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "tests.h"
+
+
+// GLOBAL VARIABLES
+// Test cases by the name given to CTest
+const std::map<std::string, std::function<void()>> TEST_CASES = {
+    {"walk_equivalence", test_walk_equivalence},
+    {"philox_known_answers", test_philox_known_answers},
+    {"packed_maze_round_trip", test_packed_maze_round_trip},
+    {"maze_file_round_trip", test_maze_file_round_trip},
+    {"solved_maze_file", test_solved_maze_file},
+    {"streamed_maze_file", test_streamed_maze_file},
+    {"move_stack_arena", test_move_stack_arena},
+    {"binomial_draws", test_binomial_draws},
+    {"tiled_generation", test_tiled_generation},
+};
+int failed_checks = 0;
+
+
+// FUNCTIONS
+
+/**
+ * Runs the test cases given as arguments, or all of them when there is none.
+ *
+ * @param argc This is the number of arguments.
+ * @param argv These are the names of the test cases to run.
+ * @return 0 if every check has passed, 1 otherwise.
+ */
+int main(int argc, char *argv[]) {
+    for(int arg = 1; arg < argc; arg++) {
+        if(!TEST_CASES.contains(argv[arg])) {
+            std::cerr << "Unknown test case: " << argv[arg] << std::endl;
+            return 1;
+        }
+    }
+
+    for(const auto &[name, test_case] : TEST_CASES) {
+        bool selected = argc == 1;
+        for(int arg = 1; arg < argc; arg++)
+            selected |= name == argv[arg];
+        if(!selected)
+            continue;
+
+        std::cout << "Running " << name << ".." << std::endl;
+        test_case();
+    }
+
+    if(failed_checks > 0) {
+        std::cerr << failed_checks << " checks have failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+
+/**
+ * Records the outcome of a check, and reports it when it fails.
+ *
+ * The test cases go on after a failed check, so that all the failures are reported at once.
+ * @param condition This is the condition that must hold.
+ * @param description This describes what has been checked.
+ * @return the condition itself.
+ */
+bool check(bool condition, const std::string &description) {
+    if(!condition) {
+        std::cerr << "FAILED: " << description << std::endl;
+        failed_checks++;
+    }
+    return condition;
+}
+
+
+/**
+ * Checks that a generated maze is perfect, with a single exit onto its border.
+ *
+ * The walls are kept on the even rows and columns, so the nodes are the cells on the odd ones and each opening is a
+ * cell in between 2 of them. A perfect maze connects all its nodes by exactly one path, which means that every node is
+ * reachable and that there is one opening less than the nodes.
+ * @param maze This is the maze to check, before it is solved.
+ * @param description This describes the maze, in order to report the failed checks.
+ */
+void check_perfect_maze(const Maze &maze, const std::string &description) {
+    int size = maze.size();
+    long n_nodes = static_cast<long>(size / 2) * (size / 2);
+    long n_openings = 0;
+    int n_exits = 0;
+    int exit_index = -1;
+    bool closed_border = true;
+    bool open_nodes = true;
+    bool closed_corners = true;
+    for(int row = 0; row < size; row++) {
+        for(int col = 0; col < size; col++) {
+            MAZE_PATH cell = maze(row, col);
+            if(row == 0 || col == 0 || row == size - 1 || col == size - 1) {
+                if(cell == MAZE_PATH::EXIT) {
+                    n_exits++;
+                    exit_index = maze.index(row, col);
+                } else {
+                    closed_border &= cell == MAZE_PATH::WALL;
+                }
+            } else if(row % 2 == 1 && col % 2 == 1) {
+                open_nodes &= cell == MAZE_PATH::EMPTY;
+            } else if((row + col) % 2 == 1) {
+                n_openings += cell != MAZE_PATH::WALL;
+            } else {
+                closed_corners &= cell == MAZE_PATH::WALL;
+            }
+        }
+    }
+    check(n_exits == 1, "single exit, " + description);
+    check(closed_border, "closed border, " + description);
+    check(open_nodes, "open nodes, " + description);
+    check(closed_corners, "closed walls' corners, " + description);
+    check(n_openings == n_nodes - 1, "openings one less than the nodes, " + description);
+    if(exit_index < 0)
+        return;
+
+    // Visits the maze from its exit. The sentinel border stops the visit at the maze's edges
+    std::vector<bool> visited_cells(static_cast<size_t>(maze.stride()) * maze.stride(), false);
+    std::vector<int> track = {exit_index};
+    visited_cells[exit_index] = true;
+    long n_reached_nodes = 0;
+    while(!track.empty()) {
+        int index = track.back();
+        track.pop_back();
+        if(maze.row_of(index) % 2 == 1 && maze.col_of(index) % 2 == 1)
+            n_reached_nodes++;
+        for(int offset : {1, -1, maze.stride(), -maze.stride()}) {
+            int near_index = index + offset;
+            if(maze[near_index] != MAZE_PATH::WALL && !visited_cells[near_index]) {
+                visited_cells[near_index] = true;
+                track.push_back(near_index);
+            }
+        }
+    }
+    check(n_reached_nodes == n_nodes, "all nodes reachable from the exit, " + description);
+}
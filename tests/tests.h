@@ -0,0 +1,24 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#ifndef RANDOMMAZESOLVER_TESTS_H
+#define RANDOMMAZESOLVER_TESTS_H
+
+#include <string>
+
+#include "../utils/maze/maze.h"
+
+bool check(bool condition, const std::string &description);
+void check_perfect_maze(const Maze &maze, const std::string &description);
+
+// Test cases, each one registered into tests.cpp and run by CTest on its own
+void test_walk_equivalence();
+void test_philox_known_answers();
+void test_packed_maze_round_trip();
+void test_maze_file_round_trip();
+void test_solved_maze_file();
+void test_streamed_maze_file();
+void test_move_stack_arena();
+void test_binomial_draws();
+void test_tiled_generation();
+
+#endif //RANDOMMAZESOLVER_TESTS_H
@@ -0,0 +1,37 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#include <random>
+#include <string>
+
+#include "tests.h"
+#include "../parallel/maze/maze_generation.h"
+
+
+// FUNCTIONS
+
+/**
+ * Checks that the mazes carved by tiles are perfect, and that they depend on the seed and on the number of tiles but
+ * not on the number of threads that carve them.
+ */
+void test_tiled_generation() {
+    GeneratorContext context;
+
+    for(int size : {51, 101}) {
+        for(int n_tiles_side : {2, 3, 4}) {
+            for(long seed = 1; seed <= 3; seed++) {
+                std::string description = "size " + std::to_string(size) + ", " + std::to_string(n_tiles_side) +
+                                          " tiles per side, seed " + std::to_string(seed);
+
+                Maze single_thread_maze;
+                int generated_size = size;
+                p_generate_square_maze(single_thread_maze, generated_size, std::mt19937(seed), n_tiles_side, 1, context);
+                check_perfect_maze(single_thread_maze, description);
+
+                Maze multi_thread_maze;
+                generated_size = size;
+                p_generate_square_maze(multi_thread_maze, generated_size, std::mt19937(seed), n_tiles_side, 4, context);
+                check(multi_thread_maze == single_thread_maze, "same maze with 1 and 4 threads, " + description);
+            }
+        }
+    }
+}
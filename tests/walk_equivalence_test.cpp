@@ -0,0 +1,62 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#include <omp.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "tests.h"
+#include "../sequential/sequential_version.h"
+#include "../parallel/parallel_version.h"
+
+
+// FUNCTIONS
+
+/**
+ * Checks that the two versions walk the particles exactly in the same way, as the deterministic mode expects.
+ *
+ * The mazes are generated by a single visit, so both the versions solve the same one. The same particle must exit in
+ * the same step, the backtracking must take the same steps, and the solved mazes must be equal, with any number of
+ * threads, onto both the maze's representations and whether the backtracking is stepped or computed directly.
+ * The parallel version must reach the same outcome when it doesn't paint the solution.
+ */
+void test_walk_equivalence() {
+    const int n_particles = 320;
+    SolverContext context;
+
+    for(int n_threads : {1, 3}) {
+        omp_set_num_threads(n_threads);
+        for(long seed = 1; seed <= 3; seed++) {
+            for(bool packed_maze : {false, true}) {
+                for(bool fast_forward : {false, true}) {
+                    std::string description = "seed " + std::to_string(seed) + ", " + std::to_string(n_threads) + " threads" +
+                                              (packed_maze ? ", packed maze" : "") + (fast_forward ? ", fast forward" : "");
+
+                    int sequential_size = 25;
+                    PhaseTimings sequential_timings;
+                    SolutionOutcome sequential_outcome;
+                    std::vector<int> exit_coords;
+                    Maze sequential_maze = sequential_solution(Maze(), sequential_size, n_particles, std::mt19937(seed), std::mt19937(seed), false, fast_forward, sequential_timings, sequential_outcome, exit_coords);
+
+                    int parallel_size = 25;
+                    PhaseTimings parallel_timings;
+                    PhaseCounters counters;
+                    SolutionOutcome parallel_outcome;
+                    Maze &parallel_maze = parallel_solution(context, parallel_size, n_particles, std::mt19937(seed), std::mt19937(seed), false, fast_forward, packed_maze, true, false, 1, false, {}, seed, parallel_timings, counters, parallel_outcome);
+
+                    check(sequential_outcome.exited_particle_index >= 0, "a particle exits, " + description);
+                    check(sequential_outcome.exited_particle_index == parallel_outcome.exited_particle_index, "same exited particle, " + description);
+                    check(sequential_outcome.exit_step == parallel_outcome.exit_step, "same exit step, " + description);
+                    check(sequential_outcome.backtrack_steps == parallel_outcome.backtrack_steps, "same backtracking steps, " + description);
+                    check(sequential_maze == parallel_maze, "same solved maze, " + description);
+
+                    // Without painting the solution, the outcome is the same but no grid is built
+                    SolutionOutcome unpainted_outcome;
+                    Maze &unpainted_maze = parallel_solution(context, parallel_size, n_particles, std::mt19937(seed), std::mt19937(seed), false, fast_forward, packed_maze, false, false, 1, false, {}, seed, parallel_timings, counters, unpainted_outcome);
+                    check(unpainted_outcome == parallel_outcome, "same outcome without painting, " + description);
+                    check(unpainted_maze.empty(), "no solved maze without painting, " + description);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,17 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#ifndef RANDOMMAZESOLVER_COORDINATES_H
+#define RANDOMMAZESOLVER_COORDINATES_H
+
+// ENUMS AND STRUCTS
+
+/// Supported coordinates system for particles' positioning and movements.
+struct Coordinates {
+    Coordinates() : row(-1), col(-1) {}
+    Coordinates(int c_x, int c_y) : row(c_x), col(c_y) {}
+
+    int row;
+    int col;
+};
+
+#endif //RANDOMMAZESOLVER_COORDINATES_H
@@ -0,0 +1,18 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#include "maze.h"
+
+
+// FUNCTIONS
+
+/**
+ * Resizes the grid in order to hold a maze with the given side's length.
+ *
+ * The whole buffer, sentinel border included, is filled with walls. The maze's generation is responsible for carving
+ * the inner paths.
+ * @param size Represents the length of each maze's side.
+ */
+void Maze::resize(int size) {
+    this->side = size;
+    this->cells.assign(static_cast<size_t>(size + 2) * static_cast<size_t>(size + 2), MAZE_PATH::WALL);
+}
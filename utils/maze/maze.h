@@ -0,0 +1,76 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#ifndef RANDOMMAZESOLVER_MAZE_H
+#define RANDOMMAZESOLVER_MAZE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// GLOBAL VARIABLES
+// Limits of each maze's side. The generation is iterative, so the size is only limited by the memory and by the flat
+// indexes of the maze's cells, which must fit into an int
+constexpr int SIDE_MIN = 51;
+constexpr int SIDE_MAX = 40001;
+
+// ENUMS AND STRUCTS
+
+/** This structure is used in order to determine the maze's inner structure and
+ * the available cells for the particles' movement.
+ * Each value fits into a single byte, so that the whole maze can be stored into a compact buffer.
+ */
+enum MAZE_PATH : uint8_t
+{
+    EMPTY = 0x0,
+    WALL = 0x1,
+    EXIT = 0x2,
+    SOLUTION = 0x3,
+    START = 0x4,
+    PARTICLE = 0x5,
+};
+
+
+/**
+ * Square grid used to store the maze's inner structure.
+ *
+ * All the cells are stored row by row into a single contiguous buffer of 1-byte cells. The grid is surrounded by a
+ * border of WALL cells (sentinels) that are not part of the maze itself: this way the 4 cells nearby any cell of the
+ * maze, including the ones located onto its edges, can always be read without checking the bounds.
+ * Cells are addressed either by their (row, col) coordinates in [0, size) or by their flat index in the buffer.
+ */
+class Maze {
+public:
+    Maze() = default;
+    explicit Maze(int size) { this->resize(size); }
+
+    void resize(int size);
+
+    /// Length of each maze's side, the sentinel border excluded.
+    [[nodiscard]] int size() const { return this->side; }
+
+    /// Distance between two vertically adjacent cells in the buffer.
+    [[nodiscard]] int stride() const { return this->side + 2; }
+
+    /// Flat buffer index of the cell located at the given coordinates. -1 and size are valid sentinel coordinates.
+    [[nodiscard]] int index(int row, int col) const { return (row + 1) * this->stride() + col + 1; }
+    [[nodiscard]] int row_of(int index) const { return index / this->stride() - 1; }
+    [[nodiscard]] int col_of(int index) const { return index % this->stride() - 1; }
+
+    MAZE_PATH &operator()(int row, int col) { return this->cells[this->index(row, col)]; }
+    const MAZE_PATH &operator()(int row, int col) const { return this->cells[this->index(row, col)]; }
+    MAZE_PATH &operator[](int index) { return this->cells[index]; }
+    const MAZE_PATH &operator[](int index) const { return this->cells[index]; }
+
+    [[nodiscard]] MAZE_PATH *data() { return this->cells.data(); }
+    [[nodiscard]] const MAZE_PATH *data() const { return this->cells.data(); }
+    [[nodiscard]] bool empty() const { return this->cells.empty(); }
+    void clear() { this->side = 0; this->cells.clear(); }
+
+    bool operator==(const Maze &other) const = default;
+
+private:
+    int side = 0;
+    std::vector<MAZE_PATH> cells;
+};
+
+#endif //RANDOMMAZESOLVER_MAZE_H
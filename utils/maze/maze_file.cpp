@@ -0,0 +1,306 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "maze_file.h"
+
+
+// PROTOTYPES
+void set_format_fields(MazeFileHeader &header, int size, uint64_t payload_bytes, uint64_t checksum);
+
+// GLOBAL VARIABLES
+constexpr std::array<char, 8> MAZE_FILE_MAGIC = {'R', 'M', 'S', 'M', 'A', 'Z', 'E', '\0'};
+constexpr uint32_t MAZE_FILE_VERSION = 2;
+
+
+// FUNCTIONS
+
+/**
+ * Maps a binary maze file into memory and checks its header, along with the exit it describes.
+ *
+ * @param path This is the location of the file.
+ * @param verify Flag used to check the payload's checksum too. This reads the whole file.
+ * @return true if the file has been mapped and it is valid, false otherwise.
+ */
+bool MappedMazeFile::open(const std::filesystem::path &path, bool verify) {
+    this->close();
+
+    int descriptor = ::open(path.c_str(), O_RDONLY);
+    if(descriptor < 0) {
+        std::cout << "Unable to open the maze file " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct stat file_stat {};
+    if(fstat(descriptor, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < sizeof(MazeFileHeader)) {
+        std::cout << "The maze file " << path << " is too short" << std::endl;
+        ::close(descriptor);
+        return false;
+    }
+
+    // The private mapping is writable, but the changes are never written back to the file
+    size_t file_bytes = static_cast<size_t>(file_stat.st_size);
+    void *mapping = mmap(nullptr, file_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, descriptor, 0);
+    ::close(descriptor);
+    if(mapping == MAP_FAILED) {
+        std::cout << "Unable to map the maze file " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    this->mapping = static_cast<uint8_t *>(mapping);
+    this->mapping_bytes = file_bytes;
+
+    // The size must be one that the versions can solve, since the grid's flat indexes must fit into an int
+    const MazeFileHeader &header = this->header();
+    size_t n_nodes_side = header.size > 0 ? static_cast<size_t>(header.size - 1) / 2 : 0;
+    bool valid = header.magic == MAZE_FILE_MAGIC && header.version == MAZE_FILE_VERSION &&
+                 header.header_bytes == sizeof(MazeFileHeader) && header.size >= SIDE_MIN && header.size <= SIDE_MAX && header.size % 2 == 1 &&
+                 header.payload_bytes == (n_nodes_side * n_nodes_side + 1) / 2 &&
+                 header.header_bytes + header.payload_bytes <= file_bytes;
+    if(!valid) {
+        std::cout << "The maze file " << path << " has an invalid header" << std::endl;
+        this->close();
+        return false;
+    }
+
+    if(verify && maze_checksum(this->mapping + header.header_bytes, header.payload_bytes) != header.checksum) {
+        std::cout << "The maze file " << path << " is corrupted" << std::endl;
+        this->close();
+        return false;
+    }
+
+    // The exit must be an opening of the payload's border
+    PackedMaze payload;
+    payload.attach(header.size, this->mapping + header.header_bytes);
+    bool on_border = header.exit_row == 0 || header.exit_col == 0 || header.exit_row == header.size - 1 || header.exit_col == header.size - 1;
+    bool valid_exit = on_border && header.exit_row >= 0 && header.exit_row < header.size && header.exit_col >= 0 &&
+                      header.exit_col < header.size && payload.cell(header.exit_row, header.exit_col) == MAZE_PATH::EXIT;
+    if(!valid_exit) {
+        std::cout << "The maze file " << path << " has an exit that doesn't match its maze" << std::endl;
+        this->close();
+        return false;
+    }
+
+    // The payload is read sequentially by the expansions and randomly by the particles
+    madvise(this->mapping, this->mapping_bytes, MADV_WILLNEED);
+    return true;
+}
+
+
+/**
+ * Unmaps the file, if any.
+ */
+void MappedMazeFile::close() {
+    if(this->mapping)
+        munmap(this->mapping, this->mapping_bytes);
+    this->mapping = nullptr;
+    this->mapping_bytes = 0;
+}
+
+
+MappedMazeFile::~MappedMazeFile() {
+    this->close();
+}
+
+
+/**
+ * Lets a packed maze use the mapped payload as its nodes' masks.
+ *
+ * No data is copied, so the maze can be used only while the file is mapped.
+ * @param maze This is the packed structure that will represent the maze.
+ */
+void MappedMazeFile::attach(PackedMaze &maze) {
+    maze.attach(this->header().size, this->mapping + this->header().header_bytes);
+}
+
+
+/**
+ * Computes the checksum of a maze file's payload.
+ *
+ * This is the 64-bit FNV-1a hash, applied to 8 bytes at a time in order to keep up with the disk.
+ * @param data This is the payload.
+ * @param n_bytes This is the size of the payload.
+ * @return the checksum.
+ */
+uint64_t maze_checksum(const uint8_t *data, size_t n_bytes) {
+    MazeChecksum checksum;
+    checksum.update(data, n_bytes);
+    return checksum.value();
+}
+
+
+/**
+ * Adds the next bytes of the payload to the checksum.
+ *
+ * @param data These are the next bytes.
+ * @param n_bytes This is the number of bytes.
+ */
+void MazeChecksum::update(const uint8_t *data, size_t n_bytes) {
+    size_t offset = 0;
+    // Completes the word started by the previous bytes
+    while(this->n_pending_bytes > 0 && offset < n_bytes) {
+        this->pending_bytes[this->n_pending_bytes++] = data[offset++];
+        if(this->n_pending_bytes == 8) {
+            this->add_word(this->pending_bytes.data());
+            this->n_pending_bytes = 0;
+        }
+    }
+    for(; offset + 8 <= n_bytes; offset += 8)
+        this->add_word(data + offset);
+    for(; offset < n_bytes; offset++)
+        this->pending_bytes[this->n_pending_bytes++] = data[offset];
+}
+
+
+/**
+ * Computes the checksum of the bytes added so far.
+ *
+ * The last bytes that don't fill a whole word are hashed one at a time.
+ * @return the checksum.
+ */
+uint64_t MazeChecksum::value() const {
+    uint64_t checksum = this->checksum;
+    for(size_t byte = 0; byte < this->n_pending_bytes; byte++)
+        checksum = (checksum ^ this->pending_bytes[byte]) * 0x100000001b3ULL;
+    return checksum;
+}
+
+
+void MazeChecksum::add_word(const uint8_t *word) {
+    uint64_t value;
+    std::memcpy(&value, word, 8);
+    this->checksum = (this->checksum ^ value) * 0x100000001b3ULL;
+}
+
+
+/**
+ * Sets the fields of a header that describe the file's format and its payload.
+ *
+ * @param header This is the header, whose description of the maze has been filled by the caller.
+ * @param size Represents the length of each maze's side.
+ * @param payload_bytes This is the size of the nodes' masks.
+ * @param checksum This is the checksum of the nodes' masks.
+ */
+void set_format_fields(MazeFileHeader &header, int size, uint64_t payload_bytes, uint64_t checksum) {
+    header.magic = MAZE_FILE_MAGIC;
+    header.version = MAZE_FILE_VERSION;
+    header.header_bytes = sizeof(MazeFileHeader);
+    header.size = size;
+    header.payload_bytes = payload_bytes;
+    header.checksum = checksum;
+}
+
+
+/**
+ * Saves a packed maze into a binary maze file.
+ *
+ * The caller fills the header's description of the maze, while its format related fields are set here.
+ * @param path This is the location of the file.
+ * @param header This is the header of the file.
+ * @param maze This is the packed structure that represents the maze.
+ * @return true if the file has been written, false otherwise.
+ */
+bool save_maze_file(const std::filesystem::path &path, MazeFileHeader header, const PackedMaze &maze) {
+    set_format_fields(header, maze.size(), maze.bytes(), maze_checksum(maze.data(), maze.bytes()));
+
+    std::ofstream output_file(path, std::ios::binary);
+    output_file.write(reinterpret_cast<const char *>(&header), sizeof(MazeFileHeader));
+    output_file.write(reinterpret_cast<const char *>(maze.data()), static_cast<std::streamsize>(maze.bytes()));
+    output_file.close();
+
+    if(!output_file) {
+        std::cout << "Unable to write the maze file " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+
+/**
+ * Creates the file and reserves the space of its header.
+ *
+ * @param path This is the location of the file.
+ * @param size Represents the length of each maze's side.
+ * @return true if the file has been created, false otherwise.
+ */
+bool MazeFileWriter::open(const std::filesystem::path &path, int size) {
+    this->path = path;
+    this->side = size;
+    this->checksum = MazeChecksum();
+    this->payload_bytes = 0;
+    this->has_pending_mask = false;
+    this->row_bytes.clear();
+    this->row_bytes.reserve(static_cast<size_t>(size - 1) / 4 + 1);
+
+    // The header stays empty until the maze is complete, so an interrupted file is never valid
+    MazeFileHeader header {};
+    this->output_file.open(path, std::ios::binary | std::ios::trunc);
+    this->output_file.write(reinterpret_cast<const char *>(&header), sizeof(MazeFileHeader));
+    if(!this->output_file) {
+        std::cout << "Unable to write the maze file " << path << std::endl;
+        this->output_file.close();
+        return false;
+    }
+    return true;
+}
+
+
+/**
+ * Appends the next row of nodes to the payload.
+ *
+ * @param open_masks These are the nodes' masks of open directions, from the first column to the last one.
+ */
+void MazeFileWriter::write_row(const std::vector<uint8_t> &open_masks) {
+    this->row_bytes.clear();
+    size_t node_col = 0;
+    if(this->has_pending_mask && !open_masks.empty()) {
+        this->row_bytes.push_back(this->pending_mask | static_cast<uint8_t>(open_masks[0] << 4));
+        this->has_pending_mask = false;
+        node_col = 1;
+    }
+    for(; node_col + 1 < open_masks.size(); node_col += 2)
+        this->row_bytes.push_back(open_masks[node_col] | static_cast<uint8_t>(open_masks[node_col + 1] << 4));
+    if(node_col < open_masks.size()) {
+        this->pending_mask = open_masks[node_col];
+        this->has_pending_mask = true;
+    }
+
+    this->output_file.write(reinterpret_cast<const char *>(this->row_bytes.data()), static_cast<std::streamsize>(this->row_bytes.size()));
+    this->checksum.update(this->row_bytes.data(), this->row_bytes.size());
+    this->payload_bytes += this->row_bytes.size();
+}
+
+
+/**
+ * Completes the payload and writes the final header.
+ *
+ * @param header This is the header of the file. The caller fills the description of the maze, while its format
+ * related fields are set here.
+ * @return true if the whole file has been written, false otherwise.
+ */
+bool MazeFileWriter::close(MazeFileHeader header) {
+    // The last node of an odd number of nodes takes a whole byte
+    if(this->has_pending_mask) {
+        this->output_file.put(static_cast<char>(this->pending_mask));
+        this->checksum.update(&this->pending_mask, 1);
+        this->payload_bytes++;
+        this->has_pending_mask = false;
+    }
+
+    set_format_fields(header, this->side, this->payload_bytes, this->checksum.value());
+    this->output_file.seekp(0);
+    this->output_file.write(reinterpret_cast<const char *>(&header), sizeof(MazeFileHeader));
+    this->output_file.close();
+
+    if(!this->output_file) {
+        std::cout << "Unable to write the maze file " << this->path << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,120 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#ifndef RANDOMMAZESOLVER_MAZE_FILE_H
+#define RANDOMMAZESOLVER_MAZE_FILE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "packed_maze.h"
+
+// ENUMS AND STRUCTS
+
+/// Algorithms that can generate a maze.
+enum GENERATION_ALGORITHM : uint32_t {
+    DEPTH_FIRST = 0,
+    TILED_DEPTH_FIRST = 1,
+    ELLER = 2,
+};
+
+
+/**
+ * Fixed size header of a binary maze file.
+ *
+ * The header is followed by the nodes' masks, laid out exactly as in PackedMaze, so that the file can be mapped into
+ * memory and solved without copying or decoding it. All the values are stored with the machine's byte order.
+ */
+struct MazeFileHeader {
+    std::array<char, 8> magic;
+    uint32_t version;
+    uint32_t header_bytes;
+    int32_t size;
+    int32_t exit_row;
+    int32_t exit_col;
+    uint32_t algorithm;
+    int64_t generation_seed;
+    int64_t solution_seed;
+    uint64_t payload_bytes;
+    uint64_t checksum;
+};
+
+static_assert(sizeof(MazeFileHeader) == 64, "The maze file's header must not contain any padding");
+
+
+/**
+ * Read only view of a binary maze file mapped into memory.
+ *
+ * The mapping is private, so the pages are shared with the page cache and they are copied only if they get modified.
+ * The file is unmapped when the view is destroyed.
+ */
+class MappedMazeFile {
+public:
+    MappedMazeFile() = default;
+    ~MappedMazeFile();
+    MappedMazeFile(const MappedMazeFile &) = delete;
+    MappedMazeFile &operator=(const MappedMazeFile &) = delete;
+
+    bool open(const std::filesystem::path &path, bool verify);
+    void close();
+
+    [[nodiscard]] const MazeFileHeader &header() const { return *reinterpret_cast<const MazeFileHeader *>(this->mapping); }
+    void attach(PackedMaze &maze);
+
+private:
+    uint8_t *mapping = nullptr;
+    size_t mapping_bytes = 0;
+};
+
+/**
+ * Checksum of a maze file's payload, computed while its bytes are produced.
+ *
+ * Feeding the payload in pieces gives the same value as maze_checksum onto the whole payload.
+ */
+class MazeChecksum {
+public:
+    void update(const uint8_t *data, size_t n_bytes);
+    [[nodiscard]] uint64_t value() const;
+
+private:
+    void add_word(const uint8_t *word);
+
+    uint64_t checksum = 0xcbf29ce484222325ULL;
+    // Bytes that don't fill a whole word yet
+    std::array<uint8_t, 8> pending_bytes {};
+    size_t n_pending_bytes = 0;
+};
+
+
+/**
+ * Writes a binary maze file one row of nodes at a time, so that it can be used as the sink of a streamed generation.
+ *
+ * Only the current row is kept in memory. The nodes are packed as in PackedMaze, so when a row ends in the middle of a
+ * byte its last node is written along with the first one of the next row. The header is written again once the maze
+ * is complete, and until then the file is not valid.
+ */
+class MazeFileWriter {
+public:
+    bool open(const std::filesystem::path &path, int size);
+    void write_row(const std::vector<uint8_t> &open_masks);
+    bool close(MazeFileHeader header);
+
+private:
+    std::filesystem::path path;
+    std::ofstream output_file;
+    int side = 0;
+    MazeChecksum checksum;
+    uint64_t payload_bytes = 0;
+    std::vector<uint8_t> row_bytes;
+    // Node of the previous row that shares its byte with the first node of the next row
+    uint8_t pending_mask = 0;
+    bool has_pending_mask = false;
+};
+
+uint64_t maze_checksum(const uint8_t *data, size_t n_bytes);
+bool save_maze_file(const std::filesystem::path &path, MazeFileHeader header, const PackedMaze &maze);
+
+#endif //RANDOMMAZESOLVER_MAZE_FILE_H
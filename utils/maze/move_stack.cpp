@@ -0,0 +1,178 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#include <algorithm>
+#include <bit>
+#include "move_stack.h"
+
+
+// FUNCTIONS
+
+/**
+ * Pushes a move onto the top of a stack.
+ *
+ * A new chunk is taken only when the top one is full.
+ * @param stack This is the stack that receives the move.
+ * @param move This is the move to push. It can't be F.
+ */
+void MoveStackArena::push(MoveStack &stack, MOVES move) {
+    if(stack.top_chunk < 0 || stack.top_size == CHUNK_MOVES) {
+        int32_t id = stack.spare_chunk >= 0 ? stack.spare_chunk : this->allocate();
+        stack.spare_chunk = -1;
+        this->chunk(id).previous = stack.top_chunk;
+        stack.top_chunk = id;
+        stack.top_size = 0;
+    }
+
+    // Moves are stored as 2-bit codes, N = 0, E = 1, S = 2 and W = 3
+    uint8_t &byte = this->chunk(stack.top_chunk).codes[stack.top_size >> 2];
+    int shift = static_cast<int>(stack.top_size & 3) << 1;
+    byte = static_cast<uint8_t>((byte & ~(0x3 << shift)) | (move - 1) << shift);
+    stack.top_size++;
+    stack.length++;
+}
+
+
+/**
+ * Removes the move located onto the top of a stack.
+ *
+ * When the top chunk gets empty it is kept aside as the stack's spare chunk.
+ * @param stack This is the stack to pop. It must not be empty.
+ * @return the removed move.
+ */
+MOVES MoveStackArena::pop(MoveStack &stack) {
+    if(stack.top_size == 0) {
+        stack.spare_chunk = stack.top_chunk;
+        stack.top_chunk = this->chunk(stack.top_chunk).previous;
+        stack.top_size = CHUNK_MOVES;
+    }
+
+    stack.top_size--;
+    stack.length--;
+    return this->read(stack.top_chunk, stack.top_size);
+}
+
+
+/**
+ * Reads the move located onto the top of a stack without removing it.
+ *
+ * @param stack This is the stack to read. It must not be empty.
+ * @return the move onto the top of the stack.
+ */
+MOVES MoveStackArena::top(const MoveStack &stack) const {
+    if(stack.top_size == 0)
+        return this->read(this->chunk(stack.top_chunk).previous, CHUNK_MOVES - 1);
+    return this->read(stack.top_chunk, stack.top_size - 1);
+}
+
+
+/**
+ * Removes all the moves of a stack.
+ *
+ * The top chunk is kept for the next moves, while the other ones are left to the arena until it is reset.
+ * @param stack This is the stack to clear.
+ */
+void MoveStackArena::clear(MoveStack &stack) {
+    if(stack.top_chunk >= 0)
+        this->chunk(stack.top_chunk).previous = -1;
+    stack.top_size = 0;
+    stack.length = 0;
+}
+
+
+/**
+ * Decodes all the moves of a stack.
+ *
+ * @param stack This is the stack to decode.
+ * @return the moves, from the bottom to the top of the stack.
+ */
+std::vector<MOVES> MoveStackArena::moves(const MoveStack &stack) const {
+    std::vector<MOVES> moves;
+    this->moves(stack, moves);
+    return moves;
+}
+
+
+/**
+ * Decodes all the moves of a stack into an existing vector, whose memory is reused.
+ *
+ * @param stack This is the stack to decode.
+ * @param moves This vector receives the moves, from the bottom to the top of the stack.
+ */
+void MoveStackArena::moves(const MoveStack &stack, std::vector<MOVES> &moves) const {
+    moves.clear();
+    moves.reserve(stack.length);
+
+    int32_t id = stack.top_chunk;
+    uint32_t size = stack.top_size;
+    while(moves.size() < stack.length) {
+        for(uint32_t slot = size; slot > 0; slot--)
+            moves.push_back(this->read(id, slot - 1));
+        id = this->chunk(id).previous;
+        size = CHUNK_MOVES;
+    }
+
+    std::reverse(moves.begin(), moves.end());
+}
+
+
+/**
+ * Computes the memory reserved by the arena's blocks.
+ *
+ * @return the number of bytes.
+ */
+size_t MoveStackArena::bytes() const {
+    size_t bytes = 0;
+    for(int block = 0; block < MAX_BLOCKS && this->blocks[block]; block++)
+        bytes += (static_cast<size_t>(FIRST_BLOCK_CHUNKS) << block) * sizeof(Chunk);
+    return bytes;
+}
+
+
+/**
+ * Takes a new chunk from the arena, allocating a new block if needed.
+ *
+ * The threads synchronize only here, which happens once every CHUNK_MOVES pushes at most.
+ * @return the identifier of the chunk.
+ */
+int32_t MoveStackArena::allocate() {
+    int32_t id;
+    #pragma omp critical(move_stack_arena)
+    {
+        id = this->n_chunks++;
+        int block = std::bit_width(static_cast<uint32_t>(id / FIRST_BLOCK_CHUNKS + 1)) - 1;
+        if(!this->blocks[block])
+            this->blocks[block] = std::make_unique<Chunk[]>(static_cast<size_t>(FIRST_BLOCK_CHUNKS) << block);
+    }
+    return id;
+}
+
+
+/**
+ * Locates a chunk.
+ *
+ * Block b holds FIRST_BLOCK_CHUNKS * 2^b chunks, starting from the identifier FIRST_BLOCK_CHUNKS * (2^b - 1).
+ * @param id This is the identifier of the chunk.
+ * @return the chunk.
+ */
+MoveStackArena::Chunk &MoveStackArena::chunk(int32_t id) {
+    uint32_t blocks_offset = static_cast<uint32_t>(id) / FIRST_BLOCK_CHUNKS + 1;
+    int block = std::bit_width(blocks_offset) - 1;
+    return this->blocks[block][id - FIRST_BLOCK_CHUNKS * ((1 << block) - 1)];
+}
+
+const MoveStackArena::Chunk &MoveStackArena::chunk(int32_t id) const {
+    return const_cast<MoveStackArena *>(this)->chunk(id);
+}
+
+
+/**
+ * Reads a single move from a chunk.
+ *
+ * @param id This is the identifier of the chunk.
+ * @param slot This is the position of the move inside the chunk.
+ * @return the move.
+ */
+MOVES MoveStackArena::read(int32_t id, uint32_t slot) const {
+    uint8_t code = (this->chunk(id).codes[slot >> 2] >> ((slot & 3) << 1)) & 0x3;
+    return static_cast<MOVES>(code + 1);
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#ifndef RANDOMMAZESOLVER_MOVE_STACK_H
+#define RANDOMMAZESOLVER_MOVE_STACK_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "move_table.h"
+
+// ENUMS AND STRUCTS
+
+/// Stack of moves stored inside a MoveStackArena. It just keeps track of its top chunk.
+struct MoveStack {
+    int32_t top_chunk = -1;
+    // An empty chunk kept aside, so that a particle moving back and forth across a chunk's boundary never allocates
+    int32_t spare_chunk = -1;
+    uint32_t top_size = 0;
+    uint32_t length = 0;
+
+    [[nodiscard]] bool empty() const { return this->length == 0; }
+};
+
+
+/**
+ * Pool of memory shared by many stacks of moves.
+ *
+ * Each move takes just 2 bits. The moves are stored into fixed size chunks, and every stack is a list of chunks that
+ * goes from its top to its bottom. The chunks are allocated from blocks that double in size as the arena grows, so
+ * the existing chunks never move and many threads can push onto their own stacks at the same time.
+ * Resetting the arena forgets all the stacks but keeps the blocks, so that the next executions don't allocate.
+ */
+class MoveStackArena {
+public:
+    /// Moves held by each chunk.
+    static constexpr uint32_t CHUNK_MOVES = 240;
+
+    void reset() { this->n_chunks = 0; }
+
+    void push(MoveStack &stack, MOVES move);
+    MOVES pop(MoveStack &stack);
+    [[nodiscard]] MOVES top(const MoveStack &stack) const;
+    void clear(MoveStack &stack);
+    [[nodiscard]] std::vector<MOVES> moves(const MoveStack &stack) const;
+    void moves(const MoveStack &stack, std::vector<MOVES> &moves) const;
+
+    /// Memory reserved by the arena.
+    [[nodiscard]] size_t bytes() const;
+
+private:
+    struct Chunk {
+        int32_t previous;
+        std::array<uint8_t, CHUNK_MOVES / 4> codes;
+    };
+
+    static constexpr int32_t FIRST_BLOCK_CHUNKS = 1024;
+    static constexpr int MAX_BLOCKS = 21;
+
+    int32_t allocate();
+    [[nodiscard]] Chunk &chunk(int32_t id);
+    [[nodiscard]] const Chunk &chunk(int32_t id) const;
+    [[nodiscard]] MOVES read(int32_t id, uint32_t slot) const;
+
+    int32_t n_chunks = 0;
+    std::array<std::unique_ptr<Chunk[]>, MAX_BLOCKS> blocks;
+};
+
+#endif //RANDOMMAZESOLVER_MOVE_STACK_H
@@ -0,0 +1,38 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#include "move_table.h"
+
+
+// FUNCTIONS
+
+/**
+ * Computes the available moves of every cell of the maze.
+ *
+ * A direction is open if the cell nearby is not a wall. Walls and the sentinel border have no moves at all.
+ * The exit's cell is marked as well, so that the particles can detect it from the table alone.
+ * @param maze This is the grid that contains the maze's inner structure.
+ */
+void MoveTable::build(const Maze &maze) {
+    int size = maze.size();
+    this->row_stride = maze.stride();
+    this->cells.assign(static_cast<size_t>(this->row_stride) * static_cast<size_t>(this->row_stride), 0);
+
+    for(int row = 0; row < size; row++) {
+        for(int col = 0; col < size; col++) {
+            int index = maze.index(row, col);
+            if(maze[index] == MAZE_PATH::WALL)
+                continue;
+
+            uint8_t open_directions = 0;
+            if(maze[index - this->row_stride] != MAZE_PATH::WALL)
+                open_directions |= OPEN_DIRECTION::OPEN_N;
+            if(maze[index + 1] != MAZE_PATH::WALL)
+                open_directions |= OPEN_DIRECTION::OPEN_E;
+            if(maze[index + this->row_stride] != MAZE_PATH::WALL)
+                open_directions |= OPEN_DIRECTION::OPEN_S;
+            if(maze[index - 1] != MAZE_PATH::WALL)
+                open_directions |= OPEN_DIRECTION::OPEN_W;
+            this->cells[index] = encode_moves(open_directions, maze[index] == MAZE_PATH::EXIT);
+        }
+    }
+}
@@ -0,0 +1,106 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#ifndef RANDOMMAZESOLVER_MOVE_TABLE_H
+#define RANDOMMAZESOLVER_MOVE_TABLE_H
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+#include "maze.h"
+#include "packed_maze.h"
+
+// ENUMS AND STRUCTS
+
+/// Supported movements system for particles' shifting.
+enum MOVES : uint8_t {
+    F = 0, // Used just for particles' initializations (frozen)
+    N = 1,
+    E = 2,
+    S = 3,
+    W = 4,
+};
+
+
+/// OPEN_DIRECTION bit that corresponds to each move, indexed by the MOVES value.
+inline constexpr std::array<uint8_t, 5> MOVE_BIT = {0, OPEN_DIRECTION::OPEN_N, OPEN_DIRECTION::OPEN_E,
+                                                    OPEN_DIRECTION::OPEN_S, OPEN_DIRECTION::OPEN_W};
+
+
+/// Move that goes back to the previous cell, indexed by the MOVES value.
+inline constexpr std::array<MOVES, 5> MOVE_OPPOSITE = {MOVES::F, MOVES::S, MOVES::W, MOVES::N, MOVES::E};
+
+
+/// Rows and columns crossed by each move, indexed by the MOVES value.
+inline constexpr std::array<int, 5> MOVE_ROW_DELTA = {0, -1, 0, 1, 0};
+inline constexpr std::array<int, 5> MOVE_COL_DELTA = {0, 0, 1, 0, -1};
+
+
+/**
+ * Lists the moves allowed by each mask of open directions.
+ *
+ * The moves are always listed in the N, S, W, E order, so that the same random value selects the same move no matter
+ * which maze's representation the mask comes from. Unused slots are left to F.
+ */
+inline constexpr std::array<std::array<MOVES, 4>, 16> MOVES_DECODE = [] {
+    std::array<std::array<MOVES, 4>, 16> decode{};
+    for(int mask = 0; mask < 16; mask++) {
+        int n_moves = 0;
+        for(MOVES move : {MOVES::N, MOVES::S, MOVES::W, MOVES::E})
+            if(mask & MOVE_BIT[move])
+                decode[mask][n_moves++] = move;
+    }
+    return decode;
+}();
+
+
+/// Bit of an encoded cell that marks the maze's exit.
+inline constexpr uint8_t MOVES_EXIT = 0x80;
+
+
+/**
+ * Encodes the moves of a cell into a single byte.
+ *
+ * The lower nibble holds the mask of the open directions, the next 3 bits the number of available moves and the
+ * highest bit tells if the cell is the maze's exit (MOVES_EXIT).
+ * @param open_directions This is the mask of the open directions as OPEN_DIRECTION bits.
+ * @param exit Flag used to mark the cell as the maze's exit.
+ * @return the encoded cell.
+ */
+constexpr uint8_t encode_moves(uint8_t open_directions, bool exit=false) {
+    return static_cast<uint8_t>(open_directions | std::popcount(open_directions) << 4 | (exit ? MOVES_EXIT : 0));
+}
+
+constexpr uint8_t moves_mask(uint8_t moves_cell) { return moves_cell & 0xF; }
+constexpr int moves_count(uint8_t moves_cell) { return (moves_cell >> 4) & 0x7; }
+constexpr bool moves_exit(uint8_t moves_cell) { return moves_cell & MOVES_EXIT; }
+
+
+/**
+ * Table of the moves available onto each cell of a MAZE_PATH grid.
+ *
+ * It is built once after the generation, so that the particles never need to look at the cells nearby: each step
+ * becomes a single lookup followed by the MOVES_DECODE table. The cells are stored with the same layout and
+ * sentinel border as the grid, so they are addressed by the same coordinates and flat indexes.
+ */
+class MoveTable {
+public:
+    MoveTable() = default;
+    explicit MoveTable(const Maze &maze) { this->build(maze); }
+
+    void build(const Maze &maze);
+
+    uint8_t operator()(int row, int col) const { return this->cells[(row + 1) * this->row_stride + col + 1]; }
+    uint8_t operator[](int index) const { return this->cells[index]; }
+
+    /// Distance between two vertically adjacent cells in the table, as in the grid.
+    [[nodiscard]] int stride() const { return this->row_stride; }
+    [[nodiscard]] const uint8_t *data() const { return this->cells.data(); }
+
+private:
+    int row_stride = 0;
+    std::vector<uint8_t> cells;
+};
+
+#endif //RANDOMMAZESOLVER_MOVE_TABLE_H
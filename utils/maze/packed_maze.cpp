@@ -0,0 +1,197 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#include "packed_maze.h"
+
+
+// FUNCTIONS
+
+/**
+ * Resizes the structure in order to hold a maze with the given side's length.
+ *
+ * All the nodes are closed, as if every wall of the maze was still in place.
+ * @param size Represents the length of each maze's side, as in the MAZE_PATH grid. It must be odd.
+ */
+void PackedMaze::resize(int size) {
+    this->side = size;
+    this->n_nodes_side = (size - 1) / 2;
+    size_t n_nodes = static_cast<size_t>(this->n_nodes_side) * static_cast<size_t>(this->n_nodes_side);
+    this->storage.assign((n_nodes + 1) / 2, 0);
+    this->nibbles = this->storage.data();
+    this->n_bytes = this->storage.size();
+}
+
+
+/**
+ * Uses an external buffer as the nodes' masks, without copying it.
+ *
+ * The buffer must outlive the structure, and it must hold the masks of a maze with the given side's length.
+ * @param size Represents the length of each maze's side, as in the MAZE_PATH grid. It must be odd.
+ * @param data This is the buffer that holds the masks, packed two per byte.
+ */
+void PackedMaze::attach(int size, uint8_t *data) {
+    this->side = size;
+    this->n_nodes_side = (size - 1) / 2;
+    size_t n_nodes = static_cast<size_t>(this->n_nodes_side) * static_cast<size_t>(this->n_nodes_side);
+    this->storage.clear();
+    this->storage.shrink_to_fit();
+    this->nibbles = data;
+    this->n_bytes = (n_nodes + 1) / 2;
+}
+
+
+/**
+ * Removes the wall located on the given side of a node.
+ *
+ * The opposite direction is opened onto the nearby node too, so that the 2 masks are always consistent.
+ * If there is no node on that side, the wall belongs to the maze's border and the opening becomes the exit.
+ * @param node_row This is the row of the node in the nodes' grid.
+ * @param node_col This is the column of the node in the nodes' grid.
+ * @param direction This is the side of the node to open.
+ */
+void PackedMaze::connect(int node_row, int node_col, OPEN_DIRECTION direction) {
+    int near_row = node_row;
+    int near_col = node_col;
+    OPEN_DIRECTION opposite;
+    switch (direction) {
+        case OPEN_DIRECTION::OPEN_N:
+            near_row -= 1;
+            opposite = OPEN_DIRECTION::OPEN_S;
+            break;
+        case OPEN_DIRECTION::OPEN_S:
+            near_row += 1;
+            opposite = OPEN_DIRECTION::OPEN_N;
+            break;
+        case OPEN_DIRECTION::OPEN_E:
+            near_col += 1;
+            opposite = OPEN_DIRECTION::OPEN_W;
+            break;
+        default:
+            near_col -= 1;
+            opposite = OPEN_DIRECTION::OPEN_E;
+    }
+
+    this->open(node_row * this->n_nodes_side + node_col, direction);
+    if(near_row >= 0 && near_row < this->n_nodes_side && near_col >= 0 && near_col < this->n_nodes_side)
+        this->open(near_row * this->n_nodes_side + near_col, opposite);
+}
+
+
+/**
+ * Stores the masks of a whole row of nodes.
+ *
+ * This allows the structure to be used as the sink of a streamed generation.
+ * @param node_row This is the row of the nodes in the nodes' grid.
+ * @param open_masks These are the nodes' masks of open directions, from the first column to the last one.
+ */
+void PackedMaze::store_row(int node_row, const std::vector<uint8_t> &open_masks) {
+    int first_node = node_row * this->n_nodes_side;
+    for(int node_col = 0; node_col < this->n_nodes_side; node_col++)
+        this->open(first_node + node_col, open_masks[node_col]);
+}
+
+
+/**
+ * Decodes the content of a cell of the MAZE_PATH grid.
+ *
+ * Nodes are always walkable, cells with both even coordinates are always walls, while the cells in between 2 nodes
+ * are walkable only if the nodes are connected. Border cells are walls unless they correspond to the exit.
+ * @param row This is the row of the cell in the grid.
+ * @param col This is the column of the cell in the grid.
+ * @return the value that the cell would have in the MAZE_PATH grid.
+ */
+MAZE_PATH PackedMaze::cell(int row, int col) const {
+    bool odd_row = row % 2 == 1;
+    bool odd_col = col % 2 == 1;
+
+    if(odd_row && odd_col)
+        return MAZE_PATH::EMPTY;
+
+    // Cell in between 2 nodes located onto the same row
+    if(odd_row) {
+        int node_row = row / 2;
+        if(col == 0)
+            return this->open_mask(node_row * this->n_nodes_side) & OPEN_DIRECTION::OPEN_W ? MAZE_PATH::EXIT : MAZE_PATH::WALL;
+        int west_node = node_row * this->n_nodes_side + col / 2 - 1;
+        if(this->open_mask(west_node) & OPEN_DIRECTION::OPEN_E)
+            return col == this->side - 1 ? MAZE_PATH::EXIT : MAZE_PATH::EMPTY;
+        return MAZE_PATH::WALL;
+    }
+
+    // Cell in between 2 nodes located onto the same column
+    if(odd_col) {
+        int node_col = col / 2;
+        if(row == 0)
+            return this->open_mask(node_col) & OPEN_DIRECTION::OPEN_N ? MAZE_PATH::EXIT : MAZE_PATH::WALL;
+        int north_node = (row / 2 - 1) * this->n_nodes_side + node_col;
+        if(this->open_mask(north_node) & OPEN_DIRECTION::OPEN_S)
+            return row == this->side - 1 ? MAZE_PATH::EXIT : MAZE_PATH::EMPTY;
+        return MAZE_PATH::WALL;
+    }
+
+    return MAZE_PATH::WALL;
+}
+
+
+/**
+ * Retrieves the directions in which a particle located onto a walkable cell can move.
+ *
+ * For nodes this is their open directions mask. A walkable cell in between 2 nodes can only lead to them, unless it
+ * is the exit, which has a single node nearby.
+ * @param row This is the row of the cell in the grid.
+ * @param col This is the column of the cell in the grid.
+ * @return the mask of the open directions as OPEN_DIRECTION bits.
+ */
+uint8_t PackedMaze::moves(int row, int col) const {
+    bool odd_row = row % 2 == 1;
+    bool odd_col = col % 2 == 1;
+
+    if(odd_row && odd_col)
+        return this->open_mask((row / 2) * this->n_nodes_side + col / 2);
+    if(odd_row)
+        return (col > 0 ? OPEN_DIRECTION::OPEN_W : 0) | (col < this->side - 1 ? OPEN_DIRECTION::OPEN_E : 0);
+    if(odd_col)
+        return (row > 0 ? OPEN_DIRECTION::OPEN_N : 0) | (row < this->side - 1 ? OPEN_DIRECTION::OPEN_S : 0);
+    return 0;
+}
+
+
+/**
+ * Expands the packed maze into the MAZE_PATH grid.
+ *
+ * This is mostly used for rendering purposes, as the grid takes a lot more memory.
+ * @param maze This is the grid that will contain the maze's inner structure.
+ */
+void PackedMaze::to_maze(Maze &maze) const {
+    maze.resize(this->side);
+    for(int row = 0; row < this->side; row++)
+        for(int col = 0; col < this->side; col++)
+            maze(row, col) = this->cell(row, col);
+}
+
+
+/**
+ * Packs the structure of a MAZE_PATH grid.
+ *
+ * Any cell that is not a wall is considered walkable, so grids that already contain a solution can be packed too.
+ * @param maze This is the grid that contains the maze's inner structure.
+ */
+void PackedMaze::from_maze(const Maze &maze) {
+    this->resize(maze.size());
+    for(int node_row = 0; node_row < this->n_nodes_side; node_row++) {
+        for(int node_col = 0; node_col < this->n_nodes_side; node_col++) {
+            int row = 2 * node_row + 1;
+            int col = 2 * node_col + 1;
+            uint8_t mask = 0;
+            if(maze(row - 1, col) != MAZE_PATH::WALL)
+                mask |= OPEN_DIRECTION::OPEN_N;
+            if(maze(row, col + 1) != MAZE_PATH::WALL)
+                mask |= OPEN_DIRECTION::OPEN_E;
+            if(maze(row + 1, col) != MAZE_PATH::WALL)
+                mask |= OPEN_DIRECTION::OPEN_S;
+            if(maze(row, col - 1) != MAZE_PATH::WALL)
+                mask |= OPEN_DIRECTION::OPEN_W;
+            this->open(node_row * this->n_nodes_side + node_col, mask);
+        }
+    }
+}
+
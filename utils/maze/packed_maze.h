@@ -0,0 +1,80 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#ifndef RANDOMMAZESOLVER_PACKED_MAZE_H
+#define RANDOMMAZESOLVER_PACKED_MAZE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "maze.h"
+
+// ENUMS AND STRUCTS
+
+/// Bits of the mask that tells in which directions a node of the packed maze is open.
+enum OPEN_DIRECTION : uint8_t {
+    OPEN_N = 0x1,
+    OPEN_E = 0x2,
+    OPEN_S = 0x4,
+    OPEN_W = 0x8,
+};
+
+
+/// Receives the open directions' masks of a finished row of nodes, one byte per node, as soon as it is generated.
+using NodeRowSink = std::function<void(int node_row, const std::vector<uint8_t> &open_masks)>;
+
+
+/**
+ * Compact representation of a square maze that stores only its logical cells (nodes).
+ *
+ * A maze of the given size has ((size - 1) / 2)^2 nodes, located at the odd coordinates of the MAZE_PATH grid. The
+ * cells in between them are either walls or corridors, so each node just keeps a 4-bit mask of its open directions.
+ * Two nodes are packed into each byte, the one with the even index into the lower nibble.
+ * The exit is stored as an open direction of a border node that points outside the maze.
+ * Cells are still addressed by the grid's (row, col) coordinates, so the solver can run directly onto this structure.
+ * The masks are either owned by the structure or attached from an external buffer, like a mapped maze file.
+ */
+class PackedMaze {
+public:
+    PackedMaze() = default;
+    explicit PackedMaze(int size) { this->resize(size); }
+    // The masks might point to the owned buffer, so a copy would share it
+    PackedMaze(const PackedMaze &) = delete;
+    PackedMaze &operator=(const PackedMaze &) = delete;
+
+    void resize(int size);
+    void attach(int size, uint8_t *data);
+
+    /// Length of each maze's side, as in the MAZE_PATH grid.
+    [[nodiscard]] int size() const { return this->side; }
+    /// Number of nodes on each maze's side.
+    [[nodiscard]] int nodes_side() const { return this->n_nodes_side; }
+    /// Memory used by the nodes' masks.
+    [[nodiscard]] size_t bytes() const { return this->n_bytes; }
+    [[nodiscard]] const uint8_t *data() const { return this->nibbles; }
+
+    [[nodiscard]] uint8_t open_mask(int node) const {
+        return (this->nibbles[node >> 1] >> ((node & 1) << 2)) & 0xF;
+    }
+    void open(int node, uint8_t directions) {
+        this->nibbles[node >> 1] |= static_cast<uint8_t>(directions << ((node & 1) << 2));
+    }
+
+    void connect(int node_row, int node_col, OPEN_DIRECTION direction);
+    void store_row(int node_row, const std::vector<uint8_t> &open_masks);
+    [[nodiscard]] MAZE_PATH cell(int row, int col) const;
+    [[nodiscard]] uint8_t moves(int row, int col) const;
+
+    void to_maze(Maze &maze) const;
+    void from_maze(const Maze &maze);
+
+private:
+    int side = 0;
+    int n_nodes_side = 0;
+    std::vector<uint8_t> storage;
+    uint8_t *nibbles = nullptr;
+    size_t n_bytes = 0;
+};
+
+#endif //RANDOMMAZESOLVER_PACKED_MAZE_H
@@ -0,0 +1,30 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#include <algorithm>
+#include <bit>
+
+#include "path_index.h"
+
+
+// FUNCTIONS
+
+/**
+ * Indexes the cells of a path.
+ *
+ * The table keeps at least twice the slots of the path's cells, so that the probe sequences stay short.
+ * @param path These are the coordinates of the path's cells, from its first cell to its last one.
+ */
+void PathIndex::build(const std::vector<Coordinates> &path) {
+    size_t n_slots = std::bit_ceil(std::max<size_t>(2 * path.size(), 16));
+    this->entries.assign(n_slots, Entry {EMPTY_KEY, -1});
+    this->mask = n_slots - 1;
+    this->shift = 64 - std::countr_zero(n_slots);
+
+    for(size_t position = 0; position < path.size(); position++) {
+        uint64_t key = PathIndex::key(path[position]);
+        size_t slot = this->slot(key);
+        while(this->entries[slot].key != EMPTY_KEY)
+            slot = (slot + 1) & this->mask;
+        this->entries[slot] = Entry {key, static_cast<int>(position)};
+    }
+}
@@ -0,0 +1,66 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#ifndef RANDOMMAZESOLVER_PATH_INDEX_H
+#define RANDOMMAZESOLVER_PATH_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "coordinates.h"
+
+// ENUMS AND STRUCTS
+
+/**
+ * Maps the cells of a path to their positions onto it.
+ *
+ * The cells are stored into an open addressing hash table, sized to the path instead of to the maze, so its memory
+ * doesn't grow with the maze's size and most lookups take a single probe. Each cell must appear at most once onto the
+ * path, as it happens for the particles' paths, which drop the moves that are undone.
+ * The table's memory is reused by the next paths, as long as they are not longer.
+ */
+class PathIndex {
+public:
+    void build(const std::vector<Coordinates> &path);
+
+    /**
+     * Retrieves the position of a cell onto the path.
+     *
+     * @param coords These are the coordinates of the cell.
+     * @return the index of the cell onto the path, -1 if the cell is not part of it.
+     */
+    [[nodiscard]] int find(Coordinates coords) const {
+        uint64_t key = PathIndex::key(coords);
+        for(size_t slot = this->slot(key); ; slot = (slot + 1) & this->mask) {
+            const Entry &entry = this->entries[slot];
+            if(entry.key == key)
+                return entry.position;
+            if(entry.key == EMPTY_KEY)
+                return -1;
+        }
+    }
+
+    /// Memory used by the table.
+    [[nodiscard]] size_t bytes() const { return this->entries.capacity() * sizeof(Entry); }
+
+private:
+    struct Entry {
+        uint64_t key;
+        int position;
+    };
+
+    // Key of the (-1, -1) coordinates, which are never part of a path
+    static constexpr uint64_t EMPTY_KEY = UINT64_MAX;
+
+    static uint64_t key(Coordinates coords) {
+        return static_cast<uint64_t>(static_cast<uint32_t>(coords.row)) << 32 | static_cast<uint32_t>(coords.col);
+    }
+    /// Fibonacci hashing: the highest bits of the product select the slot.
+    [[nodiscard]] size_t slot(uint64_t key) const { return static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> this->shift); }
+
+    std::vector<Entry> entries;
+    size_t mask = 0;
+    int shift = 64;
+};
+
+#endif //RANDOMMAZESOLVER_PATH_INDEX_H
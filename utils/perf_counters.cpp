@@ -0,0 +1,189 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#include <algorithm>
+#include <omp.h>
+#include <utility>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "perf_counters.h"
+
+
+// PROTOTYPES
+int open_perf_counter(PERF_COUNTER counter, int thread_id);
+int64_t read_perf_counter(int descriptor);
+
+
+// GLOBAL VARIABLES
+// Threads of the OpenMP's team, recorded once before the executions and only read afterwards
+std::vector<int> counted_thread_ids;
+
+
+// FUNCTIONS
+
+/**
+ * Records the threads whose events are counted, by starting the OpenMP's team.
+ *
+ * Each thread of the team stores its own id, the calling one included. The team's threads never exit and they are
+ * reused by the phases' parallel regions, while the other threads of the process, as the results writer's one, are
+ * never counted. It must be called before the first execution, outside of any parallel region.
+ */
+void record_perf_threads() {
+    std::vector<int> thread_ids(omp_get_max_threads(), 0);
+    #pragma omp parallel
+    {
+#ifdef __linux__
+        thread_ids[omp_get_thread_num()] = static_cast<int>(syscall(SYS_gettid));
+#endif
+    }
+
+    // The team can be smaller than requested
+    thread_ids.erase(std::remove(thread_ids.begin(), thread_ids.end(), 0), thread_ids.end());
+    std::sort(thread_ids.begin(), thread_ids.end());
+    thread_ids.erase(std::unique(thread_ids.begin(), thread_ids.end()), thread_ids.end());
+    counted_thread_ids = thread_ids;
+}
+
+
+/**
+ * Opens the counters of the recorded OpenMP's threads, or of the calling thread only if none has been recorded.
+ *
+ * @param counters These are the counters of the current execution, that receive the samples.
+ * @param phase This is the name of the phase that is being counted.
+ */
+PerfScope::PerfScope(PhaseCounters &counters, std::string phase) : counters(counters), phase(std::move(phase)) {
+    if(!this->counters.enabled || !perf_counters_supported())
+        return;
+
+    std::vector<int> thread_ids = counted_thread_ids;
+#ifdef __linux__
+    if(thread_ids.empty())
+        thread_ids.push_back(static_cast<int>(syscall(SYS_gettid)));
+#endif
+    for(int thread_id : thread_ids) {
+        ThreadCounters thread {thread_id, {}};
+        for(int counter = 0; counter < N_PERF_COUNTERS; counter++)
+            thread.descriptors[counter] = open_perf_counter(static_cast<PERF_COUNTER>(counter), thread.thread_id);
+        this->threads.push_back(thread);
+    }
+}
+
+
+/**
+ * Reads and closes the counters, and stores the samples of the threads that have been running.
+ */
+PerfScope::~PerfScope() {
+    for(ThreadCounters &thread : this->threads) {
+        PerfSample sample {this->phase, thread.thread_id, {}};
+        for(int counter = 0; counter < N_PERF_COUNTERS; counter++)
+            sample.values[counter] = read_perf_counter(thread.descriptors[counter]);
+
+        // The threads that slept during the whole phase are left out
+        if(std::any_of(sample.values.begin(), sample.values.end(), [](int64_t value) { return value > 0; }))
+            this->counters.samples.push_back(sample);
+    }
+}
+
+
+/**
+ * Checks if the events can be counted at all, by opening a software counter onto the calling thread.
+ *
+ * The check is done once. The hardware events can still be missing, as it happens onto most virtual machines.
+ * @return true if perf_event_open can be used by this process.
+ */
+bool perf_counters_supported() {
+    static const bool supported = [] {
+        int descriptor = open_perf_counter(PERF_COUNTER::CONTEXT_SWITCHES, 0);
+        read_perf_counter(descriptor);
+        return descriptor >= 0;
+    }();
+    return supported;
+}
+
+
+/**
+ * Gives the name of an event, as it is written into the counters' report.
+ *
+ * @param counter This is the event.
+ * @return the name of the event.
+ */
+const char *perf_counter_name(PERF_COUNTER counter) {
+    switch(counter) {
+        case PERF_COUNTER::CYCLES: return "cycles";
+        case PERF_COUNTER::INSTRUCTIONS: return "instructions";
+        case PERF_COUNTER::CACHE_MISSES: return "cache_misses";
+        case PERF_COUNTER::BRANCH_MISSES: return "branch_misses";
+        case PERF_COUNTER::CONTEXT_SWITCHES: return "context_switches";
+    }
+    return "unknown";
+}
+
+
+/**
+ * Starts counting an event onto a thread.
+ *
+ * The kernel's events are counted too, if the perf_event_paranoid's level allows it. The threads spawned later by
+ * the counted one are not counted: inherited counters are added to the parent's one only when the child thread exits,
+ * while the OpenMP's threads never do.
+ * @param counter This is the event to count.
+ * @param thread_id This is the thread to count, 0 for the calling one.
+ * @return the counter's file descriptor, -1 if the event can't be counted.
+ */
+int open_perf_counter(PERF_COUNTER counter, int thread_id) {
+#ifdef __linux__
+    perf_event_attr attributes {};
+    attributes.size = sizeof(attributes);
+    attributes.type = counter == PERF_COUNTER::CONTEXT_SWITCHES ? PERF_TYPE_SOFTWARE : PERF_TYPE_HARDWARE;
+    switch(counter) {
+        case PERF_COUNTER::CYCLES: attributes.config = PERF_COUNT_HW_CPU_CYCLES; break;
+        case PERF_COUNTER::INSTRUCTIONS: attributes.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+        case PERF_COUNTER::CACHE_MISSES: attributes.config = PERF_COUNT_HW_CACHE_MISSES; break;
+        case PERF_COUNTER::BRANCH_MISSES: attributes.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+        case PERF_COUNTER::CONTEXT_SWITCHES: attributes.config = PERF_COUNT_SW_CONTEXT_SWITCHES; break;
+    }
+    // The counters are multiplexed when there are more events than hardware counters, so the times are needed in
+    // order to scale the values
+    attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attributes.exclude_hv = 1;
+
+    long descriptor = syscall(SYS_perf_event_open, &attributes, thread_id, -1, -1, PERF_FLAG_FD_CLOEXEC);
+    if(descriptor < 0) {
+        attributes.exclude_kernel = 1;
+        descriptor = syscall(SYS_perf_event_open, &attributes, thread_id, -1, -1, PERF_FLAG_FD_CLOEXEC);
+    }
+    return static_cast<int>(descriptor);
+#else
+    return -1;
+#endif
+}
+
+
+/**
+ * Reads the value of a counter and closes it.
+ *
+ * @param descriptor This is the counter's file descriptor.
+ * @return the value scaled by the time during which the event has been counted, -1 if there is no counter.
+ */
+int64_t read_perf_counter(int descriptor) {
+#ifdef __linux__
+    if(descriptor < 0)
+        return -1;
+
+    // Value, time enabled and time running
+    uint64_t values[3] = {0, 0, 0};
+    bool read_all = read(descriptor, values, sizeof(values)) == sizeof(values);
+    close(descriptor);
+    if(!read_all)
+        return -1;
+
+    if(values[2] > 0 && values[2] < values[1])
+        values[0] = static_cast<uint64_t>(static_cast<double>(values[0]) * values[1] / values[2]);
+    return static_cast<int64_t>(values[0]);
+#else
+    return -1;
+#endif
+}
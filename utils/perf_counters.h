@@ -0,0 +1,71 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#ifndef RANDOMMAZESOLVER_PERF_COUNTERS_H
+#define RANDOMMAZESOLVER_PERF_COUNTERS_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ENUMS AND STRUCTS
+
+/// Events counted for each phase and thread.
+enum PERF_COUNTER {
+    CYCLES = 0,
+    INSTRUCTIONS = 1,
+    CACHE_MISSES = 2,
+    BRANCH_MISSES = 3,
+    CONTEXT_SWITCHES = 4,
+};
+
+constexpr int N_PERF_COUNTERS = 5;
+
+
+/// Values counted by a single thread during a phase, -1 for the events that can't be counted on this host.
+struct PerfSample {
+    std::string phase;
+    int thread_id;
+    std::array<int64_t, N_PERF_COUNTERS> values;
+};
+
+
+/// Counters collected by an execution, if it has been asked to.
+struct PhaseCounters {
+    bool enabled = false;
+    std::vector<PerfSample> samples;
+};
+
+
+/**
+ * Counts the events of the OpenMP's threads while it is alive, by using perf_event_open.
+ *
+ * The counters are opened only for the threads recorded by record_perf_threads, so the other threads of the process,
+ * as the results writer's one, are left out. When the scope ends, a sample is added for each thread that has counted
+ * anything.
+ * When the perf_event_paranoid's level doesn't allow to count the kernel, only the user space is counted. Nothing is
+ * counted when the counters are not enabled or not supported.
+ */
+class PerfScope {
+public:
+    PerfScope(PhaseCounters &counters, std::string phase);
+    ~PerfScope();
+    PerfScope(const PerfScope &) = delete;
+    PerfScope &operator=(const PerfScope &) = delete;
+
+private:
+    struct ThreadCounters {
+        int thread_id;
+        std::array<int, N_PERF_COUNTERS> descriptors;
+    };
+
+    PhaseCounters &counters;
+    std::string phase;
+    std::vector<ThreadCounters> threads;
+};
+
+void record_perf_threads();
+bool perf_counters_supported();
+const char *perf_counter_name(PERF_COUNTER counter);
+
+#endif //RANDOMMAZESOLVER_PERF_COUNTERS_H
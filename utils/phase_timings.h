@@ -0,0 +1,40 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#ifndef RANDOMMAZESOLVER_PHASE_TIMINGS_H
+#define RANDOMMAZESOLVER_PHASE_TIMINGS_H
+
+#include <chrono>
+
+// ENUMS AND STRUCTS
+
+/**
+ * Milliseconds spent by an execution into each one of its phases.
+ *
+ * The phases are measured with a steady clock, so they are not affected by the changes of the system's time.
+ * The mazes printed while the steps are shown are counted as display time, except for the generation's ones.
+ */
+struct PhaseTimings {
+    float generation = 0;
+    // Spawning the particles and building the structures used to move them
+    float setup = 0;
+    float random_walk = 0;
+    // Extracting the exited particle's path and marking it onto the maze
+    float solution_painting = 0;
+    float backtrack = 0;
+    float display = 0;
+};
+
+using PhaseClock = std::chrono::steady_clock;
+
+
+/**
+ * Computes the milliseconds elapsed since a point in time.
+ *
+ * @param start_ts This is the point in time at which the phase has started.
+ * @return the elapsed milliseconds, with a microseconds' resolution.
+ */
+inline float elapsed_milliseconds_since(PhaseClock::time_point start_ts) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(PhaseClock::now() - start_ts).count() / 1000.f;
+}
+
+#endif //RANDOMMAZESOLVER_PHASE_TIMINGS_H
@@ -0,0 +1,122 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#ifndef RANDOMMAZESOLVER_PHILOX_H
+#define RANDOMMAZESOLVER_PHILOX_H
+
+#include <array>
+#include <cstdint>
+
+
+/**
+ * Counter-based random number generator (Philox4x32-10).
+ *
+ * Each output is a pure function of a 128-bit counter and of the 64-bit key, so there is no internal state to share
+ * or to advance. The particles use their index and the current step as counter: any thread can compute any particle's
+ * random value in any order and always obtain the same sequence of movements for the same key.
+ * The outputs match the reference Random123 implementation.
+ */
+class Philox4x32 {
+public:
+    explicit Philox4x32(uint64_t seed) : key({static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)}) {}
+
+    /**
+     * Computes the 4 random values bound to the given counter.
+     *
+     * @param counter This is the counter to encrypt.
+     * @return 4 uniformly distributed 32-bit values.
+     */
+    [[nodiscard]] std::array<uint32_t, 4> operator()(std::array<uint32_t, 4> counter) const {
+        std::array<uint32_t, 2> round_key = this->key;
+        for(int round = 0; round < 10; round++) {
+            uint64_t product_0 = static_cast<uint64_t>(M0) * counter[0];
+            uint64_t product_1 = static_cast<uint64_t>(M1) * counter[2];
+            counter = {static_cast<uint32_t>(product_1 >> 32) ^ counter[1] ^ round_key[0], static_cast<uint32_t>(product_1),
+                       static_cast<uint32_t>(product_0 >> 32) ^ counter[3] ^ round_key[1], static_cast<uint32_t>(product_0)};
+            round_key[0] += W0;
+            round_key[1] += W1;
+        }
+        return counter;
+    }
+
+    /**
+     * Retrieves the random value assigned to a particle at the given step of its movements.
+     *
+     * @param particle This is the index of the particle.
+     * @param step This is the current step of the movements.
+     * @return a uniformly distributed 32-bit value.
+     */
+    [[nodiscard]] uint32_t particle_value(uint32_t particle, uint32_t step) const {
+        return (*this)({step, particle, 0, 0})[0];
+    }
+
+    /// Key of the generator, used by the vectorized implementations.
+    [[nodiscard]] std::array<uint32_t, 2> get_key() const { return this->key; }
+
+    static constexpr uint32_t M0 = 0xD2511F53;
+    static constexpr uint32_t M1 = 0xCD9E8D57;
+    static constexpr uint32_t W0 = 0x9E3779B9;
+    static constexpr uint32_t W1 = 0xBB67AE85;
+
+private:
+    std::array<uint32_t, 2> key;
+};
+
+
+/**
+ * Stream of random values bound to an item and a step, usable by the standard random distributions.
+ *
+ * The values are drawn 4 at a time from the counter {step, item, block, 1}, so any thread can rebuild the stream of
+ * any item at any step, as it happens for the particles' values. The last word of the counter is set, so the streams
+ * never overlap the values assigned to the particles.
+ */
+class PhiloxStream {
+public:
+    using result_type = uint32_t;
+
+    PhiloxStream(const Philox4x32 &rng, uint32_t item, uint32_t step) : rng(rng), item(item), step(step) {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT32_MAX; }
+
+    result_type operator()() {
+        if(this->next_value == 4) {
+            this->values = this->rng({this->step, this->item, this->block++, 1});
+            this->next_value = 0;
+        }
+        return this->values[this->next_value++];
+    }
+
+private:
+    const Philox4x32 &rng;
+    uint32_t item;
+    uint32_t step;
+    uint32_t block = 0;
+    std::array<uint32_t, 4> values {};
+    int next_value = 4;
+};
+
+
+/**
+ * Maps a random 32-bit value onto an index in [0, n).
+ *
+ * The multiply-shift reduction is used instead of the modulo. Its bias is lower than n / 2^32.
+ * @param value This is the random value to map.
+ * @param n This is the number of available indexes.
+ * @return the selected index.
+ */
+inline int bounded_index(uint32_t value, int n) {
+    return static_cast<int>((static_cast<uint64_t>(value) * static_cast<uint32_t>(n)) >> 32);
+}
+
+
+/**
+ * Maps a random 32-bit value onto a real number in (0, 1), so that its logarithm is always defined.
+ *
+ * @param value This is the random value to map.
+ * @return the uniformly distributed real number.
+ */
+inline double open_unit_value(uint32_t value) {
+    return (static_cast<double>(value) + 0.5) * 0x1p-32;
+}
+
+#endif //RANDOMMAZESOLVER_PHILOX_H
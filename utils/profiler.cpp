@@ -0,0 +1,193 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <iostream>
+#include <mutex>
+
+#ifdef GPERFTOOLS_CPU_PROFILER
+#include <gperftools/profiler.h>
+#endif
+#ifdef GPERFTOOLS_HEAP_PROFILER
+#include <gperftools/heap-profiler.h>
+#endif
+
+#include "profiler.h"
+
+
+// PROTOTYPES
+bool start_profiles(const std::string &name);
+void stop_profiles();
+void toggle_profiling(int);
+
+
+// GLOBAL VARIABLES
+// The settings are read once, before the executions start
+ProfilingSettings profiling_settings;
+// Set by default, or by SIGUSR1 when the profiling is toggled by the signal
+std::atomic<bool> profiling_enabled = false;
+// The profilers are shared by the whole process, so a single profile at a time can be taken
+std::mutex profiles_mutex;
+bool profiles_running = false;
+// Execution that is being run by each thread
+thread_local ExecutionProfile *current_execution = nullptr;
+
+
+// FUNCTIONS
+
+/**
+ * Stores the profiling's settings and disables the profilers that are missing from the current build.
+ *
+ * @param settings These are the profiling's settings read from the configuration.
+ * @return true if any profile can be taken.
+ */
+bool configure_profiling(const ProfilingSettings &settings) {
+    profiling_settings = settings;
+
+#ifndef GPERFTOOLS_CPU_PROFILER
+    if(profiling_settings.cpu) {
+        std::cout << "The CPU profiler is not available, since gperftools has not been found at build time" << std::endl;
+        profiling_settings.cpu = false;
+    }
+#endif
+#ifndef GPERFTOOLS_HEAP_PROFILER
+    if(profiling_settings.heap) {
+        std::cout << "The heap profiler is not available, since tcmalloc has not been found at build time" << std::endl;
+        profiling_settings.heap = false;
+    }
+#endif
+    if(!profiling_settings.cpu && !profiling_settings.heap)
+        return false;
+
+    std::error_code error;
+    std::filesystem::create_directories(profiling_settings.profiles_path, error);
+
+#ifdef SIGUSR1
+    if(profiling_settings.signal_toggle) {
+        std::signal(SIGUSR1, toggle_profiling);
+        std::cout << "The profiling is paused, send SIGUSR1 to start and stop it" << std::endl;
+        return true;
+    }
+#endif
+    profiling_enabled = true;
+    return true;
+}
+
+
+/**
+ * Profiles the whole execution if it has been selected and no phase has been.
+ *
+ * @param version This is the version that runs the execution.
+ * @param generation_seed This is the seed that is used for the maze's generation.
+ * @param solution_seed This is the seed that is used for the maze's solution.
+ * @param execution This is the index of the execution.
+ */
+ExecutionProfile::ExecutionProfile(const std::string &version, long generation_seed, long solution_seed, int execution) {
+    const std::vector<int> &executions = profiling_settings.executions;
+    this->is_selected = (profiling_settings.cpu || profiling_settings.heap) &&
+                        (executions.empty() || std::find(executions.begin(), executions.end(), execution) != executions.end());
+
+    // The name is built only when needed, so the executions that are not profiled allocate nothing
+    if(this->is_selected)
+        this->profile_name = version + "_" + std::to_string(generation_seed) + "_" + std::to_string(solution_seed) + "_" + std::to_string(execution);
+
+    current_execution = this;
+    if(this->is_selected && profiling_settings.phases.empty())
+        this->profiling = start_profiles(this->profile_name);
+}
+
+
+ExecutionProfile::~ExecutionProfile() {
+    if(this->profiling)
+        stop_profiles();
+    current_execution = nullptr;
+}
+
+
+/**
+ * Profiles a phase of the execution run by the calling thread.
+ *
+ * @param phase This is the name of the phase.
+ */
+ProfileScope::ProfileScope(const std::string &phase) {
+    const ExecutionProfile *execution = current_execution;
+    if(!execution || !execution->selected())
+        return;
+
+    const std::vector<std::string> &phases = profiling_settings.phases;
+    if(std::find(phases.begin(), phases.end(), phase) != phases.end())
+        this->profiling = start_profiles(execution->name() + "_" + phase);
+}
+
+
+ProfileScope::~ProfileScope() {
+    if(this->profiling)
+        stop_profiles();
+}
+
+
+/**
+ * Starts the selected profilers, unless the profiling is paused or another profile is being taken.
+ *
+ * The CPU profile is written into "<name>.prof", while the heap profiles are dumped into "<name>.<number>.heap".
+ * If the profiles of a previous run have the same name, a counter is appended to it.
+ * @param name This is the name of the profiles.
+ * @return true if the profilers have been started.
+ */
+bool start_profiles(const std::string &name) {
+    if(!profiling_enabled.load())
+        return false;
+
+    std::lock_guard<std::mutex> lock(profiles_mutex);
+    if(profiles_running)
+        return false;
+
+    std::string profile_prefix;
+    for(int copy = 0; copy == 0 || std::filesystem::exists(profile_prefix + ".prof") || std::filesystem::exists(profile_prefix + ".0001.heap"); copy++)
+        profile_prefix = (profiling_settings.profiles_path / (copy == 0 ? name : name + "_" + std::to_string(copy))).string();
+
+#ifdef GPERFTOOLS_CPU_PROFILER
+    if(profiling_settings.cpu && !ProfilerStart((profile_prefix + ".prof").c_str()))
+        std::cout << "Unable to start the CPU profiler" << std::endl;
+#endif
+#ifdef GPERFTOOLS_HEAP_PROFILER
+    if(profiling_settings.heap)
+        HeapProfilerStart(profile_prefix.c_str());
+#endif
+
+    profiles_running = true;
+    return true;
+}
+
+
+/**
+ * Stops the profilers and writes the last profiles.
+ */
+void stop_profiles() {
+    std::lock_guard<std::mutex> lock(profiles_mutex);
+
+#ifdef GPERFTOOLS_CPU_PROFILER
+    if(profiling_settings.cpu)
+        ProfilerStop();
+#endif
+#ifdef GPERFTOOLS_HEAP_PROFILER
+    if(profiling_settings.heap) {
+        HeapProfilerDump("end of the profile");
+        HeapProfilerStop();
+    }
+#endif
+
+    profiles_running = false;
+}
+
+
+/**
+ * Signal's handler that pauses and resumes the profiling. The profiles that are being taken are not interrupted.
+ *
+ * The flag is flipped by a compare and swap, so two signals that arrive close together never cancel each other.
+ */
+void toggle_profiling(int) {
+    bool enabled = profiling_enabled.load();
+    while(!profiling_enabled.compare_exchange_weak(enabled, !enabled)) {}
+}
@@ -0,0 +1,63 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#ifndef RANDOMMAZESOLVER_PROFILER_H
+#define RANDOMMAZESOLVER_PROFILER_H
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// ENUMS AND STRUCTS
+
+/// Which profiles are taken and around what, as read from the configuration.
+struct ProfilingSettings {
+    bool cpu = false;
+    bool heap = false;
+    // The profiling is paused until SIGUSR1 is received, and each signal toggles it
+    bool signal_toggle = false;
+    // Phases to profile, the whole executions are profiled if there are none
+    std::vector<std::string> phases;
+    // Indexes of the executions to profile, all of them if there are none
+    std::vector<int> executions;
+    std::filesystem::path profiles_path;
+};
+
+
+/**
+ * Marks the execution that is being run by the calling thread, and profiles it whole if no phase has been selected.
+ *
+ * The profiles are named after the version, the seeds and the index of the execution. The profilers are shared by
+ * the whole process, so when the executions run concurrently only the first one that asks for a profile gets it.
+ */
+class ExecutionProfile {
+public:
+    ExecutionProfile(const std::string &version, long generation_seed, long solution_seed, int execution);
+    ~ExecutionProfile();
+    ExecutionProfile(const ExecutionProfile &) = delete;
+    ExecutionProfile &operator=(const ExecutionProfile &) = delete;
+
+    [[nodiscard]] bool selected() const { return this->is_selected; }
+    [[nodiscard]] const std::string &name() const { return this->profile_name; }
+
+private:
+    std::string profile_name;
+    bool is_selected;
+    bool profiling = false;
+};
+
+
+/// Profiles a phase of the current execution, if the phase has been selected.
+class ProfileScope {
+public:
+    explicit ProfileScope(const std::string &phase);
+    ~ProfileScope();
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+    bool profiling = false;
+};
+
+bool configure_profiling(const ProfilingSettings &settings);
+
+#endif //RANDOMMAZESOLVER_PROFILER_H
@@ -0,0 +1,347 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <omp.h>
+
+#include "results_writer.h"
+
+// GLOBAL VARIABLES
+// The phases' columns follow the total elapsed time, every time is expressed in milliseconds
+constexpr const char *REPORT_HEADER = "version,elapsed_time,generation_time,setup_time,random_walk_time,solution_painting_time,"
+                                      "backtrack_time,display_time,maze_size,n_particles,generation_seed,solution_seed,maze_image_path,"
+                                      "solution_check";
+// Each row holds the counters of a thread during a phase, the execution is identified by its maze's image
+constexpr const char *COUNTERS_HEADER = "version,generation_seed,solution_seed,maze_image_path,phase,thread_id,cycles,"
+                                        "instructions,cache_misses,branch_misses,context_switches";
+// Written into the report's last column, indexed by SOLUTION_CHECK
+constexpr const char *SOLUTION_CHECK_NAMES[] = {"unchecked", "matching", "mismatching"};
+
+
+// FUNCTIONS
+
+/**
+ * Starts the writer's thread.
+ *
+ * @param project_folder This is the root path of the current project.
+ * @param max_pending This is the maximum number of executions that can wait to be written.
+ * @param save_maze Flag used to save the mazes into binary files too.
+ * @param image_format This is the format of the mazes' images.
+ * @param render_threads This is the number of threads that render the big images, 0 uses all the available ones.
+ */
+ResultsWriter::ResultsWriter(const std::filesystem::path &project_folder, int max_pending, bool save_maze, IMAGE_FORMAT image_format, int render_threads) {
+    this->results_path = project_folder / "results";
+    this->max_pending = static_cast<size_t>(std::max(max_pending, 1));
+    this->save_maze = save_maze;
+    this->image_format = image_format;
+    this->render_threads = render_threads > 0 ? render_threads : omp_get_max_threads();
+    this->spare_mazes.reserve(this->max_pending + 1);
+    this->writer = std::thread(&ResultsWriter::run, this);
+}
+
+
+ResultsWriter::~ResultsWriter() {
+    this->close();
+}
+
+
+/**
+ * Queues the results of an execution.
+ *
+ * This returns as soon as there is room into the queue, the results are written later by the writer's thread.
+ * The time of the submission is used in order to name the maze's image.
+ * @param record This is the execution to save. Its maze is moved into the queue.
+ */
+void ResultsWriter::submit(ExecutionRecord record) {
+    record.finished_at = std::time(nullptr);
+
+    std::unique_lock<std::mutex> lock(this->queue_mutex);
+    this->queue_not_full.wait(lock, [this] { return this->queue.size() < this->max_pending; });
+    this->queue.push_back(std::move(record));
+    lock.unlock();
+    this->queue_not_empty.notify_one();
+}
+
+
+/**
+ * Takes the grid of a maze that has already been written, so that its memory can be reused by the next execution.
+ *
+ * @return a written maze, or an empty one if there is none.
+ */
+Maze ResultsWriter::recycle_maze() {
+    std::lock_guard<std::mutex> lock(this->queue_mutex);
+    if(this->spare_mazes.empty())
+        return {};
+
+    Maze maze = std::move(this->spare_mazes.back());
+    this->spare_mazes.pop_back();
+    return maze;
+}
+
+
+/**
+ * Writes all the queued results and stops the writer's thread.
+ */
+void ResultsWriter::close() {
+    if(!this->writer.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(this->queue_mutex);
+        this->closing = true;
+    }
+    this->queue_not_empty.notify_one();
+    this->writer.join();
+}
+
+
+/**
+ * Writer's loop: it writes the queued records one by one and flushes the report when there is nothing left to do.
+ */
+void ResultsWriter::run() {
+    // The images above the renderer's threshold are split among the writer's own team of threads, which share the cores
+    // with the next executions. The smaller ones are rendered by this thread alone
+    omp_set_num_threads(this->render_threads);
+
+    std::filesystem::path images_path = this->results_path / "mazes";
+    std::error_code error;
+    std::filesystem::create_directories(images_path, error);
+
+    std::unique_lock<std::mutex> lock(this->queue_mutex);
+    while(true) {
+        this->queue_not_empty.wait(lock, [this] { return !this->queue.empty() || this->closing; });
+        if(this->queue.empty())
+            break;
+
+        ExecutionRecord record = std::move(this->queue.front());
+        this->queue.pop_front();
+        bool last_queued = this->queue.empty();
+        lock.unlock();
+        this->queue_not_full.notify_one();
+
+        this->write(record);
+        if(last_queued)
+            this->flush_report();
+
+        lock.lock();
+        // The written mazes are kept for the next executions, as long as they would fit into the queue
+        if(this->spare_mazes.size() <= this->max_pending)
+            this->spare_mazes.push_back(std::move(record.maze));
+    }
+
+    this->flush_report();
+}
+
+
+/**
+ * Saves the maze's image and the maze's file of an execution, and adds its row to the next batch of the report.
+ *
+ * @param record This is the execution to save.
+ */
+void ResultsWriter::write(ExecutionRecord &record) {
+    std::string version = record.is_sequential ? "sequential" : "parallel";
+
+    // Saving the maze's image, or reserving the maze file's name when there is no image
+    std::filesystem::path images_path = this->results_path / "mazes";
+    std::filesystem::path maze_image_path;
+    if(this->image_format != IMAGE_FORMAT::NO_IMAGE || this->save_maze)
+        maze_image_path = save_maze_image(images_path, version, record.maze, record.size, record.solution_seed, record.finished_at, this->save_maze, this->image_format);
+
+    // Saving the maze's binary file next to its image
+    if(this->save_maze) {
+        std::filesystem::path maze_file_path = maze_image_path;
+        maze_file_path.replace_extension(".rmz");
+        save_binary_maze(maze_file_path, record.maze, record.exit_coords, record.algorithm, record.generation_seed, record.solution_seed);
+    }
+
+    // Saves the current record
+    std::ostringstream row;
+    const PhaseTimings &timings = record.timings;
+    row << "\n" << version << "," << record.elapsed_milliseconds << "," << timings.generation << "," << timings.setup << ","
+        << timings.random_walk << "," << timings.solution_painting << "," << timings.backtrack << "," << timings.display
+        << "," << record.size << "," << record.n_particles << "," << record.generation_seed << "," << record.solution_seed << "," << maze_image_path
+        << "," << SOLUTION_CHECK_NAMES[record.solution_check];
+    this->report_rows += row.str();
+
+    // Saves the counters of the record, -1 stands for the events that can't be counted
+    std::ostringstream counters_rows;
+    for(const PerfSample &sample : record.counters.samples) {
+        counters_rows << "\n" << version << "," << record.generation_seed << "," << record.solution_seed << ","
+                      << maze_image_path << "," << sample.phase << "," << sample.thread_id;
+        for(int64_t value : sample.values)
+            counters_rows << "," << value;
+    }
+    this->counters_rows += counters_rows.str();
+}
+
+
+/**
+ * Appends the batch of rows to the report file.
+ *
+ * The file is opened once and kept open, the header is written only if the report doesn't exist yet.
+ * A report written with different columns is renamed, so that its rows are not mixed with the new ones.
+ * The counters' rows are flushed along with the report's ones.
+ */
+void ResultsWriter::flush_report() {
+    this->flush_counters();
+    if(this->report_rows.empty())
+        return;
+
+    if(!this->report_file.is_open()) {
+        std::filesystem::path report_path = this->results_path / "executions_report.csv";
+        bool new_report = !std::filesystem::exists(report_path);
+        if(!new_report && !has_report_header(report_path)) {
+            std::filesystem::path old_report_path;
+            for(int copy = 0; copy == 0 || std::filesystem::exists(old_report_path); copy++)
+                old_report_path = this->results_path / ("executions_report_old" + (copy == 0 ? "" : "_" + std::to_string(copy)) + ".csv");
+
+            std::error_code error;
+            std::filesystem::rename(report_path, old_report_path, error);
+            if(!error) {
+                std::cout << "The executions' report has different columns, it has been moved to " << old_report_path << std::endl;
+                new_report = true;
+            }
+        }
+
+        this->report_file.open(report_path.c_str(), std::fstream::app);
+        if(new_report)
+            this->report_file << REPORT_HEADER;
+    }
+
+    this->report_file << this->report_rows;
+    this->report_file.flush();
+    if(!this->report_file)
+        std::cout << "Unable to write the executions' report" << std::endl;
+    this->report_rows.clear();
+}
+
+
+/**
+ * Appends the batch of counters' rows to the counters' report.
+ *
+ * The counters' report is created only when there is something to write into it.
+ */
+void ResultsWriter::flush_counters() {
+    if(this->counters_rows.empty())
+        return;
+
+    if(!this->counters_file.is_open()) {
+        std::filesystem::path counters_path = this->results_path / "executions_counters.csv";
+        bool new_report = !std::filesystem::exists(counters_path);
+        this->counters_file.open(counters_path.c_str(), std::fstream::app);
+        if(new_report)
+            this->counters_file << COUNTERS_HEADER;
+    }
+
+    this->counters_file << this->counters_rows;
+    this->counters_file.flush();
+    if(!this->counters_file)
+        std::cout << "Unable to write the executions' counters" << std::endl;
+    this->counters_rows.clear();
+}
+
+
+/**
+ * Checks if a report has been written with the current columns.
+ *
+ * @param report_path This is the location of the report.
+ * @return true if the first line of the report is the current header.
+ */
+bool has_report_header(const std::filesystem::path &report_path) {
+    std::ifstream report(report_path.c_str());
+    std::string header;
+    std::getline(report, header);
+    return header == REPORT_HEADER;
+}
+
+
+/**
+ * Saves the current maze's image to the disk.
+ *
+ * This function generates a file containing the maze's structure rendered with ascii characters or as a binary
+ * PGM/PBM image, in order to be able to visualize it later with it's solution path.
+ * The image is rendered into a single buffer, that is written at once.
+ * The image is named after the version, the time of the execution and the solution's seed. Those can be the same for
+ * two executions, so the file is created only if it doesn't exist yet, and a counter is appended to the name until
+ * a free one is found. Without an image, the name is reserved for the maze's binary file only.
+ * @param images_path This is the base location for maze's images.
+ * @param version This string is used to tell if the current maze belongs to a sequential or parallel version.
+ * @param maze This is the matrix that represents the maze's inner structure along with the solution path.
+ * @param size This value represents each maze's side size.
+ * @param solution_seed This value represents the seed used for the maze's solution.
+ * @param finished_at This is the time at which the execution has ended.
+ * @param save_maze Flag used to reserve the name of the maze's binary file too.
+ * @param image_format This is the format of the image.
+ * @return the path of the image.
+ */
+std::filesystem::path save_maze_image(const std::filesystem::path &images_path, const std::string &version, Maze &maze, int &size, long solution_seed, std::time_t finished_at, bool save_maze, IMAGE_FORMAT image_format) {
+    char buf[256] = { 0 };
+    // ISO 8601 format for the timestamp
+    std::strftime(buf, sizeof(buf), "%y-%m-%dT%H:%M:%S", std::localtime(&finished_at));
+    std::string base_name = version + "_" + std::string(buf) + "_" + std::to_string(solution_seed);
+    const char *extension = image_format == IMAGE_FORMAT::PGM ? ".pgm" : image_format == IMAGE_FORMAT::PBM ? ".pbm" :
+                            image_format == IMAGE_FORMAT::NO_IMAGE ? ".rmz" : ".txt";
+
+    // Building the unique image path
+    std::filesystem::path image_path;
+    std::ofstream output_image;
+    for(int copy = 0; !output_image.is_open(); copy++) {
+        image_path = images_path / (copy == 0 ? base_name + extension : base_name + "_" + std::to_string(copy) + extension);
+        std::filesystem::path maze_file_path = image_path;
+        if(save_maze && std::filesystem::exists(maze_file_path.replace_extension(".rmz")))
+            continue;
+
+        output_image.open(image_path.c_str(), std::ios::binary | std::ios::noreplace);
+        // The name is free, but the file can't be created
+        if(!output_image.is_open() && !std::filesystem::exists(image_path)) {
+            std::cout << "Unable to write the maze's image " << image_path << std::endl;
+            return image_path;
+        }
+    }
+
+    if(image_format == IMAGE_FORMAT::NO_IMAGE)
+        return image_path;
+
+    // Generating the maze image
+    std::string maze_image;
+    if(image_format == IMAGE_FORMAT::PGM)
+        maze_image = generate_pgm_maze(maze, size);
+    else if(image_format == IMAGE_FORMAT::PBM)
+        maze_image = generate_pbm_maze(maze, size);
+    else
+        maze_image = generate_ascii_maze(maze, size);
+
+    // Saving the image to the disk
+    output_image.write(maze_image.data(), static_cast<std::streamsize>(maze_image.size()));
+    output_image.close();
+
+    return image_path;
+}
+
+
+/**
+ * Saves the current maze to the disk, into the binary maze format.
+ *
+ * Only the maze's structure is stored, along with the position of its exit.
+ * The file can be loaded back through the "maze_file" setting in order to solve the same maze again.
+ * The exit is given by the generation, since the solution's path has been painted over it.
+ * @param maze_path This is the location of the file.
+ * @param maze This is the matrix that represents the maze's inner structure along with the solution path.
+ * @param exit_coords These are the coordinates of the maze's exit.
+ * @param algorithm This is the algorithm that generated the maze.
+ * @param generation_seed This is the seed that has been used for the maze's generation.
+ * @param solution_seed This is the seed that has been used for the maze's solution.
+ */
+void save_binary_maze(const std::filesystem::path &maze_path, Maze &maze, const Coordinates &exit_coords, GENERATION_ALGORITHM algorithm, long generation_seed, long solution_seed) {
+    MazeFileHeader header {};
+    header.algorithm = algorithm;
+    header.generation_seed = generation_seed;
+    header.solution_seed = solution_seed;
+    header.exit_row = exit_coords.row;
+    header.exit_col = exit_coords.col;
+
+    PackedMaze packed;
+    packed.from_maze(maze);
+    save_maze_file(maze_path, header, packed);
+}
@@ -0,0 +1,105 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#ifndef RANDOMMAZESOLVER_RESULTS_WRITER_H
+#define RANDOMMAZESOLVER_RESULTS_WRITER_H
+
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "utils.h"
+#include "phase_timings.h"
+#include "solution_outcome.h"
+#include "perf_counters.h"
+#include "maze/coordinates.h"
+#include "maze/maze_file.h"
+
+// ENUMS AND STRUCTS
+
+/// Outcome of the comparison between the mazes solved by the two versions in the same execution.
+enum SOLUTION_CHECK {
+    UNCHECKED = 0,
+    MATCHING = 1,
+    MISMATCHING = 2,
+};
+
+
+/// Everything that is saved about a single execution.
+struct ExecutionRecord {
+    bool is_sequential;
+    long generation_seed;
+    long solution_seed;
+    float elapsed_milliseconds;
+    PhaseTimings timings;
+    PhaseCounters counters;
+    long n_particles;
+    int size;
+    Maze maze;
+    Coordinates exit_coords;
+    SolutionOutcome outcome;
+    GENERATION_ALGORITHM algorithm;
+    SOLUTION_CHECK solution_check;
+    std::time_t finished_at;
+};
+
+
+/**
+ * Saves the executions' results from its own thread.
+ *
+ * The executions are queued and the images, the maze files and the report's rows are written in the background,
+ * so the next execution can start right away. The queue is bounded, because each record holds a whole maze: when it
+ * is full, the executions wait for the oldest record to be written. The report's rows are appended in batches,
+ * whenever the queue gets empty, and everything that is still queued is written when the writer is closed.
+ * The performance counters of the executions, if any, are written into their own report, next to the main one.
+ * The written mazes are kept aside, so that the executions can take them back instead of allocating new ones.
+ * The images that are big enough are rendered by a team of threads started by the writer's thread.
+ */
+class ResultsWriter {
+public:
+    ResultsWriter(const std::filesystem::path &project_folder, int max_pending, bool save_maze, IMAGE_FORMAT image_format, int render_threads);
+    ~ResultsWriter();
+    ResultsWriter(const ResultsWriter &) = delete;
+    ResultsWriter &operator=(const ResultsWriter &) = delete;
+
+    void submit(ExecutionRecord record);
+    Maze recycle_maze();
+    void close();
+
+private:
+    void run();
+    void write(ExecutionRecord &record);
+    void flush_report();
+    void flush_counters();
+
+    std::filesystem::path results_path;
+    size_t max_pending;
+    bool save_maze;
+    IMAGE_FORMAT image_format;
+    int render_threads;
+
+    std::thread writer;
+    std::mutex queue_mutex;
+    std::condition_variable queue_not_empty;
+    std::condition_variable queue_not_full;
+    std::deque<ExecutionRecord> queue;
+    bool closing = false;
+    // Mazes that have already been written, guarded by the queue's mutex
+    std::vector<Maze> spare_mazes;
+
+    // Rows written since the last flush of the report
+    std::string report_rows;
+    std::ofstream report_file;
+    std::string counters_rows;
+    std::ofstream counters_file;
+};
+
+bool has_report_header(const std::filesystem::path &report_path);
+std::filesystem::path save_maze_image(const std::filesystem::path &images_path, const std::string &version, Maze &maze, int &size, long solution_seed, std::time_t finished_at, bool save_maze, IMAGE_FORMAT image_format);
+void save_binary_maze(const std::filesystem::path &maze_path, Maze &maze, const Coordinates &exit_coords, GENERATION_ALGORITHM algorithm, long generation_seed, long solution_seed);
+
+#endif //RANDOMMAZESOLVER_RESULTS_WRITER_H
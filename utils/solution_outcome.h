@@ -0,0 +1,25 @@
+// Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
+
+#ifndef RANDOMMAZESOLVER_SOLUTION_OUTCOME_H
+#define RANDOMMAZESOLVER_SOLUTION_OUTCOME_H
+
+#include <cstdint>
+
+// ENUMS AND STRUCTS
+
+/**
+ * Outcome of the random walk and of the backtracking of an execution.
+ *
+ * In deterministic mode both the versions walk the same particles with the same generator, so their outcomes must
+ * be equal too, along with the painted mazes.
+ */
+struct SolutionOutcome {
+    // It stays -1 when the particles are moved as counts, as they don't have an index
+    int exited_particle_index = -1;
+    int64_t exit_step = -1;
+    int backtrack_steps = -1;
+
+    bool operator==(const SolutionOutcome &) const = default;
+};
+
+#endif //RANDOMMAZESOLVER_SOLUTION_OUTCOME_H
@@ -1,11 +1,37 @@
 // Copyright (c) 2023. Created by Mattia Bennati, a.k.a Scrayil. All rights reserved.
 
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <string_view>
 #include <thread>
 
 #include "../utils/utils.h"
 
+// GLOBAL VARIABLES
+// Characters used to draw each MAZE_PATH value, the multibyte ones take 5 bytes
+constexpr std::array<std::string_view, 6> ASCII_GLYPHS = {"   ", "  □", "   ", "  x", "  ●", "  o"};
+// Size of the blocks used to copy the glyphs without looking at their length
+constexpr size_t ASCII_BLOCK_SIZE = 8;
+static_assert(std::ranges::all_of(ASCII_GLYPHS, [](std::string_view glyph) { return glyph.size() <= ASCII_BLOCK_SIZE; }),
+              "Every glyph must fit into a block");
+// The same glyphs, padded to the block's size
+constexpr std::array<std::array<char, ASCII_BLOCK_SIZE>, 6> ASCII_BLOCKS = [] {
+    std::array<std::array<char, ASCII_BLOCK_SIZE>, 6> blocks {};
+    for(size_t path = 0; path < ASCII_GLYPHS.size(); path++)
+        for(size_t byte = 0; byte < ASCII_GLYPHS[path].size(); byte++)
+            blocks[path][byte] = ASCII_GLYPHS[path][byte];
+    return blocks;
+}();
+// Gray levels used to draw each MAZE_PATH value: walls are black and the walkable cells are white
+constexpr std::array<uint8_t, 6> GRAY_LEVELS = {255, 0, 255, 96, 160, 208};
+// Cells above which the images are rendered in parallel
+constexpr long PARALLEL_RENDER_CELLS = 1L << 20;
+// Stream that receives the progress of the execution running onto the current thread, if it is not the standard output
+thread_local std::ostream *execution_stream = nullptr;
+
 // FUNCTIONS
 
 /**
@@ -13,10 +39,11 @@
  *
  * All the items in the configuration are loaded into a proper structure.
  * @param project_folder This is the path related to the current project.
+ * @param file_name This is the name of the configuration's file, inside the "config" folder.
  * @return A json object that contains all the specified parameters.
  */
-nlohmann::json parse_configuration(const std::filesystem::path& project_folder) {
-    std::filesystem::path config_path = project_folder / "config" / "default.json";
+nlohmann::json parse_configuration(const std::filesystem::path& project_folder, const std::string &file_name) {
+    std::filesystem::path config_path = project_folder / "config" / file_name;
     std::ifstream config_file;
     config_file.open(config_path);
     nlohmann::json json_config = nlohmann::json::parse(config_file);
@@ -44,6 +71,42 @@ std::filesystem::path find_project_path() {
 }
 
 
+/**
+ * Retrieves the stream that receives the progress of the execution running onto the current thread.
+ *
+ * The concurrent executions collect their progress into their own buffers, which are printed at once when they end,
+ * so that their lines don't interleave. Otherwise the progress is printed right away.
+ * @return the execution's stream, or the standard output when there is none.
+ */
+std::ostream &execution_output() {
+    return execution_stream ? *execution_stream : std::cout;
+}
+
+
+/**
+ * Sets the stream that receives the progress of the execution running onto the current thread.
+ *
+ * The threads started by the execution's parallel regions keep printing onto the standard output.
+ * @param output This is the execution's stream, nullptr prints the progress onto the standard output again.
+ */
+void set_execution_output(std::ostream *output) {
+    execution_stream = output;
+}
+
+
+/**
+ * Reports the throughput of a maze's carving in walkable cells per second.
+ *
+ * @param n_cells This is the number of walkable cells that have been carved.
+ * @param start_ts This is the time at which the carving started, it is considered finished when the function is called.
+ */
+void print_carving_rate(long n_cells, std::chrono::steady_clock::time_point start_ts) {
+    double elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_ts).count();
+    execution_output() << "Carved " << n_cells << " cells in " << elapsed_seconds * 1000 << " ms ("
+              << static_cast<long>(elapsed_seconds > 0 ? n_cells / elapsed_seconds : 0) << " cells/s)" << std::endl;
+}
+
+
 /**
  * Prints the maze's inner structure by using ascii characters.
  *
@@ -52,43 +115,193 @@ std::filesystem::path find_project_path() {
  *  @param size Represents the length of each maze's side.
  *  @param show_steps Flag used to determine if each change step is being shown on screen.
  */
-void display_ascii_maze(std::vector<std::vector<MAZE_PATH>> &maze, int &size, bool show_steps) {
+void display_ascii_maze(Maze &maze, int &size, bool show_steps) {
     if(show_steps) {
-        std::cout << "\x1B[2J\x1B[H";
+        execution_output() << "\x1B[2J\x1B[H";
         std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
     std::string ascii_maze = generate_ascii_maze(maze, size);
-    std::cout << ascii_maze << std::endl << std::endl;
+    execution_output() << ascii_maze << std::endl << std::endl;
+}
+
+
+/**
+ * Prints the maze's inner structure by using ascii characters, and adds the time it took to the display's phase.
+ *
+ * @see display_ascii_maze.
+ * @param maze It's the matrix representing the maze in it's current state.
+ * @param size Represents the length of each maze's side.
+ * @param show_steps Flag used to determine if each change step is being shown on screen.
+ * @param timings These are the phases' timings of the current execution.
+ */
+void display_ascii_maze(Maze &maze, int &size, bool show_steps, PhaseTimings &timings) {
+    AsciiBuffer buffer;
+    display_ascii_maze(maze, size, show_steps, timings, buffer);
+}
+
+
+/**
+ * Prints the maze's inner structure by using ascii characters rendered into a reused buffer, and adds the time it took
+ * to the display's phase.
+ *
+ * @see display_ascii_maze.
+ * @param maze It's the matrix representing the maze in it's current state.
+ * @param size Represents the length of each maze's side.
+ * @param show_steps Flag used to determine if each change step is being shown on screen.
+ * @param timings These are the phases' timings of the current execution.
+ * @param buffer This is the memory that receives the rendered image.
+ */
+void display_ascii_maze(Maze &maze, int &size, bool show_steps, PhaseTimings &timings, AsciiBuffer &buffer) {
+    PhaseClock::time_point start_ts = PhaseClock::now();
+    if(show_steps) {
+        execution_output() << "\x1B[2J\x1B[H";
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    execution_output() << generate_ascii_maze(maze, size, buffer) << std::endl << std::endl;
+    timings.display += elapsed_milliseconds_since(start_ts);
+}
+
+
+/**
+ * Tells if the images of a maze are big enough to be rendered by many threads.
+ *
+ * @param size Represents the length of each maze's side.
+ * @return true if the renderers split the maze's rows among the available threads, false if they don't fork at all.
+ */
+bool render_in_parallel(int size) {
+    return static_cast<long>(size) * size > PARALLEL_RENDER_CELLS;
 }
 
 
 /**
  * Generates a string that represents the maze's inner structure by using ascii characters.
  *
- * This function simply reads the content of the maze's matrix and appends it's corresponding characters
- * to a string in order to visualize it.
+ * @see generate_ascii_maze.
+ *  @param maze It's the matrix representing the maze in it's current state.
+ *  @param size Represents the length of each maze's side.
+ *  @return the rendered image.
+ */
+std::string generate_ascii_maze(Maze &maze, int &size) {
+    AsciiBuffer buffer;
+    generate_ascii_maze(maze, size, buffer);
+    return std::move(buffer.image);
+}
+
+
+/**
+ * Renders the maze's inner structure by using ascii characters into a buffer.
+ *
+ * The length of each row is computed first, so that the string is sized once and every row is written directly
+ * at its own offset. Big mazes are rendered by many threads, each one filling its own rows.
+ * The buffer's memory is reused, so rendering mazes of the same size again allocates nothing.
  *
  *  @param maze It's the matrix representing the maze in it's current state.
  *  @param size Represents the length of each maze's side.
+ *  @param buffer This is the memory that receives the rendered image.
+ *  @return the rendered image, held by the buffer.
  */
-std::string generate_ascii_maze(std::vector<std::vector<MAZE_PATH>> &maze, int &size) {
-    std::string ascii_maze;
+const std::string &generate_ascii_maze(Maze &maze, int &size, AsciiBuffer &buffer) {
+    bool parallelize = render_in_parallel(size);
+
+    // Offset of each row inside the string
+    std::vector<size_t> &row_offsets = buffer.row_offsets;
+    row_offsets.assign(size + 1, 0);
+    #pragma omp parallel for if(parallelize)
     for(int row = 0; row < size; row++) {
-        for(int col = 0; col < size; col++) {
-            MAZE_PATH curr_path = maze[row][col];
-            if(curr_path == MAZE_PATH::EMPTY || curr_path == MAZE_PATH::EXIT)
-                ascii_maze += "   ";
-            else if(curr_path == MAZE_PATH::WALL)
-                ascii_maze += "  □";
-            else if(curr_path == MAZE_PATH::START)
-                ascii_maze += "  ●";
-            else if(curr_path == MAZE_PATH::SOLUTION)
-                ascii_maze += "  x";
-            else if(curr_path == MAZE_PATH::PARTICLE)
-                ascii_maze += "  o";
+        size_t row_length = 1;
+        for(int col = 0; col < size; col++)
+            row_length += ASCII_GLYPHS[maze(row, col)].size();
+        row_offsets[row + 1] = row_length;
+    }
+    for(int row = 0; row < size; row++)
+        row_offsets[row + 1] += row_offsets[row];
+
+    std::string &ascii_maze = buffer.image;
+    ascii_maze.assign(row_offsets[size], '\n');
+    #pragma omp parallel for if(parallelize)
+    for(int row = 0; row < size; row++) {
+        char *output = ascii_maze.data() + row_offsets[row];
+        // The row's newline, which must never be overwritten
+        const char *row_end = ascii_maze.data() + row_offsets[row + 1] - 1;
+        // The glyphs are copied as fixed size blocks, whose tail is overwritten by the next glyph, as long as a whole
+        // block fits before the newline. The last ones are copied with their own length.
+        int col = 0;
+        for(; col < size && row_end - output >= static_cast<long>(ASCII_BLOCK_SIZE); col++) {
+            std::memcpy(output, ASCII_BLOCKS[maze(row, col)].data(), ASCII_BLOCK_SIZE);
+            output += ASCII_GLYPHS[maze(row, col)].size();
+        }
+        for(; col < size; col++) {
+            std::string_view glyph = ASCII_GLYPHS[maze(row, col)];
+            std::memcpy(output, glyph.data(), glyph.size());
+            output += glyph.size();
         }
-        ascii_maze += "\n";
     }
 
     return ascii_maze;
+}
+
+
+/**
+ * Retrieves the characters used to draw a cell of the maze.
+ *
+ * Each glyph takes 3 columns of the terminal.
+ *
+ *  @param path This is the content of the cell.
+ *  @return the glyph of the cell.
+ */
+std::string_view ascii_glyph(MAZE_PATH path) {
+    return ASCII_GLYPHS[path];
+}
+
+
+/**
+ * Generates a binary PGM image of the maze's inner structure.
+ *
+ * Each cell becomes a single gray pixel, so the walls, the paths, the solution and the start can still be told apart
+ * while the image is a lot smaller than its ascii version.
+ *
+ *  @param maze It's the matrix representing the maze in it's current state.
+ *  @param size Represents the length of each maze's side.
+ */
+std::string generate_pgm_maze(Maze &maze, int &size) {
+    bool parallelize = render_in_parallel(size);
+    std::string header = "P5\n" + std::to_string(size) + " " + std::to_string(size) + "\n255\n";
+
+    std::string pgm_maze(header.size() + static_cast<size_t>(size) * size, '\0');
+    std::memcpy(pgm_maze.data(), header.data(), header.size());
+    #pragma omp parallel for if(parallelize)
+    for(int row = 0; row < size; row++) {
+        char *output = pgm_maze.data() + header.size() + static_cast<size_t>(row) * size;
+        for(int col = 0; col < size; col++)
+            output[col] = static_cast<char>(GRAY_LEVELS[maze(row, col)]);
+    }
+
+    return pgm_maze;
+}
+
+
+/**
+ * Generates a binary PBM image of the maze's inner structure.
+ *
+ * Each cell becomes a single bit, set for the walls, so only the maze's structure is drawn. Each row is padded to a
+ * whole byte, as required by the format.
+ *
+ *  @param maze It's the matrix representing the maze in it's current state.
+ *  @param size Represents the length of each maze's side.
+ */
+std::string generate_pbm_maze(Maze &maze, int &size) {
+    bool parallelize = render_in_parallel(size);
+    std::string header = "P4\n" + std::to_string(size) + " " + std::to_string(size) + "\n";
+    size_t row_bytes = (static_cast<size_t>(size) + 7) / 8;
+
+    std::string pbm_maze(header.size() + row_bytes * size, '\0');
+    std::memcpy(pbm_maze.data(), header.data(), header.size());
+    #pragma omp parallel for if(parallelize)
+    for(int row = 0; row < size; row++) {
+        auto *output = reinterpret_cast<uint8_t *>(pbm_maze.data() + header.size() + row * row_bytes);
+        for(int col = 0; col < size; col++)
+            output[col >> 3] |= static_cast<uint8_t>((maze(row, col) == MAZE_PATH::WALL) << (7 - (col & 7)));
+    }
+
+    return pbm_maze;
 }
\ No newline at end of file
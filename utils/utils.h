@@ -3,14 +3,49 @@
 #ifndef RANDOMMAZESOLVER_UTILS_H
 #define RANDOMMAZESOLVER_UTILS_H
 
+#include <chrono>
 #include <json.hpp>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
 
-#include "../sequential/maze/maze_generation.h"
+#include "maze/maze.h"
+#include "phase_timings.h"
 
+// ENUMS AND STRUCTS
 
-nlohmann::json parse_configuration(const std::filesystem::path& project_folder);
+/// Supported formats for the saved mazes' images.
+enum IMAGE_FORMAT {
+    TXT = 0,
+    PGM = 1,
+    PBM = 2,
+    // No image is saved, so the solution doesn't need to be painted
+    NO_IMAGE = 3,
+};
+
+
+/// Memory used to render the ascii images, kept by the callers that render many of them.
+struct AsciiBuffer {
+    std::string image;
+    // Offset of each row inside the image
+    std::vector<size_t> row_offsets;
+};
+
+
+nlohmann::json parse_configuration(const std::filesystem::path& project_folder, const std::string &file_name = "default.json");
 std::filesystem::path find_project_path();
-void display_ascii_maze(std::vector<std::vector<MAZE_PATH>> &maze, int &size, bool show_steps);
-std::string generate_ascii_maze(std::vector<std::vector<MAZE_PATH>> &maze, int &size);
+std::ostream &execution_output();
+void set_execution_output(std::ostream *output);
+void print_carving_rate(long n_cells, std::chrono::steady_clock::time_point start_ts);
+void display_ascii_maze(Maze &maze, int &size, bool show_steps);
+void display_ascii_maze(Maze &maze, int &size, bool show_steps, PhaseTimings &timings);
+void display_ascii_maze(Maze &maze, int &size, bool show_steps, PhaseTimings &timings, AsciiBuffer &buffer);
+bool render_in_parallel(int size);
+std::string generate_ascii_maze(Maze &maze, int &size);
+const std::string &generate_ascii_maze(Maze &maze, int &size, AsciiBuffer &buffer);
+std::string_view ascii_glyph(MAZE_PATH path);
+std::string generate_pgm_maze(Maze &maze, int &size);
+std::string generate_pbm_maze(Maze &maze, int &size);
 
 #endif //RANDOMMAZESOLVER_UTILS_H
\ No newline at end of file